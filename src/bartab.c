@@ -5,7 +5,6 @@
 #include <gtk/gtk.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include <rtfilter.h>
 #include "bargraph.h"
 #include "signaltab.h"
 #include "misc.h"
@@ -55,23 +54,18 @@ char* object_list[] = {
 
 struct bartab {
 	struct signaltab tab;
-	float *data, *tmpdata;
+	float *data;
 	unsigned int nselch, nch1;
-	unsigned int chunkns;
 	unsigned int* selch;
 	char** labels;
 
-	hfilter filt;
 	gdouble cutoff;
 	gboolean filt_on;
-	int reset_filter;
 
 	Bargraph *bar1, *bar2;
 	GObject* widgets[NUM_BARTAB_WIDGETS];
 };
 
-#define CHUNKLEN	0.1 // in seconds
-
 #define get_bartab(p) \
 	((struct bartab*)(((char*)(p))-offsetof(struct bartab, tab)))
 
@@ -85,12 +79,9 @@ static
 void init_buffers(struct bartab* brtab)
 {
 	unsigned int nch = brtab->tab.nch;
-	unsigned int chunkns = brtab->chunkns;
 	unsigned int nch1 = brtab->nch1;
 	g_free(brtab->data);
-	g_free(brtab->tmpdata);
 	brtab->data = g_malloc0(nch*sizeof(*(brtab->data)));
-	brtab->tmpdata = g_malloc(chunkns*nch*sizeof(*(brtab->data)));
 	bargraph_set_data(brtab->bar1, brtab->data, nch1);
 	bargraph_set_data(brtab->bar2, brtab->data+nch1, brtab->nselch-nch1);
 }
@@ -99,15 +90,14 @@ void init_buffers(struct bartab* brtab)
 static
 void init_filter(struct bartab* brtab)
 {
-	double fc = brtab->cutoff / (double)brtab->tab.fs;
-	rtf_destroy_filter(brtab->filt);
-	if (brtab->filt_on)
-		brtab->filt = rtf_create_butterworth(brtab->tab.nch,
-			                                 RTF_FLOAT, fc, 2,
-		                                         0);
-	else
-		brtab->filt = NULL;
-	brtab->reset_filter = 1;
+	struct filter_spec spec = {
+		.type = FILTER_LOWPASS,
+		.order = 2,
+		.freq = brtab->cutoff,
+	};
+
+	// The filter is run by the source of the tab
+	signaltab_set_filter_chain(&brtab->tab, brtab->filt_on ? 1 : 0, &spec);
 }
 
 
@@ -219,10 +209,7 @@ void bartab_filter_button_cb(GtkButton* button, gpointer user_data)
 		brtab->filt_on = s;
 	}
 
-	// TODO lock mutex here
-	g_mutex_lock(&brtab->tab.datlock);
 	init_filter(brtab);
-	g_mutex_unlock(&brtab->tab.datlock);
 }
 
 
@@ -315,6 +302,7 @@ int find_widgets(struct bartab* brtab, GtkBuilder* builder)
 
 	brtab->bar1 = BARGRAPH(brtab->widgets[TAB_BAR1]);
 	brtab->bar2 = BARGRAPH(brtab->widgets[TAB_BAR2]);
+	brtab->tab.plot = GTK_WIDGET(brtab->bar1);
 	brtab->tab.widget = GTK_WIDGET(brtab->widgets[TAB_ROOT]);
 	brtab->tab.scale_combo = GTK_COMBO_BOX(brtab->widgets[SCALE_COMBO]);
 	return 0;
@@ -375,7 +363,6 @@ void bartab_destroy(struct signaltab* tab)
 
 	g_strfreev(brtab->labels);
 	g_free(brtab->data);
-	g_free(brtab->tmpdata);
 	g_free(brtab);
 }
 
@@ -390,11 +377,10 @@ void bartab_define_input(struct signaltab* tab, const char** labels)
 
 	g_mutex_unlock(&brtab->tab.datlock);
 	fill_treeview(GTK_TREE_VIEW(brtab->widgets[ELEC_TREEVIEW]), labels);
+	init_filter(brtab);
 	g_mutex_lock(&brtab->tab.datlock);
 
-	brtab->chunkns = (CHUNKLEN * brtab->tab.fs) + 1;
 	init_buffers(brtab);
-	init_filter(brtab);
 }
 
 static
@@ -412,7 +398,6 @@ void bartab_process_data(struct signaltab* tab, unsigned int ns,
                            const float* in)
 {
 	struct bartab* brtab = get_bartab(tab);
-	float* tmp = brtab->tmpdata;
 	unsigned int j;
 	unsigned int *sel = brtab->selch;
 	unsigned int nch = brtab->nselch;
@@ -422,22 +407,7 @@ void bartab_process_data(struct signaltab* tab, unsigned int ns,
 	if (brtab->data == NULL)
 		return;
 
-	// Apply filters
-	if (brtab->filt != NULL) {
-		if (brtab->reset_filter) {
-			rtf_init_filter(brtab->filt, in);
-			brtab->reset_filter = 0;
-		}
-		while (ns > brtab->chunkns) {
-			rtf_filter(brtab->filt, in, tmp, brtab->chunkns);
-			ns -= brtab->chunkns;
-			in += nch * brtab->chunkns;
-		}
-		rtf_filter(brtab->filt, in, tmp, ns);
-		in = tmp;
-	}
-
-	// Copy data of the selected channels
+	// Copy data of the selected channels (already filtered by the source)
 	for (j=0; j<nch; j++) 
 		brtab->data[j] = in[(ns-1)*nmax_ch + sel[j]];
 }
@@ -24,7 +24,7 @@
 #include <memory.h>
 
 static void binary_scope_calculate_drawparameters(const BinaryScope* self);
-static void binary_scope_draw_samples(const BinaryScope* self, unsigned int first, unsigned int last);
+static void binary_scope_rasterize(PlotArea* area);
 static gboolean binary_scope_expose_event_callback(BinaryScope *self, GdkEventExpose *event, gpointer data);
 static gboolean binary_scope_configure_event_callback(BinaryScope *self, GdkEventConfigure *event, gpointer data);
 
@@ -80,6 +80,7 @@ void binary_scope_class_init (BinaryScopeClass *klass)
 /*	object_class->get_property = binary_scope_get_property;
 	object_class->set_property = binary_scope_set_property;*/
 	object_class->finalize = binary_scope_finalize;
+	PLOT_AREA_CLASS(klass)->rasterize = binary_scope_rasterize;
 }
 
 
@@ -120,7 +121,10 @@ gboolean binary_scope_configure_event_callback(BinaryScope *self,
 	(void)event;
 	(void)data;
 
+	plot_area_lock_raster(PLOT_AREA(self));
 	binary_scope_calculate_drawparameters (self);
+	plot_area_unlock_raster(PLOT_AREA(self));
+	plot_area_invalidate_backing(PLOT_AREA(self));
 	return TRUE;
 }
 
@@ -130,77 +134,63 @@ gboolean binary_scope_expose_event_callback(BinaryScope *self,
                                             GdkEventExpose *event,
                                             gpointer data)
 {
-	unsigned int first, last, num_points;
-	int xmin, xmax;
-	gint* xcoords = self->xcoords;
 	(void)data;
 	
-	num_points = self->num_points;
-	xmin = event->area.x;
-	xmax = event->area.x + event->area.width;
-
-	if (num_points == 0)
+	if (self->num_points == 0)
 		return TRUE;
 
-	/* Determine which samples should redrawn */
-	first=0;
-	while ((first<num_points-1) && (xcoords[first+1] < xmin))
-		first++;
-
-	last=num_points-1;
-	while ((last>0) && (xcoords[last-1] > xmax))
-		last--;
-
-	/* Redraw the region */
-	binary_scope_draw_samples(self, first, last);
+	plot_area_blit_backing(PLOT_AREA(self), event->region);
+	plot_area_draw_cursor(PLOT_AREA(self));
 
 	return TRUE;
 }
 
 
 
+/**
+ * binary_scope_raster_samples() - render a range of samples
+ * @self:       binary scope
+ * @first:      index of the first sample to render
+ * @last:       index of the last sample to render
+ *
+ * Must be called with the raster lock held.
+ */
 static
-void binary_scope_draw_samples(const BinaryScope* self, unsigned int first,
-                                                        unsigned int last)
+void binary_scope_raster_samples(BinaryScope* self, unsigned int first,
+                                 unsigned int last)
 {
-	unsigned int i, iChannel, iSample, iColor;
+	PlotArea* area = PLOT_AREA(self);
+	struct raster* r = &area->raster;
+	unsigned int i, iChannel, iSample;
 	gint xmin, xmax;
-	guint32 channelMask;
+	guint32 channelMask, color;
 	int bScanning;
-	GdkGC* plotgc = PLOT_AREA(self)->plotgc;
-	GdkGC* stategc = GTK_WIDGET(self)->style->fg_gc[gtk_widget_get_state(GTK_WIDGET(self))];
-	GdkWindow* window = GTK_WIDGET(self)->window;
 
-	const GdkColor* grid_color = &(PLOT_AREA(self)->grid_color);
-	const GdkColor* colors = PLOT_AREA(self)->colors;
 	const gint* offsets = self->offsets; 
 	const guint32* values = self->data; 
 	const gint* xcoords = self->xcoords;
-	const guint nColors = PLOT_AREA(self)->nColors;
-	const gint* xticks = PLOT_AREA(self)->xticks;
-	const guint height = GTK_WIDGET(self)->allocation.height;
+	const gint* xticks = area->xticks;
+	const gint height = area->job_height;
 
 	xmin = xcoords[first];
 	xmax = xcoords[last];
+	raster_fill(r, xmin, 0, xmax, height-1, area->job_bg);
+	plot_area_mark_dirty(area, xmin, xmax);
 	
 	// draw grid
-	gdk_gc_set_foreground(plotgc, grid_color);
 	for (i=0; i<self->num_ticks; i++) {
 		if ((xticks[i]>=xmin) && (xticks[i]<=xmax))
-			gdk_draw_line(window,
-					plotgc,
-					xticks[i],
-					0,
-					xticks[i],
-					height);
+			raster_fill(r, xticks[i], 0, xticks[i], height,
+			            area->job_grid);
 	}
 
+	if (values == NULL)
+		return;
 
 	// Draw the channels data
 	for (iChannel=0; iChannel<self->num_channels; iChannel++) {
 		channelMask = 0x00000001 << iChannel;
-		iColor = iChannel % nColors;
-		gdk_gc_set_foreground(plotgc, colors+iColor);
+		color = area->job_colors[iChannel % area->job_ncolors];
 
 		bScanning = (values[first] & channelMask) ? 1 : 0;
 		iSample = first;
@@ -211,24 +201,42 @@ void binary_scope_draw_samples(const BinaryScope* self, unsigned int first,
 			}
 			if ((!(values[i] & channelMask) || (i==last)) && bScanning) {
 				bScanning = FALSE;
-				gdk_draw_rectangle (window,
-		    		            	plotgc,
-						TRUE,
-						xcoords[iSample],
-						offsets[iChannel],
-						xcoords[i]-xcoords[iSample],
-						offsets[iChannel+1]-offsets[iChannel]);
+				if (xcoords[i] > xcoords[iSample])
+					raster_fill(r, xcoords[iSample],
+					            offsets[iChannel],
+					            xcoords[i] - 1,
+					            offsets[iChannel+1] - 1,
+					            color);
 			}
 		}
 	}
+}
+
+
+/**
+ * binary_scope_rasterize() - render the samples updated since last job
+ * @area:       binary scope whose raster lock is held
+ */
+static
+void binary_scope_rasterize(PlotArea* area)
+{
+	BinaryScope* self = BINARY_SCOPE(area);
+	unsigned int from = area->job_from, to = area->job_to;
+	unsigned int nlast = self->num_points - 1;
+
+	if (self->num_points == 0 || to > nlast)
+		return;
 
-	// Draw the scanline
-	gdk_draw_line(window,
-	               stategc,
-	               xcoords[self->current_pointer],
-	               0,
-	               xcoords[self->current_pointer],
-	               height - 1);
+	if (area->job_full) {
+		binary_scope_raster_samples(self, 0, nlast);
+	} else if (from <= to) {
+		binary_scope_raster_samples(self, from, to);
+	} else {
+		binary_scope_raster_samples(self, from, nlast);
+		binary_scope_raster_samples(self, 0, to);
+	}
+
+	area->raster_cursor = self->xcoords[to];
 }
 
 
@@ -262,46 +270,12 @@ void binary_scope_calculate_drawparameters(const BinaryScope* self)
 LOCAL_FN
 void binary_scope_update_data(BinaryScope* self, guint pointer)
 {
-	int first, last;
-	GdkRectangle rect;
-//	GdkWindow* window;
-//	GdkPoint* points;
-
-	if (!self)
+	if (!self || !self->num_points)
 		return;
 
-	if (pointer < self->current_pointer) {
-		binary_scope_update_data(self, self->num_points-1);
-		self->current_pointer = 0;
-	}
-
-//	window = GTK_WIDGET(self)->window;
-	gint* xcoords  = self->xcoords;
-
-	first = self->current_pointer;
-	last = pointer;
+	// Samples from the previous pointer have been updated
+	plot_area_update_pointer(PLOT_AREA(self), pointer, self->num_points);
 	self->current_pointer = pointer;
-
-//	if (points == NULL)
-//		return;
-
-	if (gtk_widget_is_drawable(GTK_WIDGET(self))) {
-		// Set the region that should be redrawn 
-		rect.y = 0;
-		rect.height = GTK_WIDGET(self)->allocation.height;
-		rect.x = xcoords[first];
-		rect.width = xcoords[last] - rect.x + 1;
-
-		// Repaint
-		gtk_widget_queue_draw_area(GTK_WIDGET(self),
-						rect.x,
-						rect.y,
-						rect.width,
-						rect.height);
-		//gdk_window_begin_paint_rect(window, &rect);
-		//binary_scope_draw_samples(self, first, last);
-		//gdk_window_end_paint(window);
-	}
 }
 
 
@@ -313,8 +287,10 @@ void binary_scope_set_data(BinaryScope* self, guint32* data, guint num_points, g
 	if (!self)
 		return;
 
+	plot_area_lock_raster(PLOT_AREA(self));
 	self->data = data;
 	self->current_pointer = 0;
+	PLOT_AREA(self)->pointer = 0;
 	
 	
 	if (num_points != self->num_points) {
@@ -333,6 +309,9 @@ void binary_scope_set_data(BinaryScope* self, guint32* data, guint num_points, g
 
 	if (has_changed)
 		binary_scope_calculate_drawparameters(self);
+	plot_area_unlock_raster(PLOT_AREA(self));
+
+	plot_area_invalidate_backing(PLOT_AREA(self));
 
 	if (gtk_widget_is_drawable(GTK_WIDGET(self)))
 		gtk_widget_queue_draw(GTK_WIDGET(self));
@@ -342,6 +321,7 @@ void binary_scope_set_data(BinaryScope* self, guint32* data, guint num_points, g
 LOCAL_FN
 void binary_scope_set_ticks(BinaryScope* self, guint num_ticks, guint* ticks)
 {
+	plot_area_lock_raster(PLOT_AREA(self));
 	if (num_ticks != self->num_ticks) {
 		g_free(self->ticks);
 		self->ticks = g_malloc(num_ticks*sizeof(*(self->ticks)));
@@ -351,4 +331,7 @@ void binary_scope_set_ticks(BinaryScope* self, guint num_ticks, guint* ticks)
 
 	memcpy(self->ticks, ticks, num_ticks*sizeof(*(self->ticks)));	
 	binary_scope_calculate_drawparameters(self);
+	plot_area_unlock_raster(PLOT_AREA(self));
+
+	plot_area_invalidate_backing(PLOT_AREA(self));
 }
@@ -0,0 +1,228 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <glib.h>
+#include <math.h>
+#include <string.h>
+
+#include "decimator.h"
+
+/**
+ * DOC: Display decimator
+ *
+ * The decimator reduces the rate of the data to display. It is the
+ * polyphase form of a windowed-sinc lowpass filter followed by a
+ * downsampler: since only one sample out of @factor is kept, only those
+ * are computed, ie the cost per input sample is @ntaps/@factor
+ * multiply-accumulate per channel.
+ *
+ * The input and the last @ntaps-1 samples of the previous input are kept
+ * contiguous in @work. @skip is the number of input samples still to be
+ * consumed before the next output.
+ */
+
+// Number of taps of the filter per output sample
+#define TAPS_PER_PHASE	8
+// Cutoff frequency relative to the output Nyquist frequency
+#define CUTOFF_RATIO	0.8
+
+
+LOCAL_FN
+void decimator_init(struct decimator* dec)
+{
+	*dec = (struct decimator) {.factor = 1};
+}
+
+
+LOCAL_FN
+void decimator_deinit(struct decimator* dec)
+{
+	g_free(dec->taps);
+	g_free(dec->work);
+	decimator_init(dec);
+}
+
+
+/**
+ * design_taps() - compute the taps of Blackman windowed-sinc lowpass
+ * @taps:       array receiving the @ntaps taps
+ * @ntaps:      number of taps (odd)
+ * @fc:         cutoff frequency normalized by the sampling frequency
+ *
+ * The taps are normalized to get a unit gain in DC.
+ */
+static
+void design_taps(float* taps, unsigned int ntaps, double fc)
+{
+	unsigned int k;
+	double t, w, sum = 0.0;
+	double m = (ntaps - 1) / 2.0;
+
+	for (k = 0; k < ntaps; k++) {
+		t = k - m;
+		w = 0.42 - 0.5*cos(2*M_PI*k/(ntaps-1))
+		    + 0.08*cos(4*M_PI*k/(ntaps-1));
+		taps[k] = w * ((t == 0.0) ? 2*fc : sin(2*M_PI*fc*t)/(M_PI*t));
+		sum += taps[k];
+	}
+
+	for (k = 0; k < ntaps; k++)
+		taps[k] /= sum;
+}
+
+
+/**
+ * decimator_setup() - (re)configure a decimator
+ * @dec:        initialized decimator
+ * @factor:     decimation factor (1 to disable the decimation)
+ * @nch:        number of channels
+ * @maxns:      maximal number of input samples passed at once
+ *
+ * The history of the filter is cleared.
+ */
+LOCAL_FN
+void decimator_setup(struct decimator* dec, unsigned int factor,
+                     unsigned int nch, unsigned int maxns)
+{
+	decimator_deinit(dec);
+
+	dec->factor = factor ? factor : 1;
+	dec->nch = nch;
+	dec->maxns = maxns;
+	dec->skip = dec->factor;
+	if (dec->factor == 1)
+		return;
+
+	dec->ntaps = TAPS_PER_PHASE*dec->factor + 1;
+	dec->taps = g_malloc(dec->ntaps*sizeof(*dec->taps));
+	dec->work = g_malloc0((dec->ntaps-1 + maxns)*nch*sizeof(*dec->work));
+	design_taps(dec->taps, dec->ntaps, 0.5*CUTOFF_RATIO/dec->factor);
+}
+
+
+/**
+ * decimator_get_input() - get where the next input must be written
+ * @dec:        decimator whose factor is greater than 1
+ *
+ * Return: pointer to an array of @dec->maxns samples of @dec->nch
+ * channels.
+ */
+LOCAL_FN
+float* decimator_get_input(struct decimator* dec)
+{
+	return dec->work + (dec->ntaps-1)*dec->nch;
+}
+
+
+/**
+ * decimator_num_output() - number of output samples for an input
+ * @dec:        decimator
+ * @ns:         number of input samples
+ *
+ * Return: the number of samples output by decimator_run() for @ns input
+ * samples.
+ */
+LOCAL_FN
+unsigned int decimator_num_output(const struct decimator* dec,
+                                  unsigned int ns)
+{
+	if (ns < dec->skip)
+		return 0;
+
+	return (ns - dec->skip) / dec->factor + 1;
+}
+
+
+/**
+ * decimator_delay() - group delay of a decimator
+ * @dec:        decimator
+ *
+ * The filter is symmetric, hence an output sample is centered on the input
+ * sample half the length of the filter before the last one it uses.
+ *
+ * Return: the delay of the output in number of input samples
+ */
+LOCAL_FN
+unsigned int decimator_delay(const struct decimator* dec)
+{
+	return (dec->factor > 1) ? (dec->ntaps - 1) / 2 : 0;
+}
+
+
+/**
+ * decimator_run() - compute the output for some channels
+ * @dec:        decimator
+ * @ns:         number of samples written in the input
+ * @out:        array receiving the output samples (interleaved with
+ *              @dec->nch channels)
+ * @j0:         first channel to compute
+ * @j1:         channel after the last to compute
+ *
+ * The channels are independent, hence disjoint ranges can be computed
+ * concurrently. The state of the decimator is not modified: once all
+ * channels are done, decimator_advance() must be called.
+ */
+LOCAL_FN
+void decimator_run(const struct decimator* dec, unsigned int ns,
+                   float* restrict out, unsigned int j0, unsigned int j1)
+{
+	unsigned int i, j, k, m, nch = dec->nch;
+	unsigned int nout = decimator_num_output(dec, ns);
+	const float* restrict x;
+	const float* restrict h = dec->taps;
+	float* restrict y;
+
+	for (m = 0; m < nout; m++) {
+		// index of the input sample in the chunk
+		i = dec->skip - 1 + m*dec->factor;
+
+		// The filter is symmetric: no need to reverse the taps
+		x = dec->work + i*nch;
+		y = out + m*nch;
+		for (j = j0; j < j1; j++)
+			y[j] = 0.0f;
+
+		for (k = 0; k < dec->ntaps; k++)
+			for (j = j0; j < j1; j++)
+				y[j] += h[k] * x[k*nch + j];
+	}
+}
+
+
+/**
+ * decimator_advance() - consume the input of a decimator
+ * @dec:        decimator
+ * @ns:         number of samples written in the input
+ */
+LOCAL_FN
+void decimator_advance(struct decimator* dec, unsigned int ns)
+{
+	unsigned int nch = dec->nch, nhist = dec->ntaps-1;
+	unsigned int nout = decimator_num_output(dec, ns);
+
+	if (nout)
+		dec->skip += nout*dec->factor - ns;
+	else
+		dec->skip -= ns;
+
+	// Keep the last samples as history of the next input
+	memmove(dec->work, dec->work + ns*nch, nhist*nch*sizeof(*dec->work));
+}
@@ -0,0 +1,46 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+/* Lowpass FIR filter computing only one output every @factor input
+ * samples. The input is written right after the history of the filter in
+ * @work, hence no copy of the input is needed. */
+struct decimator {
+	unsigned int factor;
+	unsigned int ntaps;
+	unsigned int nch;
+	unsigned int maxns;
+	unsigned int skip;
+	float* taps;
+	float* work;
+};
+
+LOCAL_FN void decimator_init(struct decimator* dec);
+LOCAL_FN void decimator_deinit(struct decimator* dec);
+LOCAL_FN void decimator_setup(struct decimator* dec, unsigned int factor,
+                              unsigned int nch, unsigned int maxns);
+LOCAL_FN float* decimator_get_input(struct decimator* dec);
+LOCAL_FN unsigned int decimator_num_output(const struct decimator* dec,
+                                           unsigned int ns);
+LOCAL_FN unsigned int decimator_delay(const struct decimator* dec);
+LOCAL_FN void decimator_run(const struct decimator* dec, unsigned int ns,
+                            float* out, unsigned int j0, unsigned int j1);
+LOCAL_FN void decimator_advance(struct decimator* dec, unsigned int ns);
+
+#endif /* DECIMATOR_H */
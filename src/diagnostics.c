@@ -0,0 +1,176 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gtk/gtk.h>
+
+#include "mcpanel.h"
+#include "mcp_shared.h"
+#include "diagnostics.h"
+
+/**
+ * DOC: Diagnostics window
+ *
+ * The performance counters of a panel (see mcp_get_stats()) can be shown
+ * in a window that is hidden by default. It is toggled by Ctrl+Shift+D in
+ * the panel window, and refreshed every DIAG_REFRESH_INTERVAL while shown.
+ */
+
+#define DIAG_REFRESH_INTERVAL	1000	// in ms
+
+
+static
+void append_timing(GString* str, const char* name,
+                   const struct mcp_timing* t)
+{
+	g_string_append_printf(str,
+	                       "  %-16s %8lu %10.1f %10.1f %10.1f %10.1f\n",
+	                       name, t->count, t->mean, t->p50, t->p99,
+	                       t->max);
+}
+
+
+static
+void diagnostics_fill(mcpanel* pan)
+{
+	GString* str = g_string_new(NULL);
+	int i, ntab = pan->ntab;
+	struct mcp_stats stats;
+	struct mcp_tab_stats tabstats[ntab > 0 ? ntab : 1];
+	const struct mcp_tab_stats* ts;
+
+	mcp_get_stats(pan, &stats, ntab, tabstats);
+
+	g_string_append_printf(str, "Quality level: %i\n",
+	                       mcp_get_quality_level(pan));
+	g_string_append_printf(str, "Processing load: %.2f\n\n",
+	                       stats.proc_load);
+	g_string_append_printf(str, "  %-16s %8s %10s %10s %10s %10s\n",
+	                       "(us)", "count", "mean", "p50", "p99", "max");
+
+	g_string_append(str, "Panel\n");
+	append_timing(str, "frame", &stats.frame);
+	append_timing(str, "frame interval", &stats.frame_interval);
+	append_timing(str, "frame jitter", &stats.frame_jitter);
+	append_timing(str, "draw", &stats.draw);
+	append_timing(str, "lock wait", &stats.lock_wait);
+
+	for (i = 0; i < ntab; i++) {
+		ts = &tabstats[i];
+		g_string_append_printf(str, "\nTab %i: %lu samples, %lu dropped\n",
+		                       i, ts->samples_ingested,
+		                       ts->samples_dropped);
+		append_timing(str, "process", &ts->process);
+		append_timing(str, "update", &ts->update);
+		append_timing(str, "draw", &ts->draw);
+		append_timing(str, "lock wait", &ts->lock_wait);
+		append_timing(str, "latency", &ts->latency);
+	}
+
+	gtk_label_set_text(pan->gui.diag_label, str->str);
+	g_string_free(str, TRUE);
+}
+
+
+static
+gboolean diagnostics_refresh_cb(gpointer data)
+{
+	mcpanel* pan = data;
+
+	gdk_threads_enter();
+	diagnostics_fill(pan);
+	gdk_threads_leave();
+
+	return TRUE;
+}
+
+
+static
+void diagnostics_destroyed_cb(GtkWidget* widget, gpointer data)
+{
+	mcpanel* pan = data;
+	(void)widget;
+
+	g_source_remove(pan->gui.diag_timer);
+	pan->gui.diag_timer = 0;
+	pan->gui.diagnostics = NULL;
+	pan->gui.diag_label = NULL;
+}
+
+
+static
+void diagnostics_open(mcpanel* pan)
+{
+	GtkWidget *window, *label;
+	PangoFontDescription* font;
+
+	window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+	gtk_window_set_title(GTK_WINDOW(window), "Panel diagnostics");
+	gtk_window_set_transient_for(GTK_WINDOW(window), pan->gui.window);
+	gtk_window_set_destroy_with_parent(GTK_WINDOW(window), TRUE);
+
+	label = gtk_label_new(NULL);
+	font = pango_font_description_from_string("Monospace");
+	gtk_widget_modify_font(label, font);
+	pango_font_description_free(font);
+	gtk_misc_set_alignment(GTK_MISC(label), 0.0, 0.0);
+	gtk_misc_set_padding(GTK_MISC(label), 6, 6);
+	gtk_container_add(GTK_CONTAINER(window), label);
+
+	pan->gui.diagnostics = window;
+	pan->gui.diag_label = GTK_LABEL(label);
+	pan->gui.diag_timer = g_timeout_add(DIAG_REFRESH_INTERVAL,
+	                                    diagnostics_refresh_cb, pan);
+	g_signal_connect(window, "destroy",
+	                 G_CALLBACK(diagnostics_destroyed_cb), pan);
+
+	diagnostics_fill(pan);
+	gtk_widget_show_all(window);
+}
+
+
+/**
+ * diagnostics_toggle() - show or hide the diagnostics window of a panel
+ * @pan:        panel
+ *
+ * Must be called from the main loop.
+ */
+LOCAL_FN
+void diagnostics_toggle(mcpanel* pan)
+{
+	if (pan->gui.diagnostics)
+		diagnostics_close(pan);
+	else
+		diagnostics_open(pan);
+}
+
+
+/**
+ * diagnostics_close() - hide the diagnostics window of a panel if shown
+ * @pan:        panel
+ *
+ * Must be called from the main loop.
+ */
+LOCAL_FN
+void diagnostics_close(mcpanel* pan)
+{
+	if (pan->gui.diagnostics)
+		gtk_widget_destroy(pan->gui.diagnostics);
+}
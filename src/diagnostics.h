@@ -1,5 +1,5 @@
 /*
-	Copyright (C) 2008-2009 Nicolas Bourdaud <nicolas.bourdaud@epfl.ch>
+    Copyright (C) 2026  MindMaze Holdings SA
 
     This file is part of the mcpanel library
 
@@ -15,34 +15,12 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
-#include "filter.h"
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
 
-#define NCHANN	1
-#define NSAMPLE	1
-#define NITER 10000
+#include "mcpanel.h"
 
+LOCAL_FN void diagnostics_toggle(mcpanel* pan);
+LOCAL_FN void diagnostics_close(mcpanel* pan);
 
-int main(int argc, char* argv[])
-{
-	int i, j, k;
-	dfilter* filt;
-	float buff1[NCHANN*NSAMPLE], buff2[NCHANN*NSAMPLE];
-	volatile float dummy;
-
-	// set signals
-	for (i=0; i<NCHANN; i++)
-		for (j=0; j<NSAMPLE; j++)
-			buff1[j*NCHANN+i] = j;
-
-
-	filt = create_butterworth_filter(0.02, 4, NCHANN, 0);
-	for (k=0; k<NITER; k++) {
-		filter(filt, buff1, buff2, NSAMPLE);
-		for (i=0; i<NCHANN*NSAMPLE; i++) {
-			buff1[i] = dummy = buff2[i];
-		}
-	}
-
-
-	return 0;
-}
+#endif /* DIAGNOSTICS_H */
@@ -0,0 +1,185 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "governor.h"
+
+/**
+ * DOC: Quality governor
+ *
+ * When the rendering of the panel cannot keep up with the refresh rate,
+ * the display quality is lowered step by step rather than letting the
+ * main loop fall behind.
+ *
+ * The load is evaluated over periods of GOVERNOR_PERIOD. It is the drawing
+ * load, ie the time spent by the main loop to update the display over the
+ * share of the period allowed to it. The processing load of the sources,
+ * ie the time spent to process their samples over the real time duration
+ * of these samples, is only recorded: the quality levels lower the cost of
+ * the drawing, not the one of the filters and of the processing of the
+ * tabs, hence raising the level could not relieve the processing.
+ *
+ * A load above GOVERNOR_HIGH_LOAD raises the level at the end of the
+ * period. The level is lowered back once the load has been below
+ * GOVERNOR_LOW_LOAD for a number of consecutive periods. Each raise
+ * doubles this number (up to GOVERNOR_MAX_CALM), so that the level does
+ * not oscillate when the headroom only comes from the lowered quality.
+ */
+
+#define GOVERNOR_PERIOD         (G_USEC_PER_SEC/2)
+#define GOVERNOR_HIGH_LOAD      0.9
+#define GOVERNOR_LOW_LOAD       0.5
+#define GOVERNOR_MIN_CALM       4
+#define GOVERNOR_MAX_CALM       64
+
+
+/**
+ * governor_init() - initialize a quality governor
+ * @gov:        governor to initialize
+ * @max_level:  highest level, ie lowest quality
+ * @enabled:    if FALSE, the level stays at 0
+ */
+LOCAL_FN
+void governor_init(struct quality_governor* gov, int max_level,
+                   gboolean enabled)
+{
+	*gov = (struct quality_governor) {
+		.max_level = max_level,
+		.enabled = enabled,
+		.period = GOVERNOR_PERIOD,
+		.period_start = g_get_monotonic_time(),
+		.calm_needed = GOVERNOR_MIN_CALM,
+	};
+}
+
+
+/**
+ * governor_add_draw_time() - account time spent to update the display
+ * @gov:        governor
+ * @duration:   time spent in microseconds
+ *
+ * Must be called from the main loop.
+ */
+LOCAL_FN
+void governor_add_draw_time(struct quality_governor* gov, gint64 duration)
+{
+	gov->draw_busy += duration;
+}
+
+
+/**
+ * governor_period_elapsed() - test whether the load must be evaluated
+ * @gov:        governor
+ * @now:        current monotonic time
+ *
+ * Return: TRUE if the current evaluation period is over
+ */
+LOCAL_FN
+gboolean governor_period_elapsed(struct quality_governor* gov, gint64 now)
+{
+	return (now - gov->period_start >= gov->period);
+}
+
+
+/**
+ * governor_update() - adjust the level to the load of the elapsed period
+ * @gov:        governor
+ * @now:        current monotonic time
+ * @draw_share: fraction of the main loop time allowed to the drawing
+ * @proc_load:  processing load over the period (1.0 when the processing
+ *              takes as long as the real time duration of the data)
+ *
+ * This starts a new evaluation period. @proc_load is recorded for
+ * governor_get_proc_load() but does not affect the level.
+ *
+ * Return: the new level
+ */
+LOCAL_FN
+int governor_update(struct quality_governor* gov, gint64 now,
+                    double draw_share, double proc_load)
+{
+	double load;
+	gint64 elapsed = now - gov->period_start;
+	int level = gov->level;
+
+	load = (double)gov->draw_busy / (draw_share * (double)elapsed);
+	g_atomic_int_set(&gov->proc_load, (gint)(proc_load * 1000.0));
+
+	gov->period_start = now;
+	gov->draw_busy = 0;
+
+	if (!gov->enabled)
+		return level;
+
+	if (load > GOVERNOR_HIGH_LOAD) {
+		gov->calm = 0;
+		if (level < gov->max_level) {
+			level++;
+			gov->calm_needed = MIN(2*gov->calm_needed,
+			                       GOVERNOR_MAX_CALM);
+		}
+	} else if (load < GOVERNOR_LOW_LOAD && level > 0) {
+		if (++gov->calm >= gov->calm_needed) {
+			gov->calm = 0;
+			level--;
+		}
+	} else {
+		gov->calm = 0;
+	}
+
+	if (level == 0)
+		gov->calm_needed = GOVERNOR_MIN_CALM;
+
+	g_atomic_int_set(&gov->level, level);
+	return level;
+}
+
+
+/**
+ * governor_get_level() - get the current quality level
+ * @gov:        governor
+ *
+ * This can be called from any thread.
+ *
+ * Return: the level, 0 being the full quality
+ */
+LOCAL_FN
+int governor_get_level(const struct quality_governor* gov)
+{
+	return g_atomic_int_get(&gov->level);
+}
+
+
+/**
+ * governor_get_proc_load() - get the processing load of the last period
+ * @gov:        governor
+ *
+ * This can be called from any thread.
+ *
+ * Return: the largest processing load of the sources over the last
+ * evaluation period
+ */
+LOCAL_FN
+double governor_get_proc_load(const struct quality_governor* gov)
+{
+	return g_atomic_int_get(&gov->proc_load) / 1000.0;
+}
@@ -0,0 +1,50 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include <glib.h>
+
+/* Adjusts a quality level to the drawing load measured over successive
+ * periods: the level is raised (ie the quality lowered) as soon as a period
+ * is overloaded, and lowered back after enough periods with headroom. The
+ * processing load is recorded in thousandths. */
+struct quality_governor {
+	volatile gint level;
+	volatile gint proc_load;
+	int max_level;
+	gboolean enabled;
+	gint64 period;
+	gint64 period_start;
+	gint64 draw_busy;
+	unsigned int calm;
+	unsigned int calm_needed;
+};
+
+LOCAL_FN void governor_init(struct quality_governor* gov, int max_level,
+                            gboolean enabled);
+LOCAL_FN void governor_add_draw_time(struct quality_governor* gov,
+                                     gint64 duration);
+LOCAL_FN gboolean governor_period_elapsed(struct quality_governor* gov,
+                                          gint64 now);
+LOCAL_FN int governor_update(struct quality_governor* gov, gint64 now,
+                             double draw_share, double proc_load);
+LOCAL_FN int governor_get_level(const struct quality_governor* gov);
+LOCAL_FN double governor_get_proc_load(const struct quality_governor* gov);
+
+#endif /* GOVERNOR_H */
@@ -0,0 +1,714 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <glib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ingest.h"
+
+
+/**
+ * DOC: Sample ingestion ring
+ *
+ * The ingestion ring is a bounded single-producer/single-consumer queue of
+ * frames (one frame holds one sample of every channel). The producer is the
+ * acquisition thread calling mcp_add_samples(), the consumer is the
+ * processing thread of the tab. Neither side takes a lock in the common
+ * case: the positions of both ends are free running counters (wrapping
+ * modulo 2^32) updated atomically, and the capacity is a power of two so
+ * that a counter can be mapped to a frame index by a simple mask.
+ *
+ * The mutex and condition are only used to sleep when the consumer finds
+ * the ring empty or, with OVERFLOW_BLOCK policy, when the producer finds it
+ * full.
+ *
+ * With OVERFLOW_DROP_OLDEST and OVERFLOW_COALESCE policies, the producer
+ * makes room by moving forward the consumer end of the ring with a
+ * compare-and-swap, before overwriting the data. Hence the consumer copies
+ * the frames out of the ring and then commits its read with a
+ * compare-and-swap too: if it fails, the producer has overtaken it during
+ * the copy and the read is simply restarted from the new position.
+ *
+ * Both ends can also work directly in the ring memory. The producer can
+ * get a window of free frames with ingest_ring_acquire() and publish them
+ * with ingest_ring_commit(). The consumer can process frames in place with
+ * ingest_ring_peek() and ingest_ring_release(). While the consumer holds
+ * frames in place (@inplace flag set), the producer must not drop them: it
+ * then waits as with OVERFLOW_BLOCK. The @inplace and @dropping flags are
+ * raised by the consumer and producer respectively before checking the
+ * flag of the other side, so that both cannot proceed at the same time.
+ *
+ * To measure the latency of the display, the producer can record the time
+ * at which the frames have been submitted with ingest_ring_stamp(). The
+ * stamps are queued in a second, much smaller, single-producer/single-
+ * consumer queue along with the position of the end of the frames they
+ * cover. The consumer gets them back with ingest_ring_pop_stamps() once
+ * these frames are consumed. A stamp is simply lost if the queue is full.
+ */
+
+static
+unsigned int round_up_pow2(unsigned int v)
+{
+	unsigned int p = 1;
+
+	while (p < v)
+		p <<= 1;
+
+	return p;
+}
+
+
+static
+void ring_copy_out(struct ingest_ring* ring, guint pos, unsigned int ns,
+                   char* dst)
+{
+	size_t fsz = ring->frame_size;
+	unsigned int idx = pos & (ring->capacity - 1);
+	unsigned int n1 = MIN(ns, ring->capacity - idx);
+
+	memcpy(dst, ring->buffer + idx*fsz, n1*fsz);
+	memcpy(dst + n1*fsz, ring->buffer, (ns-n1)*fsz);
+}
+
+
+/**
+ * ingest_ring_wake() - wake up the other end of the ring if sleeping
+ * @ring:       pointer to initialized ingestion ring
+ *
+ * Must be called after an update of @ring->head or @ring->tail. Since the
+ * sleeping side registers itself in @ring->waiting before checking the ring
+ * state, and all glib atomic operations are full barriers, no wakeup can be
+ * lost.
+ */
+static
+void ingest_ring_wake(struct ingest_ring* ring)
+{
+	if (!g_atomic_int_get(&ring->waiting))
+		return;
+
+	g_mutex_lock(&ring->mtx);
+	g_cond_broadcast(&ring->cond);
+	g_mutex_unlock(&ring->mtx);
+}
+
+
+static
+int ingest_ring_wait_space(struct ingest_ring* ring, unsigned int ns)
+{
+	guint head, tail;
+	int quit;
+
+	g_mutex_lock(&ring->mtx);
+	g_atomic_int_inc(&ring->waiting);
+	while (1) {
+		quit = g_atomic_int_get(&ring->quit);
+		head = g_atomic_int_get(&ring->head);
+		tail = g_atomic_int_get(&ring->tail);
+		if (quit || head - tail + ns <= ring->capacity)
+			break;
+
+		// Dropping frames may have become possible
+		if (g_atomic_int_get(&ring->policy) != OVERFLOW_BLOCK
+		    && !g_atomic_int_get(&ring->inplace))
+			break;
+
+		g_cond_wait(&ring->cond, &ring->mtx);
+	}
+	g_atomic_int_add(&ring->waiting, -1);
+	g_mutex_unlock(&ring->mtx);
+
+	return quit ? -1 : 0;
+}
+
+
+static
+int ingest_ring_wait_data(struct ingest_ring* ring)
+{
+	int quit;
+
+	g_mutex_lock(&ring->mtx);
+	g_atomic_int_inc(&ring->waiting);
+	while (1) {
+		quit = g_atomic_int_get(&ring->quit);
+		if (quit || g_atomic_int_get(&ring->head)
+		            != g_atomic_int_get(&ring->tail))
+			break;
+
+		g_cond_wait(&ring->cond, &ring->mtx);
+	}
+	g_atomic_int_add(&ring->waiting, -1);
+	g_mutex_unlock(&ring->mtx);
+
+	return quit ? -1 : 0;
+}
+
+
+/**
+ * ingest_ring_reserve() - make room for frames to be written
+ * @ring:       pointer to initialized ingestion ring
+ * @ns:         number of frames to write (must not exceed capacity)
+ *
+ * Called by the producer only. According to the overflow policy, it waits
+ * for the consumer or discards the oldest frames not yet consumed.
+ *
+ * Return: 0 if there is room for @ns frames, -1 if the ring is stopped.
+ */
+static
+int ingest_ring_reserve(struct ingest_ring* ring, unsigned int ns)
+{
+	guint head, tail, newtail;
+	gboolean done;
+
+	head = g_atomic_int_get(&ring->head);
+	while (1) {
+		tail = g_atomic_int_get(&ring->tail);
+		if (head - tail + ns <= ring->capacity)
+			return 0;
+
+		switch (g_atomic_int_get(&ring->policy)) {
+		case OVERFLOW_DROP_OLDEST:
+			newtail = head + ns - ring->capacity;
+			break;
+
+		case OVERFLOW_COALESCE:
+			newtail = head;
+			break;
+
+		case OVERFLOW_BLOCK:
+		default:
+			if (ingest_ring_wait_space(ring, ns))
+				return -1;
+			continue;
+		}
+
+		// Frames processed in place by the consumer cannot be dropped
+		g_atomic_int_set(&ring->dropping, 1);
+		if (g_atomic_int_get(&ring->inplace)) {
+			g_atomic_int_set(&ring->dropping, 0);
+			if (ingest_ring_wait_space(ring, ns))
+				return -1;
+			continue;
+		}
+
+		done = g_atomic_int_compare_and_exchange(&ring->tail,
+		                                         (gint)tail,
+		                                         (gint)newtail);
+		g_atomic_int_set(&ring->dropping, 0);
+		if (done) {
+			g_atomic_int_add(&ring->dropped, newtail - tail);
+			return 0;
+		}
+	}
+}
+
+
+/**
+ * ingest_ring_init() - initialize an ingestion ring
+ * @ring:       pointer to uninitialized ingestion ring
+ * @frame_size: size in bytes of one frame
+ * @capacity:   minimal number of frames the ring must be able to hold
+ * @policy:     behavior when a write is attempted on a full ring
+ *
+ * The actual capacity is @capacity rounded up to the next power of two. A
+ * @capacity of 0 creates an empty ring on which write are ignored, which
+ * can be resized later with ingest_ring_resize().
+ */
+LOCAL_FN
+void ingest_ring_init(struct ingest_ring* ring, unsigned int frame_size,
+                      unsigned int capacity, enum overflow_policy policy)
+{
+	*ring = (struct ingest_ring) {.policy = policy};
+	g_mutex_init(&ring->mtx);
+	g_cond_init(&ring->cond);
+
+	ingest_ring_resize(ring, frame_size, capacity);
+}
+
+
+/**
+ * ingest_ring_deinit() - cleanup an ingestion ring
+ * @ring:       pointer to initialized ingestion ring
+ */
+LOCAL_FN
+void ingest_ring_deinit(struct ingest_ring* ring)
+{
+	g_free(ring->buffer);
+	g_mutex_clear(&ring->mtx);
+	g_cond_clear(&ring->cond);
+}
+
+
+/**
+ * ingest_ring_resize() - change the geometry of an ingestion ring
+ * @ring:       pointer to initialized ingestion ring
+ * @frame_size: size in bytes of one frame
+ * @capacity:   minimal number of frames the ring must be able to hold
+ *
+ * Any frame not yet consumed is discarded, the dropped counter is reset and
+ * the ring is restarted if it has been stopped. Neither the producer nor the
+ * consumer must access @ring during the call.
+ */
+LOCAL_FN
+void ingest_ring_resize(struct ingest_ring* ring, unsigned int frame_size,
+                        unsigned int capacity)
+{
+	capacity = capacity ? round_up_pow2(capacity) : 0;
+
+	g_free(ring->buffer);
+	ring->buffer = g_malloc((gsize)capacity * frame_size);
+	ring->frame_size = frame_size;
+	ring->capacity = capacity;
+
+	g_atomic_int_set(&ring->head, 0);
+	g_atomic_int_set(&ring->tail, 0);
+	g_atomic_int_set(&ring->dropped, 0);
+	g_atomic_int_set(&ring->quit, 0);
+	g_atomic_int_set(&ring->inplace, 0);
+	g_atomic_int_set(&ring->dropping, 0);
+	g_atomic_int_set(&ring->stamp_head, 0);
+	g_atomic_int_set(&ring->stamp_tail, 0);
+}
+
+
+/**
+ * ingest_ring_stop() - wake up and stop both ends of an ingestion ring
+ * @ring:       pointer to initialized ingestion ring
+ *
+ * After this call, ingest_ring_read() returns 0 as soon as the ring is
+ * empty and ingest_ring_write() no longer blocks.
+ */
+LOCAL_FN
+void ingest_ring_stop(struct ingest_ring* ring)
+{
+	g_mutex_lock(&ring->mtx);
+	g_atomic_int_set(&ring->quit, 1);
+	g_cond_broadcast(&ring->cond);
+	g_mutex_unlock(&ring->mtx);
+}
+
+
+LOCAL_FN
+void ingest_ring_set_policy(struct ingest_ring* ring,
+                            enum overflow_policy policy)
+{
+	g_atomic_int_set(&ring->policy, policy);
+
+	// A producer blocked on a full ring must reconsider its options
+	g_mutex_lock(&ring->mtx);
+	g_cond_broadcast(&ring->cond);
+	g_mutex_unlock(&ring->mtx);
+}
+
+
+LOCAL_FN
+unsigned int ingest_ring_get_dropped(struct ingest_ring* ring)
+{
+	return g_atomic_int_get(&ring->dropped);
+}
+
+
+/**
+ * ingest_ring_acquire() - get a window of free frames in an ingestion ring
+ * @ring:       pointer to initialized ingestion ring
+ * @ns:         number of frames requested
+ * @span:       array receiving the start of the 2 spans of the window
+ * @span_ns:    array receiving the number of frames in each span
+ *
+ * Called by the producer only. This makes room for @ns frames (clipped to
+ * the ring capacity) according to the overflow policy, and reports where
+ * they must be written. The window is split in 2 spans when it wraps at
+ * the end of the ring buffer, otherwise the second span is empty. The
+ * frames are made available to the consumer by ingest_ring_commit().
+ *
+ * Return: the number of frames in the window, 0 if the ring is stopped or
+ * has no storage.
+ */
+LOCAL_FN
+unsigned int ingest_ring_acquire(struct ingest_ring* ring, unsigned int ns,
+                                 void* span[2], unsigned int span_ns[2])
+{
+	size_t fsz = ring->frame_size;
+	unsigned int idx;
+	guint head;
+
+	span[0] = span[1] = NULL;
+	span_ns[0] = span_ns[1] = 0;
+
+	ns = MIN(ns, ring->capacity);
+	if (ns == 0 || ingest_ring_reserve(ring, ns))
+		return 0;
+
+	head = g_atomic_int_get(&ring->head);
+	idx = head & (ring->capacity - 1);
+	span_ns[0] = MIN(ns, ring->capacity - idx);
+	span_ns[1] = ns - span_ns[0];
+	span[0] = ring->buffer + idx*fsz;
+	span[1] = ring->buffer;
+
+	return ns;
+}
+
+
+/**
+ * ingest_ring_commit() - publish frames written in the acquired window
+ * @ring:       pointer to initialized ingestion ring
+ * @ns:         number of frames written (at most the size of the window
+ *              returned by the last call to ingest_ring_acquire())
+ */
+LOCAL_FN
+void ingest_ring_commit(struct ingest_ring* ring, unsigned int ns)
+{
+	if (ns == 0)
+		return;
+
+	g_atomic_int_add(&ring->head, ns);
+	ingest_ring_wake(ring);
+}
+
+
+// Number of samples transposed at once when copying planar data
+#define TRANSPOSE_TILE	16
+
+#define TRANSPOSE(type)							\
+do {									\
+	type* restrict d = dst;						\
+	const type* restrict s = src;					\
+	for (i0 = 0; i0 < ns; i0 += TRANSPOSE_TILE) {			\
+		i1 = MIN(i0 + TRANSPOSE_TILE, ns);			\
+		for (j = 0; j < nch; j++)				\
+			for (i = i0; i < i1; i++)			\
+				d[i*nch+j] = s[j*stride+i];		\
+	}								\
+} while (0)
+
+/**
+ * copy_planar() - copy channel-major samples into frames
+ * @dst:        destination frames
+ * @src:        first value to copy of the first channel
+ * @ns:         number of samples to copy
+ * @stride:     number of values between 2 channels in @src
+ * @nch:        number of channels
+ * @ssz:        size of the value of one channel in a sample
+ *
+ * The transposition is done by tiles of samples so that the reads of each
+ * channel are contiguous while the writes stay in cache.
+ */
+static
+void copy_planar(void* restrict dst, const void* restrict src,
+                 unsigned int ns, unsigned int stride,
+                 unsigned int nch, unsigned int ssz)
+{
+	unsigned int i, i0, i1, j;
+
+	switch (ssz) {
+	case 2: TRANSPOSE(uint16_t); break;
+	case 4: TRANSPOSE(uint32_t); break;
+	case 8: TRANSPOSE(uint64_t); break;
+	}
+}
+
+
+/**
+ * ring_write() - queue samples into an ingestion ring
+ * @ring:       pointer to initialized ingestion ring
+ * @ns:         number of frames to write
+ * @data:       samples to write
+ * @ssz:        0 if @data is an array of @ns frames. Otherwise @data is
+ *              planar (the @ns values of the first channel, followed by
+ *              the @ns values of the second, ...) and @ssz is the size of
+ *              a value.
+ */
+static
+void ring_write(struct ingest_ring* ring, unsigned int ns,
+                const void* data, unsigned int ssz)
+{
+	const char* src = data;
+	size_t fsz = ring->frame_size;
+	size_t step = ssz ? ssz : fsz;
+	unsigned int nch = ssz ? fsz / ssz : 0;
+	unsigned int nw, skip, stride = ns;
+	void* span[2];
+	unsigned int span_ns[2];
+
+	if (ring->capacity == 0)
+		return;
+
+	// If the ring is too small, only the most recent frames can be
+	// kept when dropping is allowed
+	if (ns > ring->capacity
+	    && g_atomic_int_get(&ring->policy) != OVERFLOW_BLOCK) {
+		skip = ns - ring->capacity;
+		g_atomic_int_add(&ring->dropped, skip);
+		src += skip*step;
+		ns -= skip;
+	}
+
+	while (ns) {
+		nw = ingest_ring_acquire(ring, ns, span, span_ns);
+		if (nw == 0)
+			return;
+
+		if (ssz) {
+			copy_planar(span[0], src, span_ns[0],
+			            stride, nch, ssz);
+			copy_planar(span[1], src + span_ns[0]*ssz, span_ns[1],
+			            stride, nch, ssz);
+		} else {
+			memcpy(span[0], src, span_ns[0]*fsz);
+			memcpy(span[1], src + span_ns[0]*fsz, span_ns[1]*fsz);
+		}
+		ingest_ring_commit(ring, nw);
+
+		src += nw*step;
+		ns -= nw;
+	}
+}
+
+
+/**
+ * ingest_ring_write() - queue frames into an ingestion ring
+ * @ring:       pointer to initialized ingestion ring
+ * @ns:         number of frames to write
+ * @data:       array of @ns frames
+ *
+ * Called by the producer only. This does not return before all frames have
+ * been written in @ring or dropped according to the overflow policy.
+ */
+LOCAL_FN
+void ingest_ring_write(struct ingest_ring* ring, unsigned int ns,
+                       const void* data)
+{
+	ring_write(ring, ns, data, 0);
+}
+
+
+/**
+ * ingest_ring_write_planar() - queue channel-major samples into a ring
+ * @ring:       pointer to initialized ingestion ring
+ * @ns:         number of frames to write
+ * @data:       the @ns values of the first channel, followed by the @ns
+ *              values of the second channel, ...
+ * @ssz:        size of a value (2, 4 or 8)
+ *
+ * Same as ingest_ring_write() except that the samples are transposed into
+ * frames while being written in the ring: the caller does not need an
+ * intermediate buffer.
+ */
+LOCAL_FN
+void ingest_ring_write_planar(struct ingest_ring* ring, unsigned int ns,
+                              const void* data, unsigned int ssz)
+{
+	ring_write(ring, ns, data, ssz);
+}
+
+
+/**
+ * ingest_ring_read() - dequeue frames from an ingestion ring
+ * @ring:       pointer to initialized ingestion ring
+ * @max_ns:     maximum number of frames to read
+ * @data:       array receiving the frames (at least @max_ns frames long)
+ *
+ * Called by the consumer only. This waits until at least one frame is
+ * available.
+ *
+ * Return: the number of frames copied into @data, 0 if the ring has been
+ * stopped.
+ */
+LOCAL_FN
+unsigned int ingest_ring_read(struct ingest_ring* ring, unsigned int max_ns,
+                              void* data)
+{
+	guint head, tail;
+	unsigned int ns;
+
+	while (1) {
+		tail = g_atomic_int_get(&ring->tail);
+		head = g_atomic_int_get(&ring->head);
+		if (head == tail) {
+			if (ingest_ring_wait_data(ring))
+				return 0;
+			continue;
+		}
+
+		// Producer has dropped frames between the 2 loads
+		if (head - tail > ring->capacity)
+			continue;
+
+		ns = MIN(head - tail, max_ns);
+		ring_copy_out(ring, tail, ns, data);
+
+		if (g_atomic_int_compare_and_exchange(&ring->tail,
+		                                      (gint)tail,
+		                                      (gint)(tail + ns))) {
+			ingest_ring_wake(ring);
+			return ns;
+		}
+	}
+}
+
+
+/**
+ * ingest_ring_peek() - get frames to be processed by the consumer
+ * @ring:       pointer to initialized ingestion ring
+ * @max_ns:     maximum number of frames to get
+ * @buf:        fallback array (at least @max_ns frames long)
+ * @data:       pointer receiving the location of the frames
+ *
+ * Called by the consumer only. This waits until at least one frame is
+ * available. With OVERFLOW_BLOCK policy, *@data points directly to the
+ * frames in the ring memory (which can then be less than the available
+ * frames if they wrap at the end of the buffer). Otherwise the frames are
+ * copied into @buf as ingest_ring_read() does, and *@data is set to @buf.
+ * In both cases, ingest_ring_release() must be called once the frames have
+ * been processed.
+ *
+ * Return: the number of frames pointed by *@data, 0 if the ring has been
+ * stopped.
+ */
+LOCAL_FN
+unsigned int ingest_ring_peek(struct ingest_ring* ring, unsigned int max_ns,
+                              void* buf, const void** data)
+{
+	guint head, tail;
+	unsigned int idx, ns;
+
+	if (g_atomic_int_get(&ring->policy) != OVERFLOW_BLOCK)
+		goto copy;
+
+	while (1) {
+		tail = g_atomic_int_get(&ring->tail);
+		head = g_atomic_int_get(&ring->head);
+		if (head != tail)
+			break;
+
+		if (ingest_ring_wait_data(ring))
+			return 0;
+	}
+
+	g_atomic_int_set(&ring->inplace, 1);
+	if (g_atomic_int_get(&ring->dropping)
+	    || (guint)g_atomic_int_get(&ring->tail) != tail) {
+		g_atomic_int_set(&ring->inplace, 0);
+		ingest_ring_wake(ring);
+		goto copy;
+	}
+
+	idx = tail & (ring->capacity - 1);
+	ns = MIN(head - tail, max_ns);
+	ns = MIN(ns, ring->capacity - idx);
+	*data = ring->buffer + idx*ring->frame_size;
+	return ns;
+
+copy:
+	*data = buf;
+	return ingest_ring_read(ring, max_ns, buf);
+}
+
+
+/**
+ * ingest_ring_release() - terminate the processing of peeked frames
+ * @ring:       pointer to initialized ingestion ring
+ * @ns:         number of frames returned by the last ingest_ring_peek()
+ */
+LOCAL_FN
+void ingest_ring_release(struct ingest_ring* ring, unsigned int ns)
+{
+	// Frames copied out of the ring have already been consumed
+	if (!g_atomic_int_get(&ring->inplace))
+		return;
+
+	g_atomic_int_add(&ring->tail, ns);
+	g_atomic_int_set(&ring->inplace, 0);
+	ingest_ring_wake(ring);
+}
+
+
+/**
+ * ingest_ring_stamp() - record the submission time of the written frames
+ * @ring:       pointer to initialized ingestion ring
+ * @time:       time at which the last written frames have been submitted
+ *              (monotonic, in microseconds)
+ *
+ * Called by the producer only, after the frames have been written or
+ * committed.
+ */
+LOCAL_FN
+void ingest_ring_stamp(struct ingest_ring* ring, gint64 time)
+{
+	guint head, tail;
+	struct ingest_stamp* stamp;
+
+	if (ring->capacity == 0)
+		return;
+
+	head = g_atomic_int_get(&ring->stamp_head);
+	tail = g_atomic_int_get(&ring->stamp_tail);
+	if (head - tail >= INGEST_NSTAMP)
+		return;
+
+	stamp = &ring->stamps[head & (INGEST_NSTAMP-1)];
+	stamp->pos = g_atomic_int_get(&ring->head);
+	stamp->time = time;
+	g_atomic_int_set(&ring->stamp_head, head + 1);
+}
+
+
+/**
+ * ingest_ring_pop_stamps() - get the stamps of the consumed frames
+ * @ring:       pointer to initialized ingestion ring
+ * @ns:         number of frames returned by the last ingest_ring_peek()
+ * @times:      array receiving the submission times
+ * @max_nstamp: length of @times
+ *
+ * Called by the consumer only, between ingest_ring_peek() and
+ * ingest_ring_release(). The stamps of all frames up to the end of the
+ * peeked ones are dequeued, those exceeding @max_nstamp are discarded.
+ *
+ * Return: the number of submission times written in @times
+ */
+LOCAL_FN
+int ingest_ring_pop_stamps(struct ingest_ring* ring, unsigned int ns,
+                           gint64* times, int max_nstamp)
+{
+	guint head, tail, end;
+	struct ingest_stamp* stamp;
+	int n = 0;
+
+	// Frames processed in place are still counted in the ring
+	end = g_atomic_int_get(&ring->tail);
+	if (g_atomic_int_get(&ring->inplace))
+		end += ns;
+
+	head = g_atomic_int_get(&ring->stamp_head);
+	tail = g_atomic_int_get(&ring->stamp_tail);
+	for (; tail != head; tail++) {
+		stamp = &ring->stamps[tail & (INGEST_NSTAMP-1)];
+		if ((gint)(stamp->pos - end) > 0)
+			break;
+
+		if (n < max_nstamp)
+			times[n++] = stamp->time;
+	}
+	g_atomic_int_set(&ring->stamp_tail, tail);
+
+	return n;
+}
@@ -0,0 +1,82 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef INGEST_H
+#define INGEST_H
+
+#include <glib.h>
+#include "mcpanel.h"
+
+// Number of submission time stamps that can be queued in a ring
+#define INGEST_NSTAMP	256
+
+struct ingest_stamp {
+	guint pos;
+	gint64 time;
+};
+
+struct ingest_ring {
+	char* buffer;
+	unsigned int frame_size;
+	unsigned int capacity;
+	volatile gint policy;
+	volatile gint head;
+	volatile gint tail;
+	volatile gint dropped;
+	volatile gint quit;
+	volatile gint waiting;
+	volatile gint inplace;
+	volatile gint dropping;
+	struct ingest_stamp stamps[INGEST_NSTAMP];
+	volatile gint stamp_head;
+	volatile gint stamp_tail;
+	GMutex mtx;
+	GCond cond;
+};
+
+LOCAL_FN void ingest_ring_init(struct ingest_ring* ring,
+                               unsigned int frame_size,
+                               unsigned int capacity,
+                               enum overflow_policy policy);
+LOCAL_FN void ingest_ring_deinit(struct ingest_ring* ring);
+LOCAL_FN void ingest_ring_resize(struct ingest_ring* ring,
+                                 unsigned int frame_size,
+                                 unsigned int capacity);
+LOCAL_FN void ingest_ring_stop(struct ingest_ring* ring);
+LOCAL_FN void ingest_ring_set_policy(struct ingest_ring* ring,
+                                     enum overflow_policy policy);
+LOCAL_FN unsigned int ingest_ring_get_dropped(struct ingest_ring* ring);
+LOCAL_FN void ingest_ring_write(struct ingest_ring* ring, unsigned int ns,
+                                const void* data);
+LOCAL_FN void ingest_ring_write_planar(struct ingest_ring* ring,
+                                       unsigned int ns, const void* data,
+                                       unsigned int ssz);
+LOCAL_FN unsigned int ingest_ring_acquire(struct ingest_ring* ring,
+                                          unsigned int ns, void* span[2],
+                                          unsigned int span_ns[2]);
+LOCAL_FN void ingest_ring_commit(struct ingest_ring* ring, unsigned int ns);
+LOCAL_FN unsigned int ingest_ring_read(struct ingest_ring* ring,
+                                       unsigned int max_ns, void* data);
+LOCAL_FN unsigned int ingest_ring_peek(struct ingest_ring* ring,
+                                       unsigned int max_ns, void* buf,
+                                       const void** data);
+LOCAL_FN void ingest_ring_release(struct ingest_ring* ring, unsigned int ns);
+LOCAL_FN void ingest_ring_stamp(struct ingest_ring* ring, gint64 time);
+LOCAL_FN int ingest_ring_pop_stamps(struct ingest_ring* ring, unsigned int ns,
+                                    gint64* times, int max_nstamp);
+
+#endif /* INGEST_H */
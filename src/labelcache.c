@@ -0,0 +1,185 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <string.h>
+#include <gtk/gtk.h>
+
+#include "labelcache.h"
+
+/* Beyond this number of entries, the cache is emptied before adding a new
+ * label. This bounds the memory used by widgets drawing arbitrary strings
+ * like event codes. */
+#define LABEL_CACHE_MAXLEN	512
+
+struct label_key {
+	int size;
+	const char* text;
+};
+
+struct cached_label {
+	struct label_key key;
+	PangoLayout* layout;
+	int width;
+	int height;
+};
+
+
+static
+guint label_key_hash(gconstpointer data)
+{
+	const struct label_key* key = data;
+
+	return g_str_hash(key->text) ^ (guint)key->size;
+}
+
+
+static
+gboolean label_key_equal(gconstpointer a, gconstpointer b)
+{
+	const struct label_key *ka = a, *kb = b;
+
+	return ka->size == kb->size && strcmp(ka->text, kb->text) == 0;
+}
+
+
+static
+void cached_label_free(gpointer data)
+{
+	struct cached_label* label = data;
+
+	g_object_unref(label->layout);
+	g_free((char*)label->key.text);
+	g_free(label);
+}
+
+
+/**
+ * label_cache_init() - initialize the label cache of a widget
+ * @cache:      cache to initialize
+ * @widget:     widget on which the labels are drawn
+ */
+LOCAL_FN
+void label_cache_init(struct label_cache* cache, GtkWidget* widget)
+{
+	cache->widget = widget;
+	cache->style = NULL;
+	cache->table = g_hash_table_new_full(label_key_hash, label_key_equal,
+	                                     NULL, cached_label_free);
+}
+
+
+LOCAL_FN
+void label_cache_deinit(struct label_cache* cache)
+{
+	if (!cache->table)
+		return;
+
+	if (cache->style)
+		g_object_unref(cache->style);
+	g_hash_table_destroy(cache->table);
+	cache->table = NULL;
+	cache->style = NULL;
+}
+
+
+LOCAL_FN
+void label_cache_clear(struct label_cache* cache)
+{
+	g_hash_table_remove_all(cache->table);
+}
+
+
+/**
+ * label_cache_check_style() - clear the cache if the style has changed
+ * @cache:      label cache of the widget
+ *
+ * A reference on the style for which the layouts have been created is
+ * kept, hence a new style cannot be mistaken for it.
+ */
+static
+void label_cache_check_style(struct label_cache* cache)
+{
+	GtkStyle* style = cache->widget->style;
+
+	if (style == cache->style)
+		return;
+
+	label_cache_clear(cache);
+	if (cache->style)
+		g_object_unref(cache->style);
+	cache->style = style ? g_object_ref(style) : NULL;
+}
+
+
+/**
+ * label_cache_get() - get the layout of a label
+ * @cache:      label cache of the widget
+ * @text:       text of the label
+ * @size:       font size in points
+ * @width:      pointer to the width of the layout in pixels (may be NULL)
+ * @height:     pointer to the height of the layout in pixels (may be NULL)
+ *
+ * The layout is created and measured only the first time the label is
+ * requested. It is owned by the cache and remains valid until the next
+ * call to label_cache_get() or label_cache_clear().
+ *
+ * Return: the layout of the label with the font of the widget at @size
+ */
+LOCAL_FN
+PangoLayout* label_cache_get(struct label_cache* cache, const char* text,
+                             int size, int* width, int* height)
+{
+	struct label_key key = {.size = size, .text = text};
+	struct cached_label* label;
+	PangoContext* context;
+	PangoFontDescription* desc;
+
+	label_cache_check_style(cache);
+	label = g_hash_table_lookup(cache->table, &key);
+	if (!label) {
+		if (g_hash_table_size(cache->table) >= LABEL_CACHE_MAXLEN)
+			label_cache_clear(cache);
+
+		label = g_malloc(sizeof(*label));
+		label->key.size = size;
+		label->key.text = g_strdup(text);
+
+		// Setup pango layout for the font size
+		label->layout = gtk_widget_create_pango_layout(cache->widget,
+		                                               text);
+		context = gtk_widget_get_pango_context(cache->widget);
+		desc = pango_font_description_copy_static(pango_context_get_font_description(context));
+		pango_font_description_set_size(desc, size * PANGO_SCALE);
+		pango_layout_set_font_description(label->layout, desc);
+		pango_font_description_free(desc);
+		pango_layout_get_pixel_size(label->layout,
+		                            &label->width, &label->height);
+
+		g_hash_table_insert(cache->table, &label->key, label);
+	}
+
+	if (width)
+		*width = label->width;
+	if (height)
+		*height = label->height;
+
+	return label->layout;
+}
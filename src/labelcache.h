@@ -0,0 +1,38 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef LABELCACHE_H
+#define LABELCACHE_H
+
+#include <gtk/gtk.h>
+
+/* Pango layouts of the labels drawn by a widget, keyed by text and font
+ * size. The cache is cleared when the style of the widget changes. */
+struct label_cache {
+	GtkWidget* widget;
+	GtkStyle* style;
+	GHashTable* table;
+};
+
+LOCAL_FN void label_cache_init(struct label_cache* cache, GtkWidget* widget);
+LOCAL_FN void label_cache_deinit(struct label_cache* cache);
+LOCAL_FN void label_cache_clear(struct label_cache* cache);
+LOCAL_FN PangoLayout* label_cache_get(struct label_cache* cache,
+                                      const char* text, int size,
+                                      int* width, int* height);
+
+#endif /* LABELCACHE_H */
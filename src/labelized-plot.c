@@ -23,6 +23,9 @@
 #include "labelized-plot.h"
 #include "plot-area.h"
 
+/* Font size of the tick labels in points */
+#define TICK_LABEL_SIZE	6
+
 enum {
 	DUMMY_PROP,
 	XTICK_LABELS,
@@ -98,6 +101,7 @@ labelized_plot_finalize (GObject *object)
 	LabelizedPlot* self = LABELIZED_PLOT(object);
 	g_strfreev(self->xtick_labels);
 	g_strfreev(self->ytick_labels);
+	label_cache_deinit(&self->labels);
 	
 	// Call parent finalize function
 	if (G_OBJECT_CLASS(labelized_plot_parent_class)->finalize)
@@ -157,6 +161,7 @@ labelized_plot_init (LabelizedPlot* self)
 {
 	self->xtick_labels = NULL;
 	self->ytick_labels = NULL;
+	label_cache_init(&self->labels, GTK_WIDGET(self));
 
 	gtk_alignment_set_padding(GTK_ALIGNMENT(self),3,20,30,3);
 	
@@ -186,8 +191,6 @@ gboolean labelized_plot_expose_event_callback(LabelizedPlot *self,
 	(void)data;
 
 	PangoLayout* layout;
-	PangoContext* context;
-	PangoFontDescription* desc;
 	guint num_ticks, num_labels, i, ivalue, jvalue;
 	gint width, height;
 	gchar** labels;
@@ -201,16 +204,9 @@ gboolean labelized_plot_expose_event_callback(LabelizedPlot *self,
 		return TRUE;
 
 	child_alloc = GTK_WIDGET(child)->allocation;
-//	context = gtk_widget_get_pango_context(GTK_WIDGET(self));
-//	layout = pango_layout_new(context);
-	layout = gtk_widget_create_pango_layout(GTK_WIDGET(self), NULL);
-	context = gtk_widget_get_pango_context(GTK_WIDGET(self));
-	desc = pango_font_description_copy_static(pango_context_get_font_description(context));
-	pango_font_description_set_size(desc, 6*PANGO_SCALE);
-	pango_layout_set_font_description(layout, desc);
-
 
-	// Draw vertical axis
+	// Draw vertical axis. If the child shows only a window of its rows,
+	// the first tick is labeled by the label of the first shown row
 	offsets = child->yticks;
 	labels = self->ytick_labels;
 	num_labels = labels ? g_strv_length(labels) : 0;
@@ -223,9 +219,10 @@ gboolean labelized_plot_expose_event_callback(LabelizedPlot *self,
 		gdk_draw_line(window, gc, ivalue-5, jvalue, ivalue, jvalue);
 
 		// Draw label of the channel
-		if (i<num_labels) {
-			pango_layout_set_text(layout, labels[i], -1);
-			pango_layout_get_pixel_size(layout, &width, &height);
+		if (child->first_ytick + i < num_labels) {
+			layout = label_cache_get(&self->labels,
+			                         labels[child->first_ytick + i],
+			                         TICK_LABEL_SIZE, &width, &height);
 			gdk_draw_layout(window, gc, ivalue-8-width, jvalue-height/2, layout);
 		}
 	}
@@ -244,15 +241,12 @@ gboolean labelized_plot_expose_event_callback(LabelizedPlot *self,
 
 		/* Draw label of the channel */
 		if (i<num_labels) {
-			pango_layout_set_text (layout, labels[i] , -1);
-			pango_layout_get_pixel_size(layout, &width, &height);
+			layout = label_cache_get(&self->labels, labels[i],
+			                         TICK_LABEL_SIZE, &width, &height);
 			gdk_draw_layout(window, gc, ivalue-width/2, jvalue+8, layout);
 		}
 	}
 
-	g_object_unref(layout);
-	pango_font_description_free(desc);
-
 	gtk_paint_shadow (GTK_WIDGET(self)->style,
 					  window,
 					  gtk_widget_get_state(GTK_WIDGET(self)),
@@ -21,6 +21,7 @@
 
 #include <glib.h>
 #include <glib-object.h>
+#include "labelcache.h"
 
 
 G_BEGIN_DECLS
@@ -50,6 +51,7 @@ struct _LabelizedPlot
 	gchar** ytick_labels;
 	PangoFontDescription* tick_font_desc;
 	PangoFontDescription* label_font_desc;
+	struct label_cache labels;
 };
 
 struct _LabelizedPlotClass
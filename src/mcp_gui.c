@@ -29,10 +29,27 @@
 #include "mcp_gui.h"
 #include "plotgraph.h"
 #include "signaltab.h"
+#include "diagnostics.h"
 #include "misc.h"
+#include "trace.h"
 
 
-#define REFRESH_INTERVAL	30
+/* Default maximal rate of the redraws (Hz) */
+#define REFRESH_RATE	33.0
+
+/* Default fraction of the redraw period that the update of the tabs may
+ * take in a frame */
+#define FRAME_BUDGET_RATIO	0.5
+
+/* Slow down of the redraws at the MCP_QUALITY_SKIP_FRAMES quality level */
+#define SKIP_FRAMES_DIVIDER	2
+
+/* Number of redraw periods beyond which successive frames are not
+ * accounted in the frame interval statistics */
+#define FRAME_GAP_PERIODS	4
+
+/* Interval between refreshes of the latency label (us) */
+#define LATENCY_LABEL_PERIOD	G_USEC_PER_SEC
 
 
 static
@@ -59,34 +76,302 @@ const LinkWidgetName widget_name_table[] = {
 #define NUM_PANEL_WIDGETS_REGISTERED (sizeof(widget_name_table)/sizeof(widget_name_table[0]))
 
 
+/**
+ * update_displayed_freq() - show the display rate of the current tab
+ * @pan:        panel
+ *
+ * The tabs that display data at a reduced rate report it in their
+ * display_fs field. The rate of the triggers is shown otherwise.
+ */
 static
-gboolean check_redraw_scopes_cb(gpointer user_data)
+void update_displayed_freq(mcpanel* pan)
 {
-	mcpanel* pan = user_data;
-	unsigned int curr, prev, i;
-	GObject** widg = pan->gui.widgets;
+	char tempstr[32];
+	float fs = pan->fs;
+	gint page = gtk_notebook_get_current_page(pan->gui.notebook);
 
-	gdk_threads_enter();
-	// Redraw all the scopes
-	g_mutex_lock(&pan->data_mutex);
+	if (page >= 0 && page < (gint)pan->ntab
+	    && pan->tabs[page]->display_fs > 0.0f)
+		fs = pan->tabs[page]->display_fs;
+
+	if (fs == pan->displayed_fs)
+		return;
+
+	sprintf(tempstr, "%.4g Hz", fs);
+	gtk_label_set_text(GTK_LABEL(pan->gui.widgets[DISPLAYED_FREQ_LABEL]),
+	                   tempstr);
+	pan->displayed_fs = fs;
+}
+
+
+/**
+ * update_displayed_latency() - show the latency of the current tab
+ * @pan:        panel
+ * @now:        current time
+ *
+ * If enabled, the median and 99th percentile of the latency of the
+ * samples drawn by the current tab since the last refresh of the label
+ * are shown every LATENCY_LABEL_PERIOD.
+ */
+static
+void update_displayed_latency(mcpanel* pan, gint64 now)
+{
+	char tempstr[64];
+	struct mcp_timing lat;
+	struct signaltab* tab;
+	gint page = gtk_notebook_get_current_page(pan->gui.notebook);
+
+	if (!pan->gui.latency_label || now < pan->gui.latency_refresh)
+		return;
 
-	curr = pan->current_sample;
-	prev = pan->last_drawn_sample;
+	pan->gui.latency_refresh = now + LATENCY_LABEL_PERIOD;
+	if (page < 0 || page >= (gint)pan->ntab)
+		return;
+
+	tab = pan->tabs[page];
+	perf_timer_get(&tab->recent_latency, &lat);
+	perf_timer_reset(&tab->recent_latency);
+
+	if (lat.count)
+		sprintf(tempstr, "latency: %.1f ms (p99 %.1f ms)",
+		        lat.p50 / 1000.0f, lat.p99 / 1000.0f);
+	else
+		strcpy(tempstr, "latency: -");
+
+	gtk_label_set_text(pan->gui.latency_label, tempstr);
+}
+
+
+/**
+ * tab_is_shown() - test whether a tab is visible on screen
+ * @pan:        panel
+ * @i:          index of the tab
+ *
+ * Only the tab in the current notebook page is visible, and none is if the
+ * window is iconified or hidden.
+ */
+static
+gboolean tab_is_shown(mcpanel* pan, unsigned int i)
+{
+	return !pan->gui.iconified
+	       && gtk_notebook_get_current_page(pan->gui.notebook) == (gint)i;
+}
+
+
+/**
+ * tab_update_interval() - get the minimal time between updates of a tab
+ * @pan:        panel
+ * @tab:        tab
+ *
+ * When the quality is lowered, the tab is updated at most once every
+ * rate_divider frames if it has no slower refresh rate of its own.
+ */
+static
+gint64 tab_update_interval(mcpanel* pan, const struct signaltab* tab)
+{
+	if (tab->rate_divider <= 1)
+		return MAX(tab->refresh_interval, 1);
+
+	return MAX(tab->refresh_interval, pan->redraw.interval)
+	       * tab->rate_divider;
+}
+
+
+/**
+ * next_due_tab() - get the tab whose update is the most overdue
+ * @pan:        panel
+ * @now:        current time
+ *
+ * Return: the visible tab with new data whose update is allowed since the
+ * longest time, NULL if none
+ */
+static
+struct signaltab* next_due_tab(mcpanel* pan, gint64 now)
+{
+	struct signaltab *tab, *due = NULL;
+	unsigned int i;
+
+	for (i=0; i<pan->ntab; i++) {
+		tab = pan->tabs[i];
+		if (!g_atomic_int_get(&tab->dirty) || tab->next_update > now
+		    || !tab_is_shown(pan, i))
+			continue;
+
+		if (!due || tab->next_update < due->next_update)
+			due = tab;
+	}
+
+	return due;
+}
+
+
+/**
+ * update_tabs() - update the display of the tabs with new data
+ * @pan:        panel
+ *
+ * A tab is updated only if its refresh interval has elapsed since its
+ * previous update, the most overdue tabs first. Once the time budget of
+ * the frame is spent, the remaining tabs are deferred to the next frame,
+ * where they will come first. A frame is requested for the time at which
+ * the next of the tabs left dirty becomes due.
+ *
+ * The hidden tabs are not updated: they stay dirty until they are shown,
+ * at which point a frame is requested (see mcp_sighandler.c).
+ */
+static
+void update_tabs(mcpanel* pan)
+{
+	struct signaltab* tab;
+	unsigned int i;
+	gint64 now = g_get_monotonic_time();
+	gint64 deadline = now + pan->frame_budget;
+	gint64 next = G_MAXINT64;
+
+	while ((tab = next_due_tab(pan, now))) {
+		if (g_get_monotonic_time() > deadline)
+			break;
+
+		g_atomic_int_set(&tab->dirty, 0);
+		tab->next_update = now + tab_update_interval(pan, tab);
+		signaltab_update_plot(tab);
+	}
+
+	for (i=0; i<pan->ntab; i++) {
+		tab = pan->tabs[i];
+		if (!tab_is_shown(pan, i))
+			signaltab_drop_stamps(tab);
+		else if (g_atomic_int_get(&tab->dirty))
+			next = MIN(next, MAX(tab->next_update, now));
+	}
+
+	if (next != G_MAXINT64)
+		redraw_scheduler_request_at(&pan->redraw, next);
+}
+
+
+/**
+ * update_quality() - adapt the quality of the display to the load
+ * @pan:        panel
+ * @now:        current time
+ *
+ * The load is evaluated periodically from the time spent in the frames,
+ * compared with the share of the main loop time given by the frame budget.
+ * When the quality level changes, the tabs and the redraw rate are
+ * adjusted. The processing load of the sources is taken at the same time,
+ * to be reported in the statistics of the panel.
+ */
+static
+void update_quality(mcpanel* pan, gint64 now)
+{
+	struct quality_governor* gov = &pan->governor;
+	double proc_load = 0.0, draw_share;
+	unsigned int i;
+	int prev, level;
+
+	if (!governor_period_elapsed(gov, now))
+		return;
 
 	for (i=0; i<pan->ntab; i++)
-		signaltab_update_plot(pan->tabs[i]);
-	
-	if (curr != prev) {
-		binary_scope_update_data(pan->gui.tri_scope, curr);
-		g_object_set(widg[CMS_LED], "state",
-		             pan->flags.cms_in_range, NULL);
-		g_object_set(widg[BATTERY_LED], "state",
-		             pan->flags.low_battery, NULL);
-
-		pan->last_drawn_sample = curr;
+		proc_load = MAX(proc_load,
+		                source_take_load(pan->tabs[i]->source));
+
+	draw_share = pan->frame_budget * pan->refresh_rate / G_USEC_PER_SEC;
+	draw_share = MIN(draw_share, 1.0);
+
+	prev = governor_get_level(gov);
+	level = governor_update(gov, now, draw_share, proc_load);
+	if (level == prev)
+		return;
+
+	for (i=0; i<pan->ntab; i++)
+		signaltab_set_quality(pan->tabs[i], level);
+
+	redraw_scheduler_set_rate(&pan->redraw,
+	                          (level >= MCP_QUALITY_SKIP_FRAMES)
+	                          ? pan->refresh_rate / SKIP_FRAMES_DIVIDER
+	                          : pan->refresh_rate);
+}
+
+
+/**
+ * account_frame_start() - update the statistics of the frame intervals
+ * @pan:        panel
+ * @start:      start time of the frame
+ *
+ * The jitter is the difference between the interval preceding the frame
+ * and the previous one.
+ */
+static
+void account_frame_start(mcpanel* pan, gint64 start)
+{
+	gint64 interval = start - pan->last_frame;
+	gboolean continuous;
+
+	continuous = pan->last_frame
+	             && interval <= FRAME_GAP_PERIODS * pan->redraw.interval;
+	if (continuous) {
+		perf_timer_add(&pan->frame_interval, interval);
+		if (pan->last_interval)
+			perf_timer_add(&pan->frame_jitter,
+			               ABS(interval - pan->last_interval));
 	}
 
-	g_mutex_unlock(&pan->data_mutex);
+	pan->last_interval = continuous ? interval : 0;
+	pan->last_frame = start;
+}
+
+
+/**
+ * check_redraw_scopes_cb() - draw a frame of the panel
+ * @user_data:  panel
+ *
+ * Run by the redraw scheduler when tabs or triggers have received data.
+ * Only the tabs marked dirty are updated, and the data mutex is taken
+ * only if triggers have been added. Nothing is drawn while the window is
+ * iconified. The time spent is accounted by the quality governor.
+ */
+static
+void check_redraw_scopes_cb(void* user_data)
+{
+	mcpanel* pan = user_data;
+	unsigned int curr, prev;
+	GObject** widg = pan->gui.widgets;
+	gint64 start, now, span;
+
+	gdk_threads_enter();
+	span = trace_begin();
+	start = g_get_monotonic_time();
+	account_frame_start(pan, start);
+
+	// Redraw the updated scopes
+	update_tabs(pan);
+
+	if (!pan->gui.iconified
+	    && g_atomic_int_compare_and_exchange(&pan->tri_dirty, 1, 0)) {
+		perf_mutex_lock(&pan->data_mutex, &pan->data_lock_wait);
+		curr = pan->current_sample;
+		prev = pan->last_drawn_sample;
+
+		if (curr != prev) {
+			binary_scope_update_data(pan->gui.tri_scope, curr);
+			g_object_set(widg[CMS_LED], "state",
+			             pan->flags.cms_in_range, NULL);
+			g_object_set(widg[BATTERY_LED], "state",
+			             pan->flags.low_battery, NULL);
+
+			pan->last_drawn_sample = curr;
+		}
+		g_mutex_unlock(&pan->data_mutex);
+	}
+
+	update_displayed_freq(pan);
+
+	now = g_get_monotonic_time();
+	update_displayed_latency(pan, now);
+	perf_timer_add(&pan->frame_time, now - start);
+	governor_add_draw_time(&pan->governor, now - start);
+	update_quality(pan, now);
+	trace_end("check_redraw_scopes_cb", span);
 
 	// Run modal dialog
 	if (pan->dialog) {
@@ -94,8 +379,107 @@ gboolean check_redraw_scopes_cb(gpointer user_data)
 		g_mutex_unlock(&pan->dlg_completion_mutex);
 	}
 	gdk_threads_leave();
+}
 
-	return TRUE;
+
+/**
+ * on_expose_start() - start to time the drawing of a window of the panel
+ * @widget:     widget owning the window exposed
+ * @event:      event delivered to @widget
+ * @data:       panel containing @widget
+ *
+ * The "event" signal is emitted before the expose handlers of @widget.
+ *
+ * Return: FALSE to let the handlers process @event
+ */
+static
+gboolean on_expose_start(GtkWidget* widget, GdkEvent* event, gpointer data)
+{
+	mcpanel* pan = data;
+	(void)widget;
+
+	if (event->type == GDK_EXPOSE) {
+		pan->gui.expose_span = trace_begin();
+		pan->gui.expose_start = g_get_monotonic_time();
+	}
+
+	return FALSE;
+}
+
+
+/**
+ * on_expose_end() - account the drawing of a window of the panel
+ * @widget:     widget owning the window exposed
+ * @event:      event delivered to @widget
+ * @data:       panel containing @widget
+ *
+ * The "event-after" signal is emitted once the expose handlers of @widget
+ * are done, whatever they return. The duration of the drawing is accounted
+ * by the tab containing @widget or by the panel, and is traced as a span
+ * named after the type of @widget. When the plot of a tab is drawn with its
+ * latest data, the latency of the samples it shows is accounted.
+ */
+static
+void on_expose_end(GtkWidget* widget, GdkEvent* event, gpointer data)
+{
+	mcpanel* pan = data;
+	struct signaltab* tab;
+	gint64 now;
+
+	if (event->type != GDK_EXPOSE || !pan->gui.expose_start)
+		return;
+
+	now = g_get_monotonic_time();
+	tab = g_object_get_data(G_OBJECT(widget), "mcpanel-tab");
+	perf_timer_add(tab ? &tab->draw_time : &pan->draw_time,
+	               now - pan->gui.expose_start);
+	trace_end(G_OBJECT_TYPE_NAME(widget), pan->gui.expose_span);
+	pan->gui.expose_start = 0;
+
+	if (tab && tab->ndraw_stamp && widget == tab->plot
+	    && plot_area_is_drawn(PLOT_AREA(widget)))
+		signaltab_account_latency(tab, now);
+}
+
+
+struct expose_walk {
+	mcpanel* pan;
+	struct signaltab* tab;
+};
+
+
+/**
+ * time_widget_exposes() - time the drawing of a widget and its children
+ * @widget:     root of the widget tree
+ * @data:       pointer to struct expose_walk holding the panel and the
+ *              tab containing @widget (NULL if none)
+ *
+ * An expose event is delivered to the widget owning the window exposed,
+ * which draws its children without window: only the widgets with a window
+ * are timed, so that no drawing is accounted twice.
+ */
+static
+void time_widget_exposes(GtkWidget* widget, gpointer data)
+{
+	struct expose_walk walk = *(struct expose_walk*)data;
+	unsigned int i;
+
+	for (i=0; i<walk.pan->ntab; i++) {
+		if (widget == walk.pan->tabs[i]->widget)
+			walk.tab = walk.pan->tabs[i];
+	}
+
+	if (gtk_widget_get_has_window(widget)) {
+		g_object_set_data(G_OBJECT(widget), "mcpanel-tab", walk.tab);
+		g_signal_connect(widget, "event",
+		                 G_CALLBACK(on_expose_start), walk.pan);
+		g_signal_connect(widget, "event-after",
+		                 G_CALLBACK(on_expose_end), walk.pan);
+	}
+
+	if (GTK_IS_CONTAINER(widget))
+		gtk_container_forall(GTK_CONTAINER(widget),
+		                     time_widget_exposes, &walk);
 }
 
 
@@ -163,11 +547,13 @@ static
 gboolean blocking_funcall_cb(gpointer data)
 {
 	struct BlockingCallParam* bcprm = data;
+	gint64 span = trace_begin();
 
 	// Run the function
 	gdk_threads_enter();
 	bcprm->retcode = bcprm->func(bcprm->data);
 	gdk_threads_leave();
+	trace_end("blocking_funcall_cb", span);
 
 	// Signal that it is done
 	g_mutex_lock(&bcprm->mtx);
@@ -191,6 +577,8 @@ int run_func_in_guithread(mcpanel* pan, BCProc func, void* data)
 			.data = data,
 			.func = func
 		};
+		gint64 span = trace_begin();
+
 		g_mutex_init(&bcprm.mtx);
 		g_cond_init(&bcprm.cond);
 
@@ -205,6 +593,7 @@ int run_func_in_guithread(mcpanel* pan, BCProc func, void* data)
 		// free sync objects
 		g_mutex_clear(&bcprm.mtx);
 		g_cond_clear(&bcprm.cond);
+		trace_end("run_func_in_guithread", span);
 
 		retcode = bcprm.retcode;
 	} else {
@@ -328,8 +717,8 @@ void update_triggers_gui(mcpanel* pan)
 
 	sprintf(tempstr,"%u Hz",pan->fs);
 	gtk_label_set_text(GTK_LABEL(widg[NATIVE_FREQ_LABEL]), tempstr);
-	sprintf(tempstr,"%u Hz",pan->fs); 
-	gtk_label_set_text(GTK_LABEL(widg[DISPLAYED_FREQ_LABEL]), tempstr);
+	pan->displayed_fs = -1.0f;
+	update_displayed_freq(pan);
 }
 
 
@@ -354,12 +743,20 @@ static
 int add_signal_tabs(mcpanel* pan, const char* uidef, unsigned int ntab,
                     const struct panel_tabconf* tabconf, GKeyFile* keyfile)
 {
-	unsigned int i;
+	unsigned int i, j;
 	GtkNotebook* notebook = pan->gui.notebook;
 	GtkWidget *widget, *label = NULL;
+	const char* srcname;
 	char group[64];
 	struct tabconf conf = {.group = group, .uidef = uidef,
 	                       .keyfile=keyfile};
+	gint nthread = 0;
+
+	// Tabs processing is spread over a pool of DSP threads
+	mcpi_key_get_ival(keyfile, "main", "dsp-threads", &nthread);
+	pan->dsp_pool = worker_pool_create(nthread);
+	conf.pool = pan->dsp_pool;
+	conf.redraw = &pan->redraw;
 
 	pan->ntab = ntab;
 	pan->tabs = g_malloc0(ntab*sizeof(*(pan->tabs)));
@@ -368,7 +765,19 @@ int add_signal_tabs(mcpanel* pan, const char* uidef, unsigned int ntab,
 		conf.sclabels = tabconf[i].sclabels;
 		conf.scales = tabconf[i].scales;
 		conf.type = tabconf[i].type;
+		conf.refresh_rate = tabconf[i].refresh_rate;
 		sprintf(group, "panel%u", i);
+
+		// Attach to the source of a previous tab of the same stream
+		conf.source = NULL;
+		srcname = tabconf[i].source;
+		for (j=0; srcname && j<i; j++) {
+			if (tabconf[j].source
+			    && !strcmp(tabconf[j].source, srcname)) {
+				conf.source = pan->tabs[j]->source;
+				break;
+			}
+		}
 		
 		pan->tabs[i] = create_signaltab(&conf);
 		if (pan->tabs[i] == NULL)
@@ -391,6 +800,8 @@ void destroy_signal_tabs(mcpanel* pan)
 	for (i=0; i<pan->ntab; i++) 
 		signaltab_destroy(pan->tabs[i]);
 	g_free(pan->tabs);
+	worker_pool_destroy(pan->dsp_pool);
+	pan->dsp_pool = NULL;
 }
 
 
@@ -448,6 +859,10 @@ int create_panel_gui(mcpanel* pan, const char* uifile, unsigned int ntab,
 	const char* envpath;
 	char path[256], keyfilepath[256];
 	GKeyFile* keyfile, *kfile = NULL;
+	gdouble refresh_rate = REFRESH_RATE, frame_budget = -1.0;
+	gboolean governed = TRUE, show_latency = FALSE;
+	GObject* label;
+	struct expose_walk walk = {.tab = NULL};
 
 	RegisterCustomDefinition();
 
@@ -485,18 +900,56 @@ int create_panel_gui(mcpanel* pan, const char* uifile, unsigned int ntab,
 	create_custom_buttons(pan, builder);
 
 
+	// Frames are drawn when the tabs request them, at most at the
+	// configured rate
+	mcpi_key_get_dval(kfile, "main", "refresh-rate", &refresh_rate);
+	redraw_scheduler_init(&pan->redraw, refresh_rate,
+	                      check_redraw_scopes_cb, pan);
+	pan->refresh_rate = (double)G_USEC_PER_SEC / pan->redraw.interval;
+
+	// Time allowed to the update of the tabs in a frame (ms)
+	mcpi_key_get_dval(kfile, "main", "frame-budget", &frame_budget);
+	pan->frame_budget = (frame_budget > 0.0)
+	                  ? (gint64)(frame_budget * 1000.0)
+	                  : (gint64)(FRAME_BUDGET_RATIO * pan->redraw.interval);
+
+	// The display quality is lowered if the panel cannot keep up
+	mcpi_key_get_bval(kfile, "main", "quality-governor", &governed);
+	governor_init(&pan->governor, MCP_QUALITY_SKIP_FRAMES, governed);
+
+	// The timeline is traced if a trace file is set
+	envpath = getenv("MCPANEL_TRACE");
+	if (envpath)
+		pan->trace_file = g_strdup(envpath);
+	else if (kfile)
+		pan->trace_file = g_key_file_get_string(kfile, "main",
+		                                        "trace-file", NULL);
+	if (pan->trace_file)
+		trace_enable();
+
 	// Get the pointers of the control widgets
 	if (!poll_widgets(pan, builder)
 	    || !add_signal_tabs(pan, uidef, ntab, tabconf, kfile))
 		goto out;
+
+	// The latency of the current tab is shown on request, if the ui
+	// definition has a place for it
+	mcpi_key_get_bval(kfile, "main", "show-latency", &show_latency);
+	label = gtk_builder_get_object(builder, "latency_label");
+	if (show_latency && label && GTK_IS_LABEL(label)) {
+		pan->gui.latency_label = GTK_LABEL(label);
+		gtk_widget_show(GTK_WIDGET(label));
+	}
+
+	// Account the time taken to draw the panel widgets
+	walk.pan = pan;
+	time_widget_exposes(GTK_WIDGET(pan->gui.window), &walk);
 	
 	mcpi_key_set_combo(keyfile, "main", "time-window",
 	                   GTK_COMBO_BOX(pan->gui.widgets[TIME_WINDOW_COMBO]));
 	initialize_widgets(pan);
 	connect_panel_signals(pan);
 
-	g_timeout_add(REFRESH_INTERVAL, check_redraw_scopes_cb, pan);
-
 	res = 1;
 	pan->builder = builder;
 	
@@ -511,8 +964,10 @@ LOCAL_FN
 void destroy_panel_gui(mcpanel* pan)
 {
 	g_mutex_lock(&pan->gui.syncmtx);
-	if (!pan->gui.is_destroyed)
+	if (!pan->gui.is_destroyed) {
+		diagnostics_close(pan);
 		gtk_widget_destroy(GTK_WIDGET(pan->gui.window));
+	}
 	pan->gui.is_destroyed = 1;
 	g_mutex_unlock(&pan->gui.syncmtx);
 
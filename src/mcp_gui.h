@@ -70,8 +70,16 @@ struct PanelGUI {
 	int is_destroyed;
 	GObject* widgets[NUM_PANEL_WIDGETS_DEFINED];
 	GtkNotebook* notebook;
+	gboolean iconified;
 	BinaryScope *tri_scope;
 	struct custom_button* buttons;
+	GtkWidget* diagnostics;
+	GtkLabel* diag_label;
+	guint diag_timer;
+	GtkLabel* latency_label;
+	gint64 latency_refresh;
+	gint64 expose_start;
+	gint64 expose_span;
 };
 
 
@@ -20,6 +20,9 @@
 
 #include "mcp_gui.h"
 #include "signaltab.h"
+#include "redraw.h"
+#include "governor.h"
+#include "perfstat.h"
 
 typedef struct _Indicators {
 	unsigned int cms_in_range	: 1;
@@ -40,6 +43,22 @@ struct _mcpanel {
 
 	unsigned int ntab;
 	struct signaltab** tabs;
+	struct worker_pool* dsp_pool;
+	struct redraw_scheduler redraw;
+	double refresh_rate;
+	gint64 frame_budget;
+	struct quality_governor governor;
+
+	// Performance counters
+	struct perf_timer frame_time;
+	struct perf_timer frame_interval;
+	struct perf_timer frame_jitter;
+	struct perf_timer draw_time;
+	struct perf_timer data_lock_wait;
+	gint64 last_frame;
+	gint64 last_interval;
+	char* trace_file;
+	volatile gint tri_dirty;
 
 	// states
 	gboolean connected;
@@ -54,6 +73,7 @@ struct _mcpanel {
 	unsigned int nlines_tri;
 	unsigned int num_samples;
 	float display_length;
+	float displayed_fs;
 	unsigned int current_sample;
 	unsigned int last_drawn_sample;
 
@@ -22,8 +22,10 @@
 #include "mcp_shared.h"
 #include "mcp_gui.h"
 #include "mcp_sighandler.h"
+#include "diagnostics.h"
 #include "misc.h"
 #include <gtk/gtk.h>
+#include <gdk/gdkkeysyms.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -181,6 +183,72 @@ void trigg_selch_cb(GtkComboBox* combo, gpointer user_data)
 }
 
 
+/**
+ * window_state_cb() - track whether the panel can be seen
+ * @widget:     top window of the panel
+ * @event:      window state change
+ * @data:       panel
+ *
+ * While the window is iconified or hidden, the display is not updated.
+ * Once it is shown again, the updates that have been skipped are
+ * caught up.
+ */
+static
+gboolean window_state_cb(GtkWidget* widget, GdkEventWindowState* event,
+                         gpointer data)
+{
+	mcpanel* pan = data;
+	gboolean iconified;
+	(void)widget;
+
+	iconified = (event->new_window_state & (GDK_WINDOW_STATE_ICONIFIED
+	                                        | GDK_WINDOW_STATE_WITHDRAWN))
+	            ? TRUE : FALSE;
+	if (iconified == pan->gui.iconified)
+		return FALSE;
+
+	pan->gui.iconified = iconified;
+	if (!iconified) {
+		// The triggers may have been updated more than a full turn
+		plot_area_invalidate_backing(PLOT_AREA(pan->gui.tri_scope));
+		redraw_scheduler_request(&pan->redraw);
+	}
+
+	return FALSE;
+}
+
+
+/* Ctrl+Shift+D toggles the diagnostics window */
+static
+gboolean key_press_cb(GtkWidget* widget, GdkEventKey* event, gpointer data)
+{
+	mcpanel* pan = data;
+	guint mods = event->state & gtk_accelerator_get_default_mod_mask();
+	(void)widget;
+
+	if (mods != (GDK_CONTROL_MASK | GDK_SHIFT_MASK)
+	    || gdk_keyval_to_lower(event->keyval) != GDK_d)
+		return FALSE;
+
+	diagnostics_toggle(pan);
+	return TRUE;
+}
+
+
+static
+void switch_page_cb(GtkNotebook* notebook, gpointer page, guint page_num,
+                    gpointer data)
+{
+	mcpanel* pan = data;
+	(void)notebook;
+	(void)page;
+	(void)page_num;
+
+	// The tab shown may have skipped updates while it was hidden
+	redraw_scheduler_request(&pan->redraw);
+}
+
+
 LOCAL_FN
 void connect_panel_signals(mcpanel* pan)
 {
@@ -198,6 +266,12 @@ void connect_panel_signals(mcpanel* pan)
 
 	g_signal_connect(pan->gui.window, "delete-event",
 	                 (GCallback)on_close_panel, pan);
+	g_signal_connect(pan->gui.window, "window-state-event",
+	                 (GCallback)window_state_cb, pan);
+	g_signal_connect(pan->gui.window, "key-press-event",
+	                 (GCallback)key_press_cb, pan);
+	g_signal_connect_after(pan->gui.notebook, "switch-page",
+	                       (GCallback)switch_page_cb, pan);
 }
 
 
@@ -28,7 +28,9 @@
 #include "mcp_gui.h"
 #include "mcp_shared.h"
 #include "misc.h"
+#include "plot-area.h"
 #include "signaltab.h"
+#include "trace.h"
 #include <string.h>
 
 
@@ -246,6 +248,8 @@ mcpanel* mcp_create(const char* uifilename, const struct PanelCb* cb,
 	pan->trigg_selch = -1;
 
 	// Create the panel widgets according to the ui definition files
+	plot_area_ref_workers();
+	trace_ref();
 	if (!create_panel_gui(pan, uifilename, ntab, tabconf, confname)) {
 		mcp_destroy(pan);
 		return NULL;
@@ -303,7 +307,7 @@ API_EXPORTED
 void mcp_destroy(mcpanel* pan)
 {
 	// Stop refreshing the scopes content
-	g_source_remove_by_user_data(pan);
+	redraw_scheduler_stop(&pan->redraw);
 
 	destroy_panel_gui(pan);
 
@@ -313,6 +317,15 @@ void mcp_destroy(mcpanel* pan)
 	  && (pan->main_loop_thread != g_thread_self()))
 		g_thread_join(pan->main_loop_thread);
 
+	// The processing threads are stopped, no more frame can be requested
+	redraw_scheduler_deinit(&pan->redraw);
+	plot_area_unref_workers();
+
+	if (pan->trace_file)
+		trace_dump(pan->trace_file);
+	g_free(pan->trace_file);
+	trace_unref();
+
 	g_mutex_clear(&pan->data_mutex);
 	//destroy_dataproc(pan);
 	g_free(pan->cb.custom_button);
@@ -364,10 +377,40 @@ API_EXPORTED
 int mcp_define_tab_input(mcpanel* pan, int tabid,
                               unsigned int nch, float fs, 
 			      const char** labels)
+{
+	return mcp_define_tab_input_format(pan, tabid, nch, fs, labels,
+	                                   MCP_FORMAT_FLOAT);
+}
+
+
+/**
+ * mcp_define_tab_input_format() - define the input of a tab
+ * @pan:        panel
+ * @tabid:      index of the tab
+ * @nch:        number of channels
+ * @fs:         sampling frequency (if 0 or less, the one of the panel)
+ * @labels:     labels of the @nch channels
+ * @format:     type of the values of the samples that will be submitted
+ *
+ * Same as mcp_define_tab_input() with samples in a format other than
+ * float. The calibration of the channels is reset. Samples in a format
+ * other than float must be submitted with mcp_add_raw_samples(),
+ * mcp_add_samples_planar() or mcp_acquire_samples().
+ *
+ * Return: 1 in case of success, 0 otherwise
+ */
+API_EXPORTED
+int mcp_define_tab_input_format(mcpanel* pan, int tabid,
+                                unsigned int nch, float fs,
+                                const char** labels,
+                                enum mcp_sample_format format)
 {
 	const char** newlabels = NULL;
 
-	if (tabid < 0 || tabid > (int)pan->ntab)
+	if (tabid < 0 || tabid >= (int)pan->ntab)
+		return 0;
+
+	if (format < MCP_FORMAT_FLOAT || format > MCP_FORMAT_INT32)
 		return 0;
 
 	if (fs <= 0.0f)
@@ -376,7 +419,7 @@ int mcp_define_tab_input(mcpanel* pan, int tabid,
 	newlabels = g_malloc0((nch+1)*sizeof(*labels));
 	memcpy(newlabels, labels, nch*sizeof(*labels));
 
-	signaltab_define_input(pan->tabs[tabid], fs, nch, newlabels);
+	signaltab_define_input(pan->tabs[tabid], fs, nch, newlabels, format);
 
 	g_free(newlabels);
 
@@ -384,13 +427,40 @@ int mcp_define_tab_input(mcpanel* pan, int tabid,
 }
 
 
+/**
+ * mcp_set_tab_calibration() - set the calibration of the channels of a tab
+ * @pan:        panel
+ * @tabid:      index of the tab
+ * @gain:       array of gains of each channel (if NULL, all gains are 1)
+ * @offset:     array of offsets of each channel (if NULL, all offsets are 0)
+ *
+ * The value displayed for a channel is the value submitted converted to
+ * float, multiplied by its gain and to which its offset is added. The
+ * arrays must have as many elements as channels in the input defined for
+ * the tab. The calibration is applied while converting the submitted
+ * samples, hence at no extra cost.
+ *
+ * Return: 1 in case of success, 0 otherwise
+ */
+API_EXPORTED
+int mcp_set_tab_calibration(mcpanel* pan, int tabid,
+                            const float* gain, const float* offset)
+{
+	if (tabid < 0 || tabid >= (int)pan->ntab)
+		return 0;
+
+	signaltab_set_calibration(pan->tabs[tabid], gain, offset);
+	return 1;
+}
+
+
 API_EXPORTED
 int mcp_select_tab_channels(mcpanel* panel, int tabid,
                             int nch, int const * indices)
 {
 	struct signaltab* tab;
 
-	if (tabid < 0 || tabid > (int) panel->ntab)
+	if (tabid < 0 || tabid >= (int)panel->ntab)
 		return -1;
 
 	tab = panel->tabs[tabid];
@@ -401,11 +471,252 @@ int mcp_select_tab_channels(mcpanel* panel, int tabid,
 }
 
 
+/**
+ * mcp_add_samples() - submit float samples to a tab
+ * @pan:        panel
+ * @tabid:      index of the tab
+ * @ns:         number of samples
+ * @data:       @ns samples of all channels, the values of the channels of
+ *              a sample being contiguous
+ *
+ * This may block according to the overflow policy of the tab. The input
+ * of the tab must be in float format: the samples of input defined with
+ * another format by mcp_define_tab_input_format() must be submitted with
+ * mcp_add_raw_samples(), and are rejected here.
+ */
 API_EXPORTED
 void mcp_add_samples(mcpanel* pan, int tabid,
                          unsigned int ns, const float* data)
 {
+	gint64 span;
+
+	if (signaltab_get_format(pan->tabs[tabid]) != MCP_FORMAT_FLOAT) {
+		fprintf(stderr, "mcp_add_samples: input of tab %i is not "
+		                "float, use mcp_add_raw_samples()\n", tabid);
+		return;
+	}
+
+	span = trace_begin();
 	signaltab_add_samples(pan->tabs[tabid], ns, data);
+	trace_end("mcp_add_samples", span);
+}
+
+
+/**
+ * mcp_add_raw_samples() - submit samples in the format of the tab input
+ * @pan:        panel
+ * @tabid:      index of the tab
+ * @ns:         number of samples
+ * @data:       @ns samples of all channels whose values are in the format
+ *              set by mcp_define_tab_input_format()
+ *
+ * Same as mcp_add_samples() for input whose format is not float.
+ */
+API_EXPORTED
+void mcp_add_raw_samples(mcpanel* pan, int tabid,
+                         unsigned int ns, const void* data)
+{
+	gint64 span = trace_begin();
+
+	signaltab_add_samples(pan->tabs[tabid], ns, data);
+	trace_end("mcp_add_raw_samples", span);
+}
+
+
+/**
+ * mcp_add_samples_planar() - submit samples laid out channel by channel
+ * @pan:        panel
+ * @tabid:      index of the tab
+ * @ns:         number of samples
+ * @data:       the @ns values of the first channel, followed by the @ns
+ *              values of the second channel, and so on. The values are in
+ *              the format of the tab input (float by default).
+ *
+ * Same as mcp_add_samples() (or mcp_add_raw_samples()) for channel-major
+ * data. The samples are transposed while being queued, hence the caller
+ * does not need to do it beforehand.
+ */
+API_EXPORTED
+void mcp_add_samples_planar(mcpanel* pan, int tabid,
+                            unsigned int ns, const void* data)
+{
+	gint64 span = trace_begin();
+
+	signaltab_add_samples_planar(pan->tabs[tabid], ns, data);
+	trace_end("mcp_add_samples_planar", span);
+}
+
+
+/**
+ * mcp_acquire_samples() - get a window to write samples of a tab in place
+ * @pan:        panel
+ * @tabid:      index of the tab
+ * @ns:         number of samples to be written
+ * @win:        pointer to window structure receiving the location
+ *
+ * This is the zero-copy alternative to mcp_add_samples(): the samples are
+ * written by the caller directly in the ingestion buffer of the tab
+ * described by @win, and then submitted by mcp_commit_samples(). As
+ * mcp_add_samples(), this may block according to the overflow policy of the
+ * tab. The window may be smaller than @ns if it exceeds the size of the
+ * ingestion buffer.
+ *
+ * Return: the number of samples in the window (0 in case of error)
+ */
+API_EXPORTED
+unsigned int mcp_acquire_samples(mcpanel* pan, int tabid, unsigned int ns,
+                                 struct mcp_write_window* win)
+{
+	if (tabid < 0 || tabid >= (int)pan->ntab)
+		return 0;
+
+	return signaltab_acquire_samples(pan->tabs[tabid], ns, win);
+}
+
+
+/**
+ * mcp_commit_samples() - submit the samples written in acquired window
+ * @pan:        panel
+ * @tabid:      index of the tab
+ * @ns:         number of samples written from the start of the window
+ *              returned by the last call to mcp_acquire_samples()
+ */
+API_EXPORTED
+void mcp_commit_samples(mcpanel* pan, int tabid, unsigned int ns)
+{
+	if (tabid < 0 || tabid >= (int)pan->ntab)
+		return;
+
+	signaltab_commit_samples(pan->tabs[tabid], ns);
+}
+
+
+API_EXPORTED
+int mcp_set_tab_overflow_policy(mcpanel* pan, int tabid,
+                                enum overflow_policy policy)
+{
+	if (tabid < 0 || tabid >= (int)pan->ntab)
+		return -1;
+
+	if (policy < OVERFLOW_BLOCK || policy > OVERFLOW_COALESCE)
+		return -1;
+
+	signaltab_set_overflow_policy(pan->tabs[tabid], policy);
+	return 0;
+}
+
+
+API_EXPORTED
+unsigned int mcp_get_tab_dropped_samples(mcpanel* pan, int tabid)
+{
+	if (tabid < 0 || tabid >= (int)pan->ntab)
+		return 0;
+
+	return signaltab_get_dropped(pan->tabs[tabid]);
+}
+
+
+/**
+ * mcp_get_quality_level() - get the current quality of the display
+ * @pan:        panel
+ *
+ * This can be called from any thread.
+ *
+ * Return: the quality level, lowered when the panel cannot keep up with
+ * real time
+ */
+API_EXPORTED
+enum mcp_quality_level mcp_get_quality_level(mcpanel* pan)
+{
+	return governor_get_level(&pan->governor);
+}
+
+
+/**
+ * mcp_get_stats() - get the performance counters of a panel
+ * @pan:        panel
+ * @stats:      structure receiving the counters of the panel (may be NULL)
+ * @ntab:       number of elements in @tabstats
+ * @tabstats:   array receiving the counters of the first @ntab tabs (may
+ *              be NULL)
+ *
+ * The counters accumulate since the creation of the panel or the last call
+ * to mcp_reset_stats(). This can be called from any thread, at a low
+ * cost.
+ *
+ * Return: the number of tabs of the panel
+ */
+API_EXPORTED
+int mcp_get_stats(mcpanel* pan, struct mcp_stats* stats,
+                  int ntab, struct mcp_tab_stats* tabstats)
+{
+	int i;
+
+	if (stats) {
+		perf_timer_get(&pan->frame_time, &stats->frame);
+		perf_timer_get(&pan->frame_interval, &stats->frame_interval);
+		perf_timer_get(&pan->frame_jitter, &stats->frame_jitter);
+		perf_timer_get(&pan->draw_time, &stats->draw);
+		perf_timer_get(&pan->data_lock_wait, &stats->lock_wait);
+		stats->proc_load = governor_get_proc_load(&pan->governor);
+	}
+
+	for (i = 0; tabstats && i < ntab && i < (int)pan->ntab; i++)
+		signaltab_get_stats(pan->tabs[i], &tabstats[i]);
+
+	return pan->ntab;
+}
+
+
+/**
+ * mcp_reset_stats() - restart the accumulation of the performance counters
+ * @pan:        panel
+ *
+ * The counts of dropped samples are not reset (see
+ * mcp_get_tab_dropped_samples()).
+ */
+API_EXPORTED
+void mcp_reset_stats(mcpanel* pan)
+{
+	unsigned int i;
+
+	perf_timer_reset(&pan->frame_time);
+	perf_timer_reset(&pan->frame_interval);
+	perf_timer_reset(&pan->frame_jitter);
+	perf_timer_reset(&pan->draw_time);
+	perf_timer_reset(&pan->data_lock_wait);
+
+	for (i = 0; i < pan->ntab; i++)
+		signaltab_reset_stats(pan->tabs[i]);
+}
+
+
+/**
+ * mcp_dump_trace() - write the spans recorded by the timeline tracing
+ * @pan:        panel
+ * @filename:   path of the Chrome trace file to write. If NULL, the trace
+ *              file configured for @pan is used.
+ *
+ * Tracing is enabled by setting the path of the trace file in the
+ * MCPANEL_TRACE environment variable or in the "trace-file" key of the
+ * "main" group of the configuration file. The trace is then written to
+ * this file when the panel is destroyed, and can be written at any time
+ * with this function. The file can be loaded in chrome://tracing or
+ * Perfetto.
+ *
+ * Return: 0 in case of success, -1 if tracing is not enabled or the file
+ * cannot be written
+ */
+API_EXPORTED
+int mcp_dump_trace(mcpanel* pan, const char* filename)
+{
+	if (!filename)
+		filename = pan->trace_file;
+
+	if (!filename || !trace_is_enabled())
+		return -1;
+
+	return trace_dump(filename);
 }
 
 
@@ -467,7 +778,7 @@ void mcp_add_triggers(mcpanel* pan, unsigned int ns,
 	unsigned int ns_w = 0;
 	unsigned int pointer;
 
-	g_mutex_lock(&pan->data_mutex);
+	perf_mutex_lock(&pan->data_mutex, &pan->data_lock_wait);
 
 	pointer = pan->current_sample;
 
@@ -481,6 +792,9 @@ void mcp_add_triggers(mcpanel* pan, unsigned int ns,
 	process_tri(pan, ns, trigg);
 
 	g_mutex_unlock(&pan->data_mutex);
+
+	g_atomic_int_set(&pan->tri_dirty, 1);
+	redraw_scheduler_request(&pan->redraw);
 }
 
 
@@ -81,12 +81,178 @@ enum tabtype {
 	TABTYPE_SPECTRUM,
 };
 
+/**
+ * enum overflow_policy - behavior when samples arrive faster than processed
+ * @OVERFLOW_BLOCK:       mcp_add_samples() waits until there is room in
+ *                        the ingestion buffer of the tab (default)
+ * @OVERFLOW_DROP_OLDEST: the oldest samples not yet processed are discarded
+ *                        to make room for the new ones
+ * @OVERFLOW_COALESCE:    all samples not yet processed are discarded, so
+ *                        that the tab catches up with the most recent data
+ */
+enum overflow_policy {
+	OVERFLOW_BLOCK = 0,
+	OVERFLOW_DROP_OLDEST,
+	OVERFLOW_COALESCE,
+};
+
+/**
+ * enum mcp_sample_format - type of the values of submitted samples
+ * @MCP_FORMAT_FLOAT:   float (default)
+ * @MCP_FORMAT_DOUBLE:  double
+ * @MCP_FORMAT_INT16:   16 bit signed integer
+ * @MCP_FORMAT_INT24:   24 bit signed integer stored in the least
+ *                      significant bits of a 32 bit word (the 8 most
+ *                      significant bits are ignored)
+ * @MCP_FORMAT_INT32:   32 bit signed integer
+ *
+ * Values are converted to float when the samples are processed, after
+ * which the calibration of the channels is applied (see
+ * mcp_set_tab_calibration()).
+ */
+enum mcp_sample_format {
+	MCP_FORMAT_FLOAT = 0,
+	MCP_FORMAT_DOUBLE,
+	MCP_FORMAT_INT16,
+	MCP_FORMAT_INT24,
+	MCP_FORMAT_INT32,
+};
+
+/**
+ * struct mcp_write_window - location where samples can be written directly
+ * @data:       start of the 2 spans of the window. Each span is an array of
+ *              samples laid out as in the data passed to mcp_add_samples()
+ *              and whose values are in the sample format of the tab input
+ * @ns:         number of samples in each span
+ *
+ * The window is split in 2 spans when it wraps at the end of the internal
+ * buffer, otherwise @ns[1] is 0.
+ */
+struct mcp_write_window {
+	void* data[2];
+	unsigned int ns[2];
+};
+
+/**
+ * enum mcp_quality_level - quality of the display under CPU overload
+ * @MCP_QUALITY_FULL:           the display is updated as configured
+ * @MCP_QUALITY_REDUCED_RATE:   the tabs are updated at most at half the
+ *                              rate of the panel
+ * @MCP_QUALITY_FEWER_CHANNELS: in addition, the scopes show fewer channels
+ *                              at once
+ * @MCP_QUALITY_SLOW_SPECTRUM:  in addition, the spectra are updated 4 times
+ *                              less often
+ * @MCP_QUALITY_SKIP_FRAMES:    in addition, the panel is redrawn at half of
+ *                              its configured rate
+ *
+ * When the drawing cannot keep up with the refresh rate, the quality of
+ * the display is lowered step by step, and raised back when the load
+ * allows it. The levels do not lower the cost of the processing of the
+ * samples, which is reported in the proc_load field of struct mcp_stats. This can be disabled by setting the
+ * "quality-governor" key of the "main" group of the configuration file to
+ * false.
+ */
+enum mcp_quality_level {
+	MCP_QUALITY_FULL = 0,
+	MCP_QUALITY_REDUCED_RATE,
+	MCP_QUALITY_FEWER_CHANNELS,
+	MCP_QUALITY_SLOW_SPECTRUM,
+	MCP_QUALITY_SKIP_FRAMES,
+};
+
+/**
+ * struct mcp_timing - distribution of the duration of an operation
+ * @count:      number of times the operation has been measured
+ * @mean:       mean duration in microseconds
+ * @p50:        median of the duration in microseconds (estimated within
+ *              12%)
+ * @p99:        99th percentile of the duration in microseconds (estimated
+ *              within 12%)
+ * @max:        maximal duration in microseconds
+ */
+struct mcp_timing {
+	unsigned long count;
+	float mean;
+	float p50;
+	float p99;
+	float max;
+};
+
+/**
+ * struct mcp_tab_stats - performance counters of a tab
+ * @samples_ingested: number of samples processed by the tab
+ * @samples_dropped:  number of samples discarded by the overflow policy of
+ *                    the tab input (see mcp_get_tab_dropped_samples())
+ * @process:          processing of a block of samples by the tab
+ * @update:           update of the display with the processed data
+ * @draw:             drawing of a widget of the tab on screen
+ * @lock_wait:        wait for the data lock of the tab
+ * @latency:          time from the submission of samples to the tab until
+ *                    they are drawn on screen. Only the samples displayed
+ *                    while the tab is visible are accounted.
+ */
+struct mcp_tab_stats {
+	unsigned long samples_ingested;
+	unsigned long samples_dropped;
+	struct mcp_timing process;
+	struct mcp_timing update;
+	struct mcp_timing draw;
+	struct mcp_timing lock_wait;
+	struct mcp_timing latency;
+};
+
+/**
+ * struct mcp_stats - performance counters of a panel
+ * @frame:          update of the display in a frame
+ * @frame_interval: time between successive frames
+ * @frame_jitter:   difference between successive frame intervals
+ * @draw:           drawing of a widget outside of the tabs on screen
+ * @lock_wait:      wait for the lock of the trigger data
+ * @proc_load:      largest processing load of the tab inputs over the last
+ *                  half second, ie time spent to process their samples
+ *                  over the real time duration of these samples. Above 1,
+ *                  the processing falls behind and the samples are queued,
+ *                  then dropped or blocking the producer according to the
+ *                  overflow policy.
+ *
+ * The frames are drawn only when new data has come, hence the frames
+ * separated by more than 4 redraw periods are not accounted in
+ * @frame_interval and @frame_jitter.
+ */
+struct mcp_stats {
+	struct mcp_timing frame;
+	struct mcp_timing frame_interval;
+	struct mcp_timing frame_jitter;
+	struct mcp_timing draw;
+	struct mcp_timing lock_wait;
+	double proc_load;
+};
+
+/**
+ * struct panel_tabconf - description of a tab
+ * @type:       kind of tab
+ * @name:       label of the tab
+ * @nscales:    number of elements in @sclabels and @scales
+ * @sclabels:   labels of the scales proposed in the scale combo
+ * @scales:     values of the scales proposed in the scale combo
+ * @source:     name of the stream displayed by the tab (may be NULL). Tabs
+ *              with the same source name share the same input: samples
+ *              and input definition submitted to any of them apply to all
+ *              of them, and the filters they have in common are computed
+ *              only once. If NULL, the tab has its own input.
+ * @refresh_rate: maximal rate in Hz at which the display of the tab is
+ *              updated. If 0, the tab is updated at each redraw of the
+ *              panel. It can be overridden by the "refresh-rate" key of
+ *              the group of the tab in the configuration file.
+ */
 struct panel_tabconf {
 	enum tabtype type;
 	const char* name;
 	int nscales;
 	const char** sclabels;
 	const float* scales;
+	const char* source;
+	float refresh_rate;
 };
 
 void mcp_init_lib(int *argc, char ***argv);
@@ -101,10 +267,31 @@ int mcp_notify(mcpanel* panel, enum notification event);
 int mcp_define_tab_input(mcpanel* pan, int tabid,
                               unsigned int nch, float fs, 
 			      const char** labels);
+int mcp_define_tab_input_format(mcpanel* pan, int tabid,
+                                unsigned int nch, float fs,
+                                const char** labels,
+                                enum mcp_sample_format format);
+int mcp_set_tab_calibration(mcpanel* pan, int tabid,
+                            const float* gain, const float* offset);
 int mcp_select_tab_channels(mcpanel* panel, int tabid,
                             int nch, int const * indices);
 void mcp_add_samples(mcpanel* pan, int tabid,
                          unsigned int ns, const float* data);
+void mcp_add_raw_samples(mcpanel* pan, int tabid,
+                         unsigned int ns, const void* data);
+void mcp_add_samples_planar(mcpanel* pan, int tabid,
+                            unsigned int ns, const void* data);
+unsigned int mcp_acquire_samples(mcpanel* pan, int tabid, unsigned int ns,
+                                 struct mcp_write_window* win);
+void mcp_commit_samples(mcpanel* pan, int tabid, unsigned int ns);
+int mcp_set_tab_overflow_policy(mcpanel* pan, int tabid,
+                                enum overflow_policy policy);
+unsigned int mcp_get_tab_dropped_samples(mcpanel* pan, int tabid);
+enum mcp_quality_level mcp_get_quality_level(mcpanel* pan);
+int mcp_get_stats(mcpanel* pan, struct mcp_stats* stats,
+                  int ntab, struct mcp_tab_stats* tabstats);
+void mcp_reset_stats(mcpanel* pan);
+int mcp_dump_trace(mcpanel* pan, const char* filename);
 int mcp_define_triggers(mcpanel* pan, unsigned int nline, float fs);
 int mcp_define_trigg_input(mcpanel* pan, unsigned int nline,
                            unsigned int trigg_nch, float fs,
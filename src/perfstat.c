@@ -0,0 +1,196 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "perfstat.h"
+
+/**
+ * DOC: Performance counters
+ *
+ * The time taken by the operations of interest is accumulated in a
+ * histogram of the durations, from which the mean, maximum and
+ * percentiles are obtained when the counters are read. The histogram is
+ * log-linear: each octave of durations is split in PERF_SUBBINS bins, hence
+ * a percentile is known within 12%.
+ *
+ * Adding a measure only takes a few atomic operations on the timer, which
+ * is written mostly by a single thread, so that the counters can be kept
+ * in production. Reading them while they are updated may give a total
+ * slightly inconsistent with the bins, which is irrelevant for
+ * statistics.
+ */
+
+
+static
+unsigned int perf_bin(gint64 duration)
+{
+	unsigned int octave;
+
+	if (duration < PERF_SUBBINS)
+		return (duration > 0) ? duration : 0;
+
+	if (duration > G_MAXINT)
+		duration = G_MAXINT;
+
+	octave = g_bit_storage(duration) - 1;
+	return (octave - PERF_SUBBITS + 1) * PERF_SUBBINS
+	       + ((duration >> (octave - PERF_SUBBITS)) & (PERF_SUBBINS - 1));
+}
+
+
+/* Middle of the durations of a bin */
+static
+float perf_bin_value(unsigned int bin)
+{
+	unsigned int octave, low, width;
+
+	if (bin < PERF_SUBBINS)
+		return bin;
+
+	octave = bin / PERF_SUBBINS + PERF_SUBBITS - 1;
+	width = 1u << (octave - PERF_SUBBITS);
+	low = (PERF_SUBBINS + bin % PERF_SUBBINS) * width;
+
+	return low + 0.5f * (width - 1);
+}
+
+
+/**
+ * perf_timer_add() - account a measure of duration
+ * @timer:      timer updated
+ * @duration:   duration in microseconds
+ *
+ * This can be called concurrently from any thread.
+ */
+LOCAL_FN
+void perf_timer_add(struct perf_timer* timer, gint64 duration)
+{
+	gint max;
+
+	if (duration > G_MAXINT)
+		duration = G_MAXINT;
+
+	g_atomic_int_inc(&timer->bins[perf_bin(duration)]);
+	g_atomic_pointer_add(&timer->total, duration);
+
+	do {
+		max = g_atomic_int_get(&timer->max);
+		if (duration <= max)
+			break;
+	} while (!g_atomic_int_compare_and_exchange(&timer->max, max,
+	                                            duration));
+}
+
+
+/**
+ * perf_timer_reset() - discard the measures of a timer
+ * @timer:      timer to reset
+ */
+LOCAL_FN
+void perf_timer_reset(struct perf_timer* timer)
+{
+	unsigned int i;
+
+	for (i = 0; i < PERF_NBIN; i++)
+		g_atomic_int_set(&timer->bins[i], 0);
+
+	g_atomic_pointer_set(&timer->total, 0);
+	g_atomic_int_set(&timer->max, 0);
+}
+
+
+/**
+ * percentile_value() - estimate a percentile of a histogram of durations
+ * @bins:       histogram
+ * @count:      total number of measures in @bins
+ * @pct:        percentile to estimate
+ *
+ * Return: the value of the smallest bin under which @pct percent of the
+ * measures fall
+ */
+static
+float percentile_value(const gint* bins, unsigned long count, int pct)
+{
+	unsigned int i;
+	unsigned long rank = 0;
+
+	for (i = 0; i < PERF_NBIN-1; i++) {
+		rank += bins[i];
+		if (100*rank >= pct*count)
+			break;
+	}
+
+	return perf_bin_value(i);
+}
+
+
+/**
+ * perf_timer_get() - get the statistics of the measures of a timer
+ * @timer:      timer
+ * @timing:     structure receiving the statistics
+ */
+LOCAL_FN
+void perf_timer_get(struct perf_timer* timer, struct mcp_timing* timing)
+{
+	unsigned int i;
+	unsigned long count = 0;
+	gint bins[PERF_NBIN];
+
+	for (i = 0; i < PERF_NBIN; i++) {
+		bins[i] = g_atomic_int_get(&timer->bins[i]);
+		count += bins[i];
+	}
+
+	*timing = (struct mcp_timing) {.count = count};
+	if (!count)
+		return;
+
+	timing->mean = (float)(gssize)g_atomic_pointer_get(&timer->total)
+	               / count;
+	timing->max = g_atomic_int_get(&timer->max);
+
+	timing->p50 = MIN(percentile_value(bins, count, 50), timing->max);
+	timing->p99 = MIN(percentile_value(bins, count, 99), timing->max);
+}
+
+
+/**
+ * perf_mutex_lock() - lock a mutex and account the time waited for it
+ * @mtx:        mutex to lock
+ * @wait:       timer accounting the waits
+ *
+ * The clock is read only if the mutex is contended.
+ */
+LOCAL_FN
+void perf_mutex_lock(GMutex* mtx, struct perf_timer* wait)
+{
+	gint64 start;
+
+	if (g_mutex_trylock(mtx)) {
+		perf_timer_add(wait, 0);
+		return;
+	}
+
+	start = g_get_monotonic_time();
+	g_mutex_lock(mtx);
+	perf_timer_add(wait, g_get_monotonic_time() - start);
+}
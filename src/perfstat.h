@@ -0,0 +1,44 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef PERFSTAT_H
+#define PERFSTAT_H
+
+#include <glib.h>
+#include "mcpanel.h"
+
+/* The durations are binned with a resolution of 1us below PERF_SUBBINS us,
+ * then with PERF_SUBBINS bins per octave up to G_MAXINT us */
+#define PERF_SUBBITS	3
+#define PERF_SUBBINS	(1 << PERF_SUBBITS)
+#define PERF_NBIN	((32 - PERF_SUBBITS) * PERF_SUBBINS)
+
+/* Distribution of a duration, which can be updated concurrently by several
+ * threads without lock */
+struct perf_timer {
+	volatile gint bins[PERF_NBIN];
+	volatile gssize total;
+	volatile gint max;
+};
+
+LOCAL_FN void perf_timer_add(struct perf_timer* timer, gint64 duration);
+LOCAL_FN void perf_timer_reset(struct perf_timer* timer);
+LOCAL_FN void perf_timer_get(struct perf_timer* timer,
+                             struct mcp_timing* timing);
+LOCAL_FN void perf_mutex_lock(GMutex* mtx, struct perf_timer* wait);
+
+#endif /* PERFSTAT_H */
@@ -33,8 +33,10 @@ enum {
 
 static void 	plot_area_realize_callback(PlotArea* self);
 static void 	plot_area_unrealize_callback(PlotArea* self);
+static void 	plot_area_map_callback(PlotArea* self);
 static void plot_area_set_color(PlotArea* self, const gchar* colorstr, GdkColor* color);
 static void plot_area_set_channel_colors(PlotArea* self, const gchar* colorstr);
+static void plot_area_queue_raster(PlotArea* self);
 
 
 LOCAL_FN GType plot_area_get_type(void);
@@ -64,15 +66,18 @@ void plot_area_set_property (GObject *object, guint property_id,
 	switch (property_id) {
 	case GRID_COLOR:
 		plot_area_set_color(self, g_value_get_string(value), &(self->grid_color));
+		plot_area_invalidate_backing(self);
 		break;
 
 	case BACKGROUND_COLOR:
 		plot_area_set_color(self, g_value_get_string(value), &color);
 		gtk_widget_modify_bg ( GTK_WIDGET(self), GTK_STATE_NORMAL, &color);
+		plot_area_invalidate_backing(self);
 		break;
 
 	case CHANNEL_COLOR:
 		plot_area_set_channel_colors(self, g_value_get_string(value));
+		plot_area_invalidate_backing(self);
 		break;
 
 	default:
@@ -81,11 +86,30 @@ void plot_area_set_property (GObject *object, guint property_id,
 }
 
 
+static
+void plot_area_dispose (GObject *object)
+{
+	PlotArea* self = PLOT_AREA(object);
+
+	// The data of the subclasses may be freed once the widget has been
+	// destroyed: a queued rasterization job must not touch it anymore
+	g_mutex_lock(&self->rastlock);
+	self->disposed = TRUE;
+	g_mutex_unlock(&self->rastlock);
+
+	if (G_OBJECT_CLASS (plot_area_parent_class)->dispose)
+		G_OBJECT_CLASS (plot_area_parent_class)->dispose (object);
+}
+
+
 static
 void plot_area_finalize (GObject *object)
 {
 	PlotArea* self = PLOT_AREA(object);
 
+	raster_deinit(&self->raster);
+	g_free(self->job_colors);
+	g_mutex_clear(&self->rastlock);
 	g_free(self->colors);
 	g_free(self->xticks);
 	g_free(self->yticks);
@@ -103,7 +127,9 @@ void plot_area_class_init (PlotAreaClass *klass)
 
 	object_class->get_property = plot_area_get_property;
 	object_class->set_property = plot_area_set_property;
+	object_class->dispose = plot_area_dispose;
 	object_class->finalize = plot_area_finalize;
+	klass->rasterize = NULL;
 
 	g_object_class_install_property(G_OBJECT_CLASS(klass),
 					GRID_COLOR,
@@ -157,6 +183,7 @@ void plot_area_init (PlotArea *self)
 	self->colors = g_malloc(self->nColors*sizeof(GdkColor));
 	self->num_xticks = self->num_yticks = 0;
 	self->xticks = self->yticks = NULL;
+	self->first_ytick = 0;
 
 	// Assign default colors
 	gdk_color_parse("gray67", &(self->grid_color));
@@ -164,12 +191,28 @@ void plot_area_init (PlotArea *self)
 		gdk_color_parse("blue1", self->colors + i);
 	
 	self->plotgc = NULL;
+	self->backing = NULL;
+	self->backing_width = self->backing_height = 0;
+
+	self->disposed = FALSE;
+	self->raster_queued = FALSE;
+	self->full_pending = self->has_pending = FALSE;
+	self->pointer = 0;
+	self->cursor = self->raster_cursor = -1;
+	self->dirty_xmin = G_MAXINT;
+	self->dirty_xmax = -1;
+	self->job_colors = NULL;
+	self->job_ncolors = 0;
+	raster_init(&self->raster);
+	g_mutex_init(&self->rastlock);
 	
 	/* Connect the handled signal*/
 	g_signal_connect_after (G_OBJECT (self), "realize",  
 	                        G_CALLBACK (plot_area_realize_callback), NULL);
 	g_signal_connect (G_OBJECT (self), "unrealize",  
 	                        G_CALLBACK (plot_area_unrealize_callback), NULL);
+	g_signal_connect_after (G_OBJECT (self), "map",
+	                        G_CALLBACK (plot_area_map_callback), NULL);
 }
 
 
@@ -199,6 +242,19 @@ void plot_area_unrealize_callback(PlotArea* self)
 	gdk_colormap_free_colors( colormap, &(self->grid_color), 1);
 
 	g_object_unref( G_OBJECT(self->plotgc) );
+
+	if (self->backing)
+		g_object_unref(G_OBJECT(self->backing));
+	self->backing = NULL;
+}
+
+
+/* The rendering is suspended while the plot is not mapped, eg in a hidden
+ * notebook page: the pending rendering is submitted when it is shown */
+static
+void plot_area_map_callback(PlotArea* self)
+{
+	plot_area_queue_raster(self);
 }
 
 
@@ -271,3 +327,427 @@ void plot_area_set_ticks(PlotArea* self, guint num_xticks, guint num_yticks)
 		self->yticks = g_malloc(self->num_yticks * sizeof(*(self->yticks)));
 	}
 }
+
+
+
+/**
+ * DOC: Backing pixmap and rasterization
+ *
+ * The subclasses that implement the rasterize() method do not draw in
+ * their expose handler: the plot is kept in an off-screen pixmap of the
+ * size of the widget, the backing pixmap, which the expose handler simply
+ * copies on the window before drawing the overlays (scanline, markers).
+ * Uncovering the widget or switching to its notebook page does not
+ * require to render the data again.
+ *
+ * The plots are rendered in a client-side raster by worker threads, one
+ * job per widget at a time, so that high density plots do not delay the
+ * main loop. When a job is done, the columns it has updated are copied
+ * into the backing pixmap and redrawn on the window from the main loop.
+ *
+ * The subclasses report the progression of their data ring with
+ * plot_area_update_pointer(). A job then renders the samples between the
+ * pointer at the end of the previous job and the current one (job_from
+ * and job_to), or the whole plot if job_full is set, ie if the backing
+ * pixmap has been invalidated by plot_area_invalidate_backing(). The
+ * rasterize() method is called with rastlock held: the subclasses must
+ * hold it with plot_area_lock_raster() while modifying the state used by
+ * the method (geometry, data buffer...). Samples are written in the data
+ * ring concurrently ahead of the pointer, hence the columns at the
+ * boundary may be transiently off until the next job renders them again.
+ */
+
+
+// The jobs are asynchronous, hence cannot run on the DSP worker pool whose
+// runs block the caller: they have a few threads of their own, shared by
+// the panels
+#define RASTER_MAX_THREADS	2
+
+static GMutex raster_pool_lock;
+static GThreadPool* raster_pool = NULL;
+static int raster_pool_users = 0;
+
+// Plot areas whose job is done, waiting for plot_area_raster_done(). They
+// are handed over to the main loop by a single idle source (raster_done_id)
+static GMutex raster_done_lock;
+static GSList* raster_done_list = NULL;
+static guint raster_done_id = 0;
+
+
+/**
+ * plot_area_composite() - copy the result of a rasterization job
+ * @self:       plot area whose last job is done
+ *
+ * Must be called from the main loop.
+ */
+static
+void plot_area_composite(PlotArea* self)
+{
+	GtkWidget* widget = GTK_WIDGET(self);
+	GdkRectangle rect;
+	gint xmin, xmax, old_cursor = self->cursor;
+	struct raster* r = &self->raster;
+
+	g_mutex_lock(&self->rastlock);
+	xmin = MAX(self->dirty_xmin, 0);
+	xmax = MIN(self->dirty_xmax, r->width-1);
+	self->dirty_xmin = G_MAXINT;
+	self->dirty_xmax = -1;
+	self->cursor = self->raster_cursor;
+
+	if (self->backing && xmin <= xmax) {
+		// The raster can be out of date only if the widget has been
+		// resized after the job was queued
+		if (r->width == self->backing_width
+		    && r->height == self->backing_height)
+			gdk_draw_rgb_32_image(self->backing, self->plotgc,
+			                      xmin, 0, xmax-xmin+1, r->height,
+			                      GDK_RGB_DITHER_NONE,
+			                      (guchar*)(r->pix + xmin),
+			                      r->width*sizeof(*r->pix));
+		else
+			self->full_pending = TRUE;
+	}
+	g_mutex_unlock(&self->rastlock);
+
+	if (!gtk_widget_is_drawable(widget))
+		return;
+
+	rect.y = 0;
+	rect.height = widget->allocation.height;
+	if (xmin <= xmax) {
+		rect.x = xmin;
+		rect.width = xmax - xmin + 1;
+		gdk_window_invalidate_rect(widget->window, &rect, FALSE);
+	}
+
+	if (old_cursor != self->cursor) {
+		rect.width = 1;
+		rect.x = old_cursor;
+		gdk_window_invalidate_rect(widget->window, &rect, FALSE);
+		rect.x = self->cursor;
+		gdk_window_invalidate_rect(widget->window, &rect, FALSE);
+	}
+}
+
+
+static
+gboolean plot_area_raster_done(gpointer data)
+{
+	GSList *list, *elt;
+	PlotArea* self;
+	(void)data;
+
+	g_mutex_lock(&raster_done_lock);
+	list = raster_done_list;
+	raster_done_list = NULL;
+	raster_done_id = 0;
+	g_mutex_unlock(&raster_done_lock);
+
+	for (elt = list; elt; elt = elt->next) {
+		self = elt->data;
+		self->raster_queued = FALSE;
+		if (!self->disposed) {
+			plot_area_composite(self);
+
+			// Render what has been accumulated during the job
+			plot_area_queue_raster(self);
+		}
+
+		g_object_unref(self);
+	}
+
+	g_slist_free(list);
+	return FALSE;
+}
+
+
+static
+void plot_area_raster_job(gpointer data, gpointer user_data)
+{
+	PlotArea* self = data;
+	struct raster* r = &self->raster;
+	(void)user_data;
+
+	g_mutex_lock(&self->rastlock);
+	if (!self->disposed) {
+		if (self->job_full) {
+			raster_resize(r, self->job_width, self->job_height);
+			raster_fill(r, 0, 0, r->width-1, r->height-1,
+			            self->job_bg);
+			plot_area_mark_dirty(self, 0, r->width-1);
+		}
+		PLOT_AREA_GET_CLASS(self)->rasterize(self);
+	}
+	g_mutex_unlock(&self->rastlock);
+
+	g_mutex_lock(&raster_done_lock);
+	raster_done_list = g_slist_prepend(raster_done_list, self);
+	if (!raster_done_id)
+		raster_done_id = gdk_threads_add_idle(plot_area_raster_done,
+		                                      NULL);
+	g_mutex_unlock(&raster_done_lock);
+}
+
+
+/**
+ * plot_area_queue_raster() - submit the pending rendering to a worker
+ * @self:       plot area
+ *
+ * Nothing is done if a job of @self is already in flight: the pending
+ * rendering is submitted once it completes. Likewise, the rendering is
+ * kept pending while @self is not mapped or no panel holds the worker
+ * threads. The state needed by the job that is owned by the main thread is
+ * copied in the job parameters.
+ */
+static
+void plot_area_queue_raster(PlotArea* self)
+{
+	GtkWidget* widget = GTK_WIDGET(self);
+	guint i;
+
+	if (!PLOT_AREA_GET_CLASS(self)->rasterize || !raster_pool
+	    || self->raster_queued || self->disposed
+	    || !gtk_widget_get_mapped(widget)
+	    || (!self->full_pending && !self->has_pending))
+		return;
+
+	g_mutex_lock(&self->rastlock);
+	self->job_full = self->full_pending;
+	self->job_from = self->pend_from;
+	self->job_to = self->pointer;
+	self->job_width = widget->allocation.width;
+	self->job_height = widget->allocation.height;
+
+	if (self->job_ncolors != self->nColors) {
+		g_free(self->job_colors);
+		self->job_ncolors = self->nColors;
+		self->job_colors = g_malloc(self->job_ncolors
+		                            *sizeof(*self->job_colors));
+	}
+	for (i = 0; i < self->nColors; i++)
+		self->job_colors[i] = raster_color(self->colors + i);
+	self->job_grid = raster_color(&self->grid_color);
+	self->job_bg = raster_color(&widget->style->bg[GTK_STATE_NORMAL]);
+	g_mutex_unlock(&self->rastlock);
+
+	self->full_pending = FALSE;
+	self->has_pending = FALSE;
+	self->raster_queued = TRUE;
+
+	// The reference is released by plot_area_raster_done(), or by
+	// plot_area_unref_workers() if the main loop has stopped meanwhile
+	g_object_ref(self);
+	g_thread_pool_push(raster_pool, self, NULL);
+}
+
+
+/**
+ * plot_area_ref_workers() - hold the threads rendering the plots
+ *
+ * The threads are created by the first holder.
+ */
+LOCAL_FN
+void plot_area_ref_workers(void)
+{
+	g_mutex_lock(&raster_pool_lock);
+	if (raster_pool_users++ == 0)
+		raster_pool = g_thread_pool_new(plot_area_raster_job, NULL,
+		                                MIN(g_get_num_processors(),
+		                                    RASTER_MAX_THREADS),
+		                                FALSE, NULL);
+	g_mutex_unlock(&raster_pool_lock);
+}
+
+
+/**
+ * plot_area_unref_workers() - release the threads rendering the plots
+ *
+ * The threads are stopped when the last holder releases them, once the
+ * jobs in flight are done. This happens after the main loop has stopped,
+ * hence the plot areas of the jobs completed meanwhile are released here
+ * instead of plot_area_raster_done().
+ */
+LOCAL_FN
+void plot_area_unref_workers(void)
+{
+	GSList *list = NULL, *elt;
+	PlotArea* self;
+
+	g_mutex_lock(&raster_pool_lock);
+	if (--raster_pool_users == 0) {
+		g_thread_pool_free(raster_pool, FALSE, TRUE);
+		raster_pool = NULL;
+
+		g_mutex_lock(&raster_done_lock);
+		if (raster_done_id)
+			g_source_remove(raster_done_id);
+		raster_done_id = 0;
+		list = raster_done_list;
+		raster_done_list = NULL;
+		g_mutex_unlock(&raster_done_lock);
+	}
+	g_mutex_unlock(&raster_pool_lock);
+
+	for (elt = list; elt; elt = elt->next) {
+		self = elt->data;
+		self->raster_queued = FALSE;
+		g_object_unref(self);
+	}
+	g_slist_free(list);
+}
+
+
+/**
+ * plot_area_invalidate_backing() - request the plot to be fully rendered
+ * @self:       plot area
+ */
+LOCAL_FN
+void plot_area_invalidate_backing(PlotArea* self)
+{
+	self->full_pending = TRUE;
+	plot_area_queue_raster(self);
+}
+
+
+/**
+ * plot_area_update_pointer() - report the progression of the data ring
+ * @self:       plot area
+ * @pointer:    index in the ring of the last written sample
+ * @num_points: size of the ring
+ *
+ * The samples from the previous pointer up to @pointer are rendered by
+ * the next job.
+ */
+LOCAL_FN
+void plot_area_update_pointer(PlotArea* self, guint pointer, guint num_points)
+{
+	if (pointer == self->pointer || num_points == 0)
+		return;
+
+	if (!self->has_pending) {
+		self->pend_from = self->pointer;
+		self->pend_len = 0;
+		self->has_pending = TRUE;
+	}
+
+	// A full turn of the ring is equivalent to a full rendering
+	self->pend_len += (pointer + num_points - self->pointer) % num_points;
+	if (self->pend_len >= num_points)
+		self->full_pending = TRUE;
+
+	self->pointer = pointer;
+	plot_area_queue_raster(self);
+}
+
+
+/**
+ * plot_area_is_drawn() - test whether the window shows the latest data
+ * @self:       plot area
+ *
+ * Return: FALSE if a rendering is in flight or pending, TRUE otherwise
+ */
+LOCAL_FN
+gboolean plot_area_is_drawn(PlotArea* self)
+{
+	if (!PLOT_AREA_GET_CLASS(self)->rasterize)
+		return TRUE;
+
+	return !self->raster_queued
+	       && !self->full_pending && !self->has_pending;
+}
+
+
+LOCAL_FN
+void plot_area_lock_raster(PlotArea* self)
+{
+	g_mutex_lock(&self->rastlock);
+}
+
+
+LOCAL_FN
+void plot_area_unlock_raster(PlotArea* self)
+{
+	g_mutex_unlock(&self->rastlock);
+}
+
+
+/**
+ * plot_area_mark_dirty() - record columns of the raster to composite
+ * @self:       plot area
+ * @xmin:       first column modified
+ * @xmax:       last column modified
+ *
+ * Must be called with rastlock held.
+ */
+LOCAL_FN
+void plot_area_mark_dirty(PlotArea* self, gint xmin, gint xmax)
+{
+	self->dirty_xmin = MIN(self->dirty_xmin, xmin);
+	self->dirty_xmax = MAX(self->dirty_xmax, xmax);
+}
+
+
+/**
+ * plot_area_blit_backing() - copy the backing pixmap on the window
+ * @self:       realized plot area
+ * @region:     area of the window to update
+ *
+ * If the size of the backing pixmap does not match the one of the widget,
+ * it is reallocated with the background only and a full rendering is
+ * requested.
+ */
+LOCAL_FN
+void plot_area_blit_backing(PlotArea* self, GdkRegion* region)
+{
+	GtkWidget* widget = GTK_WIDGET(self);
+	gint width = widget->allocation.width;
+	gint height = widget->allocation.height;
+	GdkRectangle* rect;
+	int i, nrect;
+
+	if (!self->backing || self->backing_width != width
+	    || self->backing_height != height) {
+		if (self->backing)
+			g_object_unref(G_OBJECT(self->backing));
+
+		self->backing = gdk_pixmap_new(widget->window, MAX(width, 1),
+		                               MAX(height, 1), -1);
+		self->backing_width = width;
+		self->backing_height = height;
+		gdk_draw_rectangle(self->backing,
+		                   widget->style->bg_gc[GTK_STATE_NORMAL], TRUE,
+		                   0, 0, MAX(width, 1), MAX(height, 1));
+		plot_area_invalidate_backing(self);
+	}
+
+	gdk_region_get_rectangles(region, &rect, &nrect);
+	for (i = 0; i < nrect; i++)
+		gdk_draw_drawable(widget->window, self->plotgc,
+		                  self->backing, rect[i].x, rect[i].y,
+		                  rect[i].x, rect[i].y,
+		                  rect[i].width, rect[i].height);
+	g_free(rect);
+}
+
+
+/**
+ * plot_area_draw_cursor() - draw the scanline on the window
+ * @self:       plot area
+ *
+ * The scanline is drawn at the pointer position of the last rendering
+ * copied into the backing pixmap.
+ */
+LOCAL_FN
+void plot_area_draw_cursor(PlotArea* self)
+{
+	GtkWidget* widget = GTK_WIDGET(self);
+
+	if (self->cursor < 0)
+		return;
+
+	gdk_draw_line(widget->window,
+	              widget->style->fg_gc[gtk_widget_get_state(widget)],
+	              self->cursor, 0,
+	              self->cursor, widget->allocation.height - 1);
+}
@@ -20,6 +20,7 @@
 
 #include <glib-object.h>
 #include <gtk/gtk.h>
+#include "raster.h"
 
 G_BEGIN_DECLS
 
@@ -47,20 +48,63 @@ typedef struct {
 	gint* yticks;
 	guint num_xticks;
 	guint num_yticks;
+	guint first_ytick;
 	GdkColor* colors;
 	guint nColors;
 	GdkColor grid_color;
 	GdkGC* plotgc;
+	GdkPixmap* backing;
+	gint backing_width;
+	gint backing_height;
+
+	/* main thread only */
+	gboolean disposed;
+	gboolean raster_queued;
+	gboolean full_pending;
+	gboolean has_pending;
+	guint pointer;
+	guint pend_from;
+	guint pend_len;
+	gint cursor;
+
+	/* protected by rastlock while a rasterization job is queued */
+	GMutex rastlock;
+	struct raster raster;
+	gint job_width;
+	gint job_height;
+	gboolean job_full;
+	guint job_from;
+	guint job_to;
+	guint32* job_colors;
+	guint job_ncolors;
+	guint32 job_grid;
+	guint32 job_bg;
+	gint raster_cursor;
+	gint dirty_xmin;
+	gint dirty_xmax;
 } PlotArea;
 
 typedef struct {
 	GtkDrawingAreaClass parent_class;
+
+	/* Called on a worker thread with rastlock held */
+	void (*rasterize)(PlotArea* self);
 } PlotAreaClass;
 
 GType plot_area_get_type (void);
 
 PlotArea* plot_area_new (void);
 void plot_area_set_ticks(PlotArea* self, guint num_xticks, guint num_yticks);
+void plot_area_invalidate_backing(PlotArea* self);
+void plot_area_blit_backing(PlotArea* self, GdkRegion* region);
+void plot_area_draw_cursor(PlotArea* self);
+void plot_area_update_pointer(PlotArea* self, guint pointer, guint num_points);
+gboolean plot_area_is_drawn(PlotArea* self);
+void plot_area_lock_raster(PlotArea* self);
+void plot_area_unlock_raster(PlotArea* self);
+void plot_area_mark_dirty(PlotArea* self, gint xmin, gint xmax);
+void plot_area_ref_workers(void);
+void plot_area_unref_workers(void);
 G_END_DECLS
 
 #endif /* _PLOT_AREA */
@@ -0,0 +1,212 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "pyramid.h"
+
+/**
+ * DOC: Min/max pyramid
+ *
+ * The pyramid allows to get the range of values of each channel over any
+ * interval of samples in logarithmic time, whatever the length of the
+ * interval: the interval is decomposed in at most 2 blocks per level, the
+ * blocks being taken at the coarsest level aligned with the interval. It
+ * is updated incrementally as the samples are written, each new sample
+ * updating a single block per level.
+ *
+ * A block k at level l+1 covers the blocks 2k and 2k+1 at level l. When
+ * a level has an odd number of blocks, the last one has no parent.
+ */
+
+// Do not bother building levels whose blocks are too few to be useful
+#define MIN_NBLK	4
+
+
+LOCAL_FN
+void pyramid_init(struct minmax_pyramid* pyr)
+{
+	*pyr = (struct minmax_pyramid) {.nlevel = 0};
+}
+
+
+LOCAL_FN
+void pyramid_deinit(struct minmax_pyramid* pyr)
+{
+	unsigned int l;
+
+	for (l = 1; l <= pyr->nlevel; l++)
+		g_free(pyr->levels[l]);
+
+	g_free(pyr->levels);
+	g_free(pyr->nblk);
+	pyramid_init(pyr);
+}
+
+
+/**
+ * pyramid_resize() - set the geometry of the sample buffer of a pyramid
+ * @pyr:        initialized pyramid
+ * @nch:        number of channels
+ * @ns:         number of samples in the buffer
+ *
+ * The content of the pyramid is undefined until it is updated with the
+ * whole buffer.
+ */
+LOCAL_FN
+void pyramid_resize(struct minmax_pyramid* pyr,
+                    unsigned int nch, unsigned int ns)
+{
+	unsigned int l, nlevel;
+
+	pyramid_deinit(pyr);
+
+	for (nlevel = 0; (ns >> (nlevel+1)) >= MIN_NBLK; nlevel++)
+		;
+
+	pyr->nch = nch;
+	pyr->ns = ns;
+	pyr->nlevel = nlevel;
+	pyr->nblk = g_malloc((nlevel+1)*sizeof(*pyr->nblk));
+	pyr->levels = g_malloc0((nlevel+1)*sizeof(*pyr->levels));
+
+	pyr->nblk[0] = ns;
+	for (l = 1; l <= nlevel; l++) {
+		pyr->nblk[l] = pyr->nblk[l-1] / 2;
+		pyr->levels[l] = g_malloc0(2*pyr->nblk[l]*nch
+		                           *sizeof(*pyr->levels[l]));
+	}
+}
+
+
+/**
+ * pyramid_update() - update a pyramid after a change of samples
+ * @pyr:        pyramid
+ * @data:       sample buffer
+ * @first:      index of the first modified sample
+ * @last:       index of the last modified sample
+ */
+LOCAL_FN
+void pyramid_update(struct minmax_pyramid* pyr, const float* data,
+                    unsigned int first, unsigned int last)
+{
+	unsigned int l, k, j, k0, k1, nch = pyr->nch;
+	const float *a, *b;
+	float* dst;
+
+	for (l = 1; l <= pyr->nlevel; l++) {
+		k0 = first >> l;
+		k1 = MIN(last >> l, pyr->nblk[l] - 1);
+
+		for (k = k0; k <= k1; k++) {
+			dst = pyr->levels[l] + 2*k*nch;
+
+			// Level 1 is built from the samples
+			if (l == 1) {
+				a = data + 2*k*nch;
+				b = a + nch;
+				for (j = 0; j < nch; j++) {
+					dst[2*j] = MIN(a[j], b[j]);
+					dst[2*j+1] = MAX(a[j], b[j]);
+				}
+				continue;
+			}
+
+			a = pyr->levels[l-1] + 4*k*nch;
+			b = a + 2*nch;
+			for (j = 0; j < nch; j++) {
+				dst[2*j] = MIN(a[2*j], b[2*j]);
+				dst[2*j+1] = MAX(a[2*j+1], b[2*j+1]);
+			}
+		}
+	}
+}
+
+
+static inline
+void merge_element(const struct minmax_pyramid* pyr, const float* data,
+                   unsigned int nch, unsigned int ch0, unsigned int nqch,
+                   unsigned int l, unsigned int k, float* env)
+{
+	const float* e;
+	unsigned int j;
+
+	if (l == 0) {
+		e = data + k*nch + ch0;
+		for (j = 0; j < nqch; j++) {
+			env[2*j] = MIN(env[2*j], e[j]);
+			env[2*j+1] = MAX(env[2*j+1], e[j]);
+		}
+		return;
+	}
+
+	e = pyr->levels[l] + 2*(k*nch + ch0);
+	for (j = 0; j < nqch; j++) {
+		env[2*j] = MIN(env[2*j], e[2*j]);
+		env[2*j+1] = MAX(env[2*j+1], e[2*j+1]);
+	}
+}
+
+
+/**
+ * pyramid_query() - get the range of values over an interval of samples
+ * @pyr:        pyramid of @data (if NULL, @data is walked at full
+ *              resolution)
+ * @data:       sample buffer
+ * @nch:        number of channels in @data
+ * @ch0:        first channel of the queried range
+ * @nqch:       number of channels in the queried range
+ * @first:      index of the first sample of the interval
+ * @last:       index of the last sample of the interval
+ * @env:        array receiving the minimum and maximum of each queried
+ *              channel ([min0, max0, min1, max1, ...])
+ */
+LOCAL_FN
+void pyramid_query(const struct minmax_pyramid* pyr, const float* data,
+                   unsigned int nch, unsigned int ch0, unsigned int nqch,
+                   unsigned int first, unsigned int last, float* env)
+{
+	unsigned int j, l, lo, hi;
+	unsigned int nlevel = pyr ? pyr->nlevel : 0;
+
+	for (j = 0; j < nqch; j++)
+		env[2*j] = env[2*j+1] = data[first*nch + ch0 + j];
+
+	// Climb the levels, taking at each one the elements at the ends of
+	// the interval [lo, hi) that are not covered by a parent within it
+	lo = first;
+	hi = last + 1;
+	for (l = 0; lo < hi; l++) {
+		if (l == nlevel) {
+			for (; lo < hi; lo++)
+				merge_element(pyr, data, nch, ch0, nqch, l, lo, env);
+			break;
+		}
+
+		if (lo & 1)
+			merge_element(pyr, data, nch, ch0, nqch, l, lo++, env);
+		if (hi & 1)
+			merge_element(pyr, data, nch, ch0, nqch, l, --hi, env);
+
+		lo >>= 1;
+		hi >>= 1;
+	}
+}
@@ -0,0 +1,45 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+/* Min/max pyramid of a buffer of interleaved samples. Level l (l >= 1)
+ * holds, for each block of 2^l samples, the minimum and maximum of each
+ * channel. Level 0 is the sample buffer itself, which is not owned by the
+ * pyramid. */
+struct minmax_pyramid {
+	unsigned int nch;
+	unsigned int ns;
+	unsigned int nlevel;
+	unsigned int* nblk;
+	float** levels;
+};
+
+LOCAL_FN void pyramid_init(struct minmax_pyramid* pyr);
+LOCAL_FN void pyramid_deinit(struct minmax_pyramid* pyr);
+LOCAL_FN void pyramid_resize(struct minmax_pyramid* pyr,
+                             unsigned int nch, unsigned int ns);
+LOCAL_FN void pyramid_update(struct minmax_pyramid* pyr, const float* data,
+                             unsigned int first, unsigned int last);
+LOCAL_FN void pyramid_query(const struct minmax_pyramid* pyr,
+                            const float* data, unsigned int nch,
+                            unsigned int ch0, unsigned int nqch,
+                            unsigned int first, unsigned int last,
+                            float* env);
+
+#endif /* PYRAMID_H */
@@ -0,0 +1,184 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <string.h>
+#include <glib.h>
+
+#include "raster.h"
+
+
+LOCAL_FN
+void raster_init(struct raster* r)
+{
+	*r = (struct raster) {.pix = NULL};
+}
+
+
+LOCAL_FN
+void raster_deinit(struct raster* r)
+{
+	g_free(r->pix);
+	raster_init(r);
+}
+
+
+/**
+ * raster_resize() - change the size of a raster
+ * @r:          initialized raster
+ * @width:      new width in pixels
+ * @height:     new height in pixels
+ *
+ * The content of the raster is undefined after a change of size.
+ */
+LOCAL_FN
+void raster_resize(struct raster* r, int width, int height)
+{
+	width = MAX(width, 0);
+	height = MAX(height, 0);
+	if (width == r->width && height == r->height)
+		return;
+
+	g_free(r->pix);
+	r->pix = g_malloc((gsize)width*height*sizeof(*r->pix));
+	r->width = width;
+	r->height = height;
+}
+
+
+/**
+ * raster_color() - convert a color into a raster pixel value
+ * @color:      color to convert
+ *
+ * Return: the value to store in the pixels of the color
+ */
+LOCAL_FN
+guint32 raster_color(const GdkColor* color)
+{
+	guchar px[4] = {color->red >> 8, color->green >> 8, color->blue >> 8, 0};
+	guint32 val;
+
+	memcpy(&val, px, sizeof(val));
+	return val;
+}
+
+
+/**
+ * raster_fill() - fill a rectangle of a raster
+ * @r:          raster
+ * @x0:         first column of the rectangle
+ * @y0:         first row of the rectangle
+ * @x1:         last column of the rectangle
+ * @y1:         last row of the rectangle
+ * @color:      pixel value to fill with
+ *
+ * The rectangle is clipped to the raster. Coordinates of opposite corners
+ * may be given in any order.
+ */
+LOCAL_FN
+void raster_fill(struct raster* r, int x0, int y0, int x1, int y1,
+                 guint32 color)
+{
+	guint32* row;
+	int x, y, tmp;
+
+	if (x0 > x1) {
+		tmp = x0; x0 = x1; x1 = tmp;
+	}
+	if (y0 > y1) {
+		tmp = y0; y0 = y1; y1 = tmp;
+	}
+
+	x0 = MAX(x0, 0);
+	y0 = MAX(y0, 0);
+	x1 = MIN(x1, r->width-1);
+	y1 = MIN(y1, r->height-1);
+
+	for (y = y0; y <= y1; y++) {
+		row = r->pix + (gsize)y*r->width;
+		for (x = x0; x <= x1; x++)
+			row[x] = color;
+	}
+}
+
+
+/**
+ * raster_line() - draw a one pixel wide line in a raster
+ * @r:          raster
+ * @x0:         column of the start point
+ * @y0:         row of the start point
+ * @x1:         column of the end point
+ * @y1:         row of the end point
+ * @color:      pixel value of the line
+ *
+ * Both end points are drawn. Pixels out of the raster are clipped.
+ */
+LOCAL_FN
+void raster_line(struct raster* r, int x0, int y0, int x1, int y1,
+                 guint32 color)
+{
+	int dx, dy, sx, sy, err, e2;
+
+	// Axis aligned lines are the vast majority in plots
+	if (x0 == x1 || y0 == y1) {
+		raster_fill(r, x0, y0, x1, y1, color);
+		return;
+	}
+
+	// Bresenham's algorithm
+	dx = ABS(x1 - x0);
+	dy = -ABS(y1 - y0);
+	sx = (x0 < x1) ? 1 : -1;
+	sy = (y0 < y1) ? 1 : -1;
+	err = dx + dy;
+	while (1) {
+		if (x0 >= 0 && x0 < r->width && y0 >= 0 && y0 < r->height)
+			r->pix[(gsize)y0*r->width + x0] = color;
+
+		if (x0 == x1 && y0 == y1)
+			break;
+
+		e2 = 2*err;
+		if (e2 >= dy) {
+			err += dy;
+			x0 += sx;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			y0 += sy;
+		}
+	}
+}
+
+
+LOCAL_FN
+void raster_lines(struct raster* r, const GdkPoint* points, int npoints,
+                  guint32 color)
+{
+	int i;
+
+	if (npoints == 1)
+		raster_line(r, points[0].x, points[0].y,
+		            points[0].x, points[0].y, color);
+
+	for (i = 1; i < npoints; i++)
+		raster_line(r, points[i-1].x, points[i-1].y,
+		            points[i].x, points[i].y, color);
+}
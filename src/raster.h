@@ -0,0 +1,43 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <gdk/gdk.h>
+
+/* Client-side image buffer. Pixels are stored row by row in the layout
+ * expected by gdk_draw_rgb_32_image(): red, green, blue, padding. Being
+ * plain memory, a raster can be drawn from any thread. */
+struct raster {
+	int width;
+	int height;
+	guint32* pix;
+};
+
+LOCAL_FN void raster_init(struct raster* r);
+LOCAL_FN void raster_deinit(struct raster* r);
+LOCAL_FN void raster_resize(struct raster* r, int width, int height);
+LOCAL_FN guint32 raster_color(const GdkColor* color);
+LOCAL_FN void raster_fill(struct raster* r, int x0, int y0, int x1, int y1,
+                          guint32 color);
+LOCAL_FN void raster_line(struct raster* r, int x0, int y0, int x1, int y1,
+                          guint32 color);
+LOCAL_FN void raster_lines(struct raster* r, const GdkPoint* points,
+                           int npoints, guint32 color);
+
+#endif /* RASTER_H */
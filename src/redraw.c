@@ -0,0 +1,199 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "redraw.h"
+
+/**
+ * DOC: Redraw scheduling
+ *
+ * Rather than polling the tabs at a fixed period, the panel is redrawn on
+ * demand: the threads that feed the tabs call redraw_scheduler_request()
+ * after marking what they have modified, and the main loop runs a frame
+ * in response. Between the requests, the main loop is not woken up at
+ * all.
+ *
+ * The scheduler is a GSource attached to the default main context whose
+ * ready time is set by the requests. Only the first request after a frame
+ * touches the source, the following ones are covered by the frame already
+ * scheduled. A frame requested less than one interval after the previous
+ * one is delayed up to this time, hence the frame rate never exceeds the
+ * configured rate, while a request after an idle period is served
+ * immediately.
+ */
+
+/* Rate used if none is configured (Hz) */
+#define DEFAULT_REDRAW_RATE	33.0
+
+struct redraw_source {
+	GSource base;
+	struct redraw_scheduler* sched;
+};
+
+
+static
+gboolean redraw_dispatch(GSource* source, GSourceFunc callback,
+                         gpointer user_data)
+{
+	struct redraw_scheduler* sched = ((struct redraw_source*)source)->sched;
+	gint64 now = g_source_get_time(source);
+	(void)callback;
+	(void)user_data;
+
+	// Too early since the previous frame: wait for the next slot
+	if (now < sched->next_frame) {
+		g_source_set_ready_time(source, sched->next_frame);
+		return TRUE;
+	}
+
+	// Requests from now on are not covered by this frame anymore
+	g_source_set_ready_time(source, -1);
+	g_atomic_int_set(&sched->pending, 0);
+
+	sched->next_frame = now + sched->interval;
+	sched->frame(sched->data);
+	return TRUE;
+}
+
+
+static
+GSourceFuncs redraw_source_funcs = {
+	.dispatch = redraw_dispatch,
+};
+
+
+/**
+ * redraw_scheduler_init() - create a scheduler of frames
+ * @sched:      scheduler to initialize
+ * @rate:       maximal rate of the frames in Hz (if not positive, a
+ *              default rate is used)
+ * @frame:      function run in the main loop to draw a frame
+ * @data:       argument passed to @frame
+ *
+ * No frame is run until one is requested.
+ */
+LOCAL_FN
+void redraw_scheduler_init(struct redraw_scheduler* sched, double rate,
+                           redraw_func frame, void* data)
+{
+	GSource* source;
+
+	source = g_source_new(&redraw_source_funcs,
+	                      sizeof(struct redraw_source));
+	((struct redraw_source*)source)->sched = sched;
+
+	sched->source = source;
+	sched->pending = 0;
+	sched->next_frame = 0;
+	sched->frame = frame;
+	sched->data = data;
+	redraw_scheduler_set_rate(sched, rate);
+
+	g_source_set_ready_time(source, -1);
+	g_source_attach(source, NULL);
+}
+
+
+/**
+ * redraw_scheduler_stop() - stop running frames
+ * @sched:      initialized scheduler
+ *
+ * This can be called from any thread. Requests are still allowed
+ * afterwards, but they have no effect.
+ */
+LOCAL_FN
+void redraw_scheduler_stop(struct redraw_scheduler* sched)
+{
+	if (sched->source)
+		g_source_destroy(sched->source);
+}
+
+
+/**
+ * redraw_scheduler_deinit() - release the resources of a scheduler
+ * @sched:      stopped scheduler (or zero-filled)
+ *
+ * Must be called once no thread can request a frame anymore.
+ */
+LOCAL_FN
+void redraw_scheduler_deinit(struct redraw_scheduler* sched)
+{
+	if (!sched->source)
+		return;
+
+	g_source_destroy(sched->source);
+	g_source_unref(sched->source);
+	sched->source = NULL;
+}
+
+
+/**
+ * redraw_scheduler_set_rate() - change the maximal rate of the frames
+ * @sched:      scheduler
+ * @rate:       maximal rate in Hz (if not positive, the default is used)
+ *
+ * Must be called from the main loop.
+ */
+LOCAL_FN
+void redraw_scheduler_set_rate(struct redraw_scheduler* sched, double rate)
+{
+	if (rate <= 0.0)
+		rate = DEFAULT_REDRAW_RATE;
+
+	sched->interval = (gint64)(G_USEC_PER_SEC / rate);
+}
+
+
+/**
+ * redraw_scheduler_request() - request a frame
+ * @sched:      scheduler (if NULL, nothing is done)
+ *
+ * This can be called from any thread and returns immediately. The frame
+ * runs as soon as allowed by the rate of the scheduler.
+ */
+LOCAL_FN
+void redraw_scheduler_request(struct redraw_scheduler* sched)
+{
+	if (!sched || !g_atomic_int_compare_and_exchange(&sched->pending, 0, 1))
+		return;
+
+	g_source_set_ready_time(sched->source, 0);
+}
+
+
+/**
+ * redraw_scheduler_request_at() - request a frame for a later time
+ * @sched:      scheduler
+ * @time:       monotonic time in microseconds at which the frame is needed
+ *
+ * This is used by frames that leave some work for later. It must be called
+ * from the main loop, and has no effect if an earlier frame is already
+ * scheduled.
+ */
+LOCAL_FN
+void redraw_scheduler_request_at(struct redraw_scheduler* sched, gint64 time)
+{
+	gint64 ready = g_source_get_ready_time(sched->source);
+
+	if (ready == -1 || time < ready)
+		g_source_set_ready_time(sched->source, time);
+}
@@ -0,0 +1,48 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef REDRAW_H
+#define REDRAW_H
+
+#include <glib.h>
+
+typedef void (*redraw_func)(void* data);
+
+/* Schedules the frames of the panel: a frame runs only if a redraw has been
+ * requested since the previous one, and no sooner than one interval after
+ * it */
+struct redraw_scheduler {
+	GSource* source;
+	volatile gint pending;
+	gint64 interval;
+	gint64 next_frame;
+	redraw_func frame;
+	void* data;
+};
+
+LOCAL_FN void redraw_scheduler_init(struct redraw_scheduler* sched,
+                                    double rate, redraw_func frame,
+                                    void* data);
+LOCAL_FN void redraw_scheduler_stop(struct redraw_scheduler* sched);
+LOCAL_FN void redraw_scheduler_deinit(struct redraw_scheduler* sched);
+LOCAL_FN void redraw_scheduler_set_rate(struct redraw_scheduler* sched,
+                                        double rate);
+LOCAL_FN void redraw_scheduler_request(struct redraw_scheduler* sched);
+LOCAL_FN void redraw_scheduler_request_at(struct redraw_scheduler* sched,
+                                          gint64 time);
+
+#endif /* REDRAW_H */
@@ -35,13 +35,53 @@ enum {
 struct scope_event {
 	int pos;
 	uint32_t type;
-	int drawn_once;
 };
 
+/* Batch of events added by a producer and not yet merged in the store */
+struct scope_evtbatch {
+	struct scope_evtbatch* next;
+	int nevent;
+	struct scope_event events[];
+};
+
+/* Displayed events binned in a pixel column. Up to EVTBIN_NTYPE types
+ * are counted separately, the others are accounted together. */
+#define EVTBIN_NTYPE	4
+struct scope_evtbin {
+	int count;
+	int ntype;
+	uint32_t types[EVTBIN_NTYPE];
+	int typecount[EVTBIN_NTYPE];
+	int other;
+};
+
+/* Font size of the event labels in points */
+#define EVT_LABEL_SIZE	6
+
+/* Number of rows in which event labels can be placed */
+#define EVT_LABEL_ROWS	3
+
+/* Minimal height in pixels of the row of a channel: if there are more
+ * channels than rows fitting in the scope, only a window of them is shown
+ * at once */
+#define MIN_ROW_HEIGHT	20
+
+/* Event of logical index i in the ring of events */
+#define EVENT_AT(self, i) \
+	((self)->events[((self)->evt_head + (i)) & ((self)->nevent_max - 1)])
+
 static void scope_calculate_drawparameters(Scope* self);
-static void scope_draw_samples(Scope* self, unsigned int first, unsigned int last);
+static void scope_calculate_rows(Scope* self);
+static void scope_update_vadjustment(Scope* self);
+static void scope_rasterize(PlotArea* area);
+static void scope_update_envelopes(Scope* self, unsigned int first, unsigned int last);
+static void scope_draw_events(Scope* self);
+static struct scope_evtbatch* scope_take_staged_events(Scope* self);
+static void scope_free_batches(struct scope_evtbatch* list);
 static gboolean scope_expose_event_callback(Scope *self, GdkEventExpose *event, gpointer data);
 static gboolean scope_configure_event_callback(Scope *self, GdkEventConfigure *event, gpointer data);
+static gboolean scope_scroll_event_callback(Scope *self, GdkEventScroll *event, gpointer data);
+static void scope_vadj_value_changed_callback(GtkAdjustment* adj, Scope* self);
 
 LOCAL_FN GType scope_get_type(void);
 G_DEFINE_TYPE (Scope, scope, TYPE_PLOT_AREA)
@@ -67,6 +107,7 @@ scope_set_property (GObject *object, guint property_id,
 {
 	Scope* self = SCOPE(object);
 
+	plot_area_lock_raster(PLOT_AREA(self));
 	switch (property_id) {
 	case SCALE_PROP:
 		self->phys_scale = (data_t)g_value_get_double(value);
@@ -76,10 +117,11 @@ scope_set_property (GObject *object, guint property_id,
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
 	}
 
-	if (gtk_widget_is_drawable(GTK_WIDGET(self))) {
+	if (gtk_widget_is_drawable(GTK_WIDGET(self)))
 		scope_calculate_drawparameters(self);
-		gtk_widget_queue_draw(GTK_WIDGET(self));
-	}
+	plot_area_unlock_raster(PLOT_AREA(self));
+
+	plot_area_invalidate_backing(PLOT_AREA(self));
 }
 
 static void
@@ -87,12 +129,18 @@ scope_finalize (GObject *object)
 {
 	Scope* self = SCOPE(object);
 
-	g_mutex_clear(&self->mtx);
-	
 	// Free allocted structures
+	scope_free_batches(scope_take_staged_events(self));
+	g_signal_handlers_disconnect_by_func(self->vadj,
+	                          scope_vadj_value_changed_callback, self);
+	g_object_unref(self->vadj);
 	g_free(self->ticks);
 	g_free(self->points);
 	g_free(self->events);
+	g_free(self->evtbins);
+	label_cache_deinit(&self->labels);
+	g_free(self->col_first);
+	g_free(self->envelopes);
 
 	// Call parent finalize function
 	if (G_OBJECT_CLASS (scope_parent_class)->finalize)
@@ -108,6 +156,7 @@ scope_class_init (ScopeClass *klass)
 //	object_class->get_property = scope_get_property;
 	object_class->set_property = scope_set_property;
 	object_class->finalize = scope_finalize;
+	PLOT_AREA_CLASS(klass)->rasterize = scope_rasterize;
 
 
 	g_object_class_install_property(G_OBJECT_CLASS(klass),
@@ -127,6 +176,9 @@ scope_init (Scope *self)
 {
 	// Initialize members
 	self->num_channels = 0;
+	self->first_row = 0;
+	self->num_rows = 0;
+	self->max_rows = 0;
 	self->num_ticks = 0;
 	self->num_points = 0;
 	self->phys_scale = (data_t)1;
@@ -134,18 +186,37 @@ scope_init (Scope *self)
 	self->data = NULL;
 	self->ticks = NULL;
 	self->points = NULL;
+	self->num_cols = 0;
+	self->col_first = NULL;
+	self->pyramid = NULL;
+	self->envelopes = NULL;
 	self->nevent = 0;
 	self->nevent_max = 0;
+	self->evt_head = 0;
 	self->events = NULL;
-	g_mutex_init(&self->mtx);
+	self->staged_events = NULL;
+	self->reset_pending = 0;
+	self->evtbins = NULL;
+	self->num_evtbins = 0;
+	self->evtbins_valid = FALSE;
+	label_cache_init(&self->labels, GTK_WIDGET(self));
 
-	plot_area_set_ticks(PLOT_AREA(self), self->num_ticks, self->num_channels);
+	plot_area_set_ticks(PLOT_AREA(self), self->num_ticks, self->num_rows);
+
+	// Adjustment over the channel rows
+	self->vadj = GTK_ADJUSTMENT(gtk_adjustment_new(0, 0, 0, 1, 1, 0));
+	g_object_ref_sink(self->vadj);
+	g_signal_connect(self->vadj, "value-changed",
+	                 G_CALLBACK(scope_vadj_value_changed_callback), self);
 
 	// Connect the handled signal
+	gtk_widget_add_events(GTK_WIDGET(self), GDK_SCROLL_MASK);
 	g_signal_connect_after(G_OBJECT(self), "configure_event",  
 	                  G_CALLBACK(scope_configure_event_callback), NULL);
 	g_signal_connect(G_OBJECT(self), "expose_event",  
 	                 G_CALLBACK(scope_expose_event_callback), NULL);
+	g_signal_connect(G_OBJECT(self), "scroll_event",
+	                 G_CALLBACK(scope_scroll_event_callback), NULL);
 }
 
 
@@ -164,159 +235,332 @@ gboolean scope_configure_event_callback (Scope *self,
 	(void)event;
 	(void)data;
 
+	plot_area_lock_raster(PLOT_AREA(self));
 	scope_calculate_drawparameters (self);
+	plot_area_unlock_raster(PLOT_AREA(self));
+	plot_area_invalidate_backing(PLOT_AREA(self));
+	scope_update_vadjustment(self);
 	return TRUE;
 }
 
 
+/**
+ * scope_scroll_event_callback() - scroll the channel rows with the wheel
+ * @self:       scope
+ * @event:      scroll event
+ * @data:       unused
+ *
+ * The shown rows move by half of a page.
+ */
+static
+gboolean scope_scroll_event_callback(Scope *self, GdkEventScroll *event,
+                                     gpointer data)
+{
+	gdouble value, step, max;
+	(void)data;
+
+	if (event->direction != GDK_SCROLL_UP
+	   && event->direction != GDK_SCROLL_DOWN)
+		return FALSE;
+
+	step = MAX(self->num_rows / 2, 1);
+	max = self->num_channels - self->num_rows;
+	value = gtk_adjustment_get_value(self->vadj);
+	value += (event->direction == GDK_SCROLL_UP) ? -step : step;
+	gtk_adjustment_set_value(self->vadj, CLAMP(value, 0, max));
+	return TRUE;
+}
+
+
+static
+void scope_vadj_value_changed_callback(GtkAdjustment* adj, Scope* self)
+{
+	GtkWidget* parent;
+	guint row = (guint)(gtk_adjustment_get_value(adj) + 0.5);
+
+	if (row == self->first_row)
+		return;
+
+	plot_area_lock_raster(PLOT_AREA(self));
+	self->first_row = row;
+	scope_calculate_rows(self);
+	plot_area_unlock_raster(PLOT_AREA(self));
+	plot_area_invalidate_backing(PLOT_AREA(self));
+
+	// The channel labels drawn by the parent follow the rows
+	parent = gtk_widget_get_parent(GTK_WIDGET(self));
+	if (parent)
+		gtk_widget_queue_draw(parent);
+}
+
+
+/**
+ * scope_update_vadjustment() - update the adjustment after a rows change
+ * @self:       scope
+ *
+ * Must be called without the raster lock held, since this may emit the
+ * value-changed signal of the adjustment.
+ */
+static
+void scope_update_vadjustment(Scope* self)
+{
+	gtk_adjustment_configure(self->vadj, self->first_row, 0,
+	                         self->num_channels, 1,
+	                         MAX(self->num_rows, 1), self->num_rows);
+}
+
+
 static gboolean
 scope_expose_event_callback (Scope *self,
                              GdkEventExpose *event,
                              gpointer data)
 {
 	(void)data;
-	unsigned int first, last, num_points;
-	int xmin, xmax, i, nrect;
-	GdkPoint* points = self->points;
-	GdkRectangle* rect;
-	
-	num_points = self->num_points;
-	if (num_points == 0)
+	PlotArea* area = PLOT_AREA(self);
+
+	if (self->num_points == 0)
 		return TRUE;
 
-	gdk_region_get_rectangles(event->region, &rect, &nrect);
-
-	for (i=0; i<nrect; i++) {
-		/* Determine which samples should redrawn */
-		xmin = rect[i].x;
-		xmax = rect[i].x + rect[i].width;
-		first=0;
-		while ((first<num_points-1) && (points[first+1].x < xmin))
-			first++;
-        
-		last=num_points-1;
-		while ((last>0) && (points[last-1].x > xmax))
-			last--;
-	
-		/* Redraw the region */
-		scope_draw_samples(self, first, last);
-	}
-	g_free(rect);
+	plot_area_blit_backing(area, event->region);
+
+	// Draw the overlays
+	plot_area_draw_cursor(area);
+	scope_draw_events(self);
 
 	return TRUE;
 }
 
 
+/**
+ * scope_draw_events() - draw the event markers on the window
+ * @self:       scope
+ *
+ * Markers are drawn from the displayed events binned per pixel column:
+ * several events in the same column are drawn as one wider marker split
+ * in segments whose length is proportional to the count of each type,
+ * and labeled with the number of events. Labels are placed in the lowest
+ * row where they do not overlap the previous ones, and dropped if there
+ * is none. Hence the cost depends on the width of the scope, not on the
+ * number of events.
+ */
 static
 void scope_draw_events(Scope* self)
 {
-	int i, x, slen, evwidth, evheight;
-	struct scope_event* events;
+	int x, xl, row, t, n, cum, y0, y1, ybot, evwidth, dominant;
+	int rowfree[EVT_LABEL_ROWS];
+	const struct scope_evtbin* bin;
 	PangoLayout* layout;
-	PangoContext* context;
-	PangoFontDescription* desc;
-	char eventcode[11];
-	GdkPoint* points = self->points;
+	char label[16];
 	GdkWindow* window = GTK_WIDGET(self)->window;
 	GdkGC* plotgc = PLOT_AREA(self)->plotgc;
 	const GdkColor *colors = PLOT_AREA(self)->colors;
 	int num_colors = PLOT_AREA(self)->nColors;
 	int height = GTK_WIDGET(self)->allocation.height;
+	int evheight = self->evt_label_height;
 	GdkRectangle rect = {0, 0, GTK_WIDGET(self)->allocation.width, GTK_WIDGET(self)->allocation.height};
 
-	g_mutex_lock(&self->mtx);
-
-	events = self->events;
-	if (!self->num_displayed_event)
-		goto exit;
+	if (!self->num_displayed_event || !self->evtbins_valid)
+		return;
 
-	// Setup pango context for small fonts
-	layout = gtk_widget_create_pango_layout(GTK_WIDGET(self), NULL);
-	context = gtk_widget_get_pango_context(GTK_WIDGET(self));
-	desc = pango_font_description_copy_static(pango_context_get_font_description(context));
-	pango_font_description_set_size(desc, 6 * PANGO_SCALE);
-	pango_layout_set_font_description(layout, desc);
 	gdk_gc_set_clip_rectangle(plotgc, &rect);
 
-	for (i = 0; i < self->num_displayed_event; i++) {
-		// Event code text
-		slen = sprintf(eventcode, "0x%x", events[i].type);
-		pango_layout_set_text(layout, eventcode, slen);
-		pango_layout_get_pixel_size(layout, &evwidth, &evheight);
+	for (row = 0; row < EVT_LABEL_ROWS; row++)
+		rowfree[row] = G_MININT;
+
+	ybot = height - evheight;
+	for (x = 0; x < (int)self->num_evtbins; x++) {
+		bin = self->evtbins + x;
+		if (!bin->count)
+			continue;
+
+		// Find the most frequent type
+		dominant = 0;
+		for (t = 1; t < bin->ntype; t++)
+			if (bin->typecount[t] > bin->typecount[dominant])
+				dominant = t;
+
+		if (bin->count == 1 && bin->ntype == 1) {
+			gdk_gc_set_foreground(plotgc, colors + bin->types[0] % num_colors);
+			gdk_draw_line(window, plotgc, x, 0, x, ybot);
+			sprintf(label, "0x%x", bin->types[0]);
+		} else {
+			// Split the marker among types, the types not counted
+			// separately being drawn with the grid color
+			y0 = cum = 0;
+			for (t = 0; t <= bin->ntype; t++) {
+				n = (t < bin->ntype) ? bin->typecount[t] : bin->other;
+				if (n <= 0)
+					continue;
+
+				cum += n;
+				y1 = (ybot * cum) / bin->count;
+				gdk_gc_set_foreground(plotgc, (t < bin->ntype)
+				                      ? colors + bin->types[t] % num_colors
+				                      : &(PLOT_AREA(self)->grid_color));
+				gdk_draw_rectangle(window, plotgc, TRUE,
+				                   x-1, y0, 3, y1 - y0);
+				y0 = y1;
+			}
+			sprintf(label, "[%d]", bin->count);
+		}
+
+		// Place the label in the lowest free row
+		layout = label_cache_get(&self->labels, label, EVT_LABEL_SIZE,
+		                         &evwidth, NULL);
+		xl = x - evwidth / 2;
+		for (row = 0; row < EVT_LABEL_ROWS; row++)
+			if (xl >= rowfree[row])
+				break;
+
+		if (row == EVT_LABEL_ROWS)
+			continue;
+
+		rowfree[row] = xl + evwidth + 1;
+		if (bin->ntype)
+			gdk_gc_set_foreground(plotgc, colors + bin->types[dominant] % num_colors);
+		gdk_draw_layout(window, plotgc, xl,
+		                height - (row+1)*evheight - 2, layout);
+	}
+}
+
+
+/**
+ * scope_raster_envelopes() - rasterize the decimated channels data
+ * @self:       scope with more samples than pixel columns
+ * @xmin:       first column to draw
+ * @xmax:       last column to draw
+ *
+ * Each shown channel is drawn as one vertical segment per column spanning
+ * its envelope in the column. Since the envelopes of adjacent columns meet
+ * at the middle of the line joining them, this covers the same pixels as
+ * the polyline going through all the samples.
+ */
+static
+void scope_raster_envelopes(Scope* self, gint xmin, gint xmax)
+{
+	PlotArea* area = PLOT_AREA(self);
+	unsigned int iRow, num_rows = self->num_rows;
+	const gint* offsets = area->yticks;
+	gint height = area->job_height;
+	data_t scale = self->scale;
+	const data_t* env;
+	guint32 color;
+	gint x, y1, y2;
+
+	xmin = CLAMP(xmin, 0, (gint)self->num_cols-1);
+	xmax = CLAMP(xmax, 0, (gint)self->num_cols-1);
+
+	for (iRow=0; iRow<num_rows; iRow++) {
+		color = area->job_colors[(self->first_row + iRow)
+		                         % area->job_ncolors];
+
+		// positive y points to bottom in the window basis, hence max
+		// is the top end
+		for (x = xmin; x <= xmax; x++) {
+			env = self->envelopes + 2*(x*num_rows + iRow);
+			y1 = CLAMP(offsets[iRow] - (gint)(scale*env[1]),
+			           0, height);
+			y2 = CLAMP(offsets[iRow] - (gint)(scale*env[0]),
+			           0, height);
+			raster_fill(&area->raster, x, y1, x, y2, color);
+		}
+	}
+}
+
+
+/**
+ * scope_get_draw_range() - get the columns affected by a range of samples
+ * @self:       scope
+ * @first:      pointer to index of the first sample of the range, updated
+ *              to the first sample to draw
+ * @last:       index of the last sample of the range
+ * @xmin:       pointer to the first affected column
+ * @xmax:       pointer to the last affected column
+ *
+ * In full resolution, the line joining the sample before the range and
+ * the previous column must be drawn as well. With decimation, the
+ * envelopes of the columns adjacent to the range are affected.
+ */
+static
+void scope_get_draw_range(Scope* self, unsigned int* first,
+                          unsigned int last, gint* xmin, gint* xmax)
+{
+	GdkPoint* points = self->points;
+	unsigned int nlast = self->num_points - 1;
+	unsigned int i = *first;
 
-		x = points[(events[i].pos - self->ns_offset) % self->num_points].x;
-		gdk_gc_set_foreground(plotgc, colors + events[i].type % num_colors);
-		gdk_draw_line(window, plotgc, x, 0, x, height - evheight);
-		gdk_draw_layout(window, plotgc, x - evwidth / 2, height - evheight - 2, layout);
+	if (self->num_cols) {
+		*xmin = points[i ? i-1 : 0].x;
+		*xmax = points[last < nlast ? last+1 : nlast].x;
+		return;
 	}
 
-	g_object_unref(layout);
-	pango_font_description_free(desc);
+	// Find the position of the first sample
+	while ((i>0) && (points[*first].x == points[i].x))
+		i--;
+
+	*xmin = points[i].x;
+	*xmax = points[last].x;
 
-exit:
-	g_mutex_unlock(&self->mtx);
+	// The line from the previous sample crosses the first column
+	*first = (i > 0) ? i-1 : 0;
 }
 
 
+/**
+ * scope_raster_samples() - render the grid and data of a range of samples
+ * @self:       scope
+ * @first:      index of the first sample to render
+ * @last:       index of the last sample to render
+ *
+ * The columns affected by the samples are cleared before being rendered
+ * in the raster of the scope. Only the shown rows are converted and drawn.
+ * Must be called with the raster lock held.
+ */
 static void
-scope_draw_samples(Scope* self, unsigned int first, unsigned int last)
+scope_raster_samples(Scope* self, unsigned int first, unsigned int last)
 {
-	unsigned int iChannel, iSample, iColor, num_channels, nColors;
+	PlotArea* area = PLOT_AREA(self);
+	struct raster* r = &area->raster;
+	unsigned int iRow, iChannel, iSample, num_channels;
 	GdkPoint* points = self->points;
-	const gint* offsets = PLOT_AREA(self)->yticks;
-	const gint* xticks = PLOT_AREA(self)->xticks;
+	const gint* offsets = area->yticks;
+	const gint* xticks = area->xticks;
 	gint xmin, xmax, value, height;
 	data_t scale = self->scale;
 	const data_t* data = self->data;
 	unsigned int i;
-	const GdkColor *grid_color, *colors;
-	GdkWindow* window = GTK_WIDGET(self)->window;
-	GdkGC* plotgc = PLOT_AREA(self)->plotgc;
 
-	nColors = PLOT_AREA(self)->nColors;
-	colors = PLOT_AREA(self)->colors;
-	grid_color = &(PLOT_AREA(self)->grid_color);
-	height = GTK_WIDGET(self)->allocation.height;
+	height = area->job_height;
 	num_channels = self->num_channels;	
 
-	// Find the position of the first sample
-	xmin = points[first].x;
-	while ((first>0) && (xmin == points[first].x))
-		first--;
-
-	xmin = points[first].x;
-	xmax = points[last].x;
+	scope_get_draw_range(self, &first, last, &xmin, &xmax);
+	raster_fill(r, xmin, 0, xmax, height-1, area->job_bg);
+	plot_area_mark_dirty(area, xmin, xmax);
 
 	// draw grid
-	gdk_gc_set_foreground ( plotgc, grid_color );
-	for (i=0; i<num_channels; i++) {
-		gdk_draw_line(window,
-				plotgc,
-				xmin,
-				offsets[i],
-				xmax,
-				offsets[i]);
-	}
+	for (i=0; i<self->num_rows; i++)
+		raster_fill(r, xmin, offsets[i], xmax, offsets[i],
+		            area->job_grid);
 	for (i=0; i<self->num_ticks; i++) {
 		if ((xticks[i]>=xmin) && (xticks[i]<=xmax))
-			gdk_draw_line(window,
-					plotgc,
-					xticks[i],
-					0,
-					xticks[i],
-					height);
+			raster_fill(r, xticks[i], 0, xticks[i], height,
+			            area->job_grid);
 	}
 
 	if (data == NULL)
 		return;
 
-
 	// Draw the channels data
-	for (iChannel=0; iChannel<num_channels; iChannel++) {
+	if (self->num_cols)
+		scope_raster_envelopes(self, xmin, xmax);
+	else for (iRow=0; iRow<self->num_rows; iRow++) {
+		iChannel = self->first_row + iRow;
+
 		// Convert data_t values into y coordinate
 		// (positive y points to bottom in the window basis) 
 		for (iSample=first; iSample<=last; iSample++) {
-			value = offsets[iChannel] - 
+			value = offsets[iRow] - 
 				(gint)(scale*data[iSample*num_channels+iChannel]);
 			if (value < 0)
 				value = 0;
@@ -326,82 +570,236 @@ scope_draw_samples(Scope* self, unsigned int first, unsigned int last)
 			points[iSample].y = value;
 		}
 
-		// Draw calculated lines
-		iColor = iChannel % nColors;
-		gdk_gc_set_foreground ( plotgc,	colors + iColor );
-		gdk_draw_lines (window,
-		                plotgc,
-				points + first,
-				last - first + 1);
+		raster_lines(r, points + first, last - first + 1,
+		             area->job_colors[iChannel % area->job_ncolors]);
 	}
+}
 
-	// Draw the scanline
-	gdk_draw_line(window,
-			GTK_WIDGET(self)->style->fg_gc[gtk_widget_get_state(GTK_WIDGET(self))],
-			points[self->current_pointer].x,
-			0,
-			points[self->current_pointer].x,
-			height - 1);
 
-	scope_draw_events(self);
+/**
+ * scope_rasterize() - render the samples updated since the previous job
+ * @area:       scope whose raster lock is held
+ *
+ * This runs on a worker thread: the envelopes of the updated columns are
+ * computed here as well, since this is the costly part with high density
+ * data.
+ */
+static
+void scope_rasterize(PlotArea* area)
+{
+	Scope* self = SCOPE(area);
+	unsigned int from = area->job_from, to = area->job_to;
+	unsigned int nlast = self->num_points - 1;
+
+	if (self->num_points == 0 || to > nlast)
+		return;
+
+	if (area->job_full) {
+		scope_update_envelopes(self, 0, nlast);
+		scope_raster_samples(self, 0, nlast);
+	} else if (from <= to) {
+		scope_update_envelopes(self, from, to);
+		scope_raster_samples(self, from, to);
+	} else {
+		scope_update_envelopes(self, from, nlast);
+		scope_update_envelopes(self, 0, to);
+		scope_raster_samples(self, from, nlast);
+		scope_raster_samples(self, 0, to);
+	}
+
+	area->raster_cursor = self->points[to].x;
 }
 
 
 static
 void scope_calculate_evt_label_width(Scope* self)
 {
-	int evwidth, evheight;
-	PangoLayout* layout;
-	PangoContext* context;
-	PangoFontDescription* desc;
+	label_cache_get(&self->labels, "0xFFFFFFFF", EVT_LABEL_SIZE,
+	                &self->evt_label_width, &self->evt_label_height);
+}
 
-	// Setup pango context for small fonts
-	layout = gtk_widget_create_pango_layout(GTK_WIDGET(self), NULL);
-	context = gtk_widget_get_pango_context(GTK_WIDGET(self));
-	desc = pango_font_description_copy_static(pango_context_get_font_description(context));
-	pango_font_description_set_size(desc, 6 * PANGO_SCALE);
-	pango_layout_set_font_description(layout, desc);
 
-	pango_layout_set_text(layout, "0xFFFFFFFF", -1);
-	pango_layout_get_pixel_size(layout, &evwidth, &evheight);
+/**
+ * scope_update_envelopes() - update the envelopes after a data change
+ * @self:       scope
+ * @first:      index of the first modified sample
+ * @last:       index of the last modified sample
+ *
+ * The envelope of a channel in a pixel column is the range of values of
+ * the polyline joining the samples in this column: the samples drawn in
+ * the column and the midpoints of the lines joining them to the samples
+ * of the adjacent columns. The range of the samples is obtained from the
+ * min/max pyramid of the data if any, hence the cost does not depend on
+ * the number of samples per column. Only the envelopes of the shown rows
+ * are computed.
+ */
+static
+void scope_update_envelopes(Scope* self, unsigned int first,
+                            unsigned int last)
+{
+	unsigned int c, c0, c1, s0, s1, j, ch;
+	unsigned int nch = self->num_channels;
+	unsigned int nrow = self->num_rows;
+	unsigned int ch0 = self->first_row;
+	unsigned int nlast = self->num_points - 1;
+	const data_t* data = self->data;
+	const struct minmax_pyramid* pyr = self->pyramid;
+	data_t* env;
+	data_t v;
 
-	g_object_unref(layout);
-	pango_font_description_free(desc);
+	if (!self->num_cols || !data)
+		return;
 
-	self->evt_label_width = evwidth;
+	// Use the pyramid only if it matches the data
+	if (pyr && (pyr->nch != nch || pyr->ns != self->num_points))
+		pyr = NULL;
+
+	// A sample also affects the midpoints in the adjacent columns
+	c0 = self->points[first ? first-1 : 0].x;
+	c1 = self->points[last < nlast ? last+1 : nlast].x;
+
+	for (c = c0; c <= c1; c++) {
+		s0 = self->col_first[c];
+		s1 = self->col_first[c+1] - 1;
+		pyramid_query(pyr, data, nch, ch0, nrow, s0, s1,
+		              self->envelopes + 2*c*nrow);
+
+		for (j = 0; j < nrow; j++) {
+			env = self->envelopes + 2*(c*nrow + j);
+			ch = ch0 + j;
+
+			if (s0 > 0) {
+				v = 0.5f*(data[(s0-1)*nch + ch] + data[s0*nch + ch]);
+				env[0] = MIN(env[0], v);
+				env[1] = MAX(env[1], v);
+			}
+
+			if (s1 < nlast) {
+				v = 0.5f*(data[s1*nch + ch] + data[(s1+1)*nch + ch]);
+				env[0] = MIN(env[0], v);
+				env[1] = MAX(env[1], v);
+			}
+		}
+	}
 }
 
 
+/**
+ * scope_calculate_envelopes_layout() - setup the decimation of the data
+ * @self:       scope whose x coordinates of the points have been computed
+ * @width:      width of the scope in pixels
+ *
+ * Decimation is used only if there are more samples than pixel columns,
+ * so that each column contains at least one sample.
+ */
 static
-void scope_calculate_drawparameters(Scope* self)
+void scope_calculate_envelopes_layout(Scope* self, unsigned int width)
 {
-	guint height, width;
-	unsigned int num_ch, i, num_points;
-	gint* offsets = PLOT_AREA(self)->yticks;
-	gint* xticks = PLOT_AREA(self)->xticks;
+	unsigned int c, i, num_points = self->num_points;
 
-	num_ch = self->num_channels;
-	num_points = self->num_points;
+	g_free(self->col_first);
+	g_free(self->envelopes);
+	self->col_first = NULL;
+	self->envelopes = NULL;
+	self->num_cols = 0;
 
-	width = GTK_WIDGET(self)->allocation.width;
-	height = GTK_WIDGET(self)->allocation.height;
+	if (width == 0 || num_points <= width+1)
+		return;
+
+	// x coordinates of the points span [0, width]
+	self->num_cols = width+1;
+	self->col_first = g_malloc((self->num_cols+1)*sizeof(*self->col_first));
+	self->envelopes = g_malloc0(2*self->num_cols*self->num_rows
+	                            *sizeof(*self->envelopes));
+
+	for (c = 0, i = 0; c < self->num_cols; c++) {
+		self->col_first[c] = i;
+		while (i < num_points && self->points[i].x == (gint)c)
+			i++;
+	}
+	self->col_first[self->num_cols] = num_points;
+}
+
+
+/**
+ * scope_calculate_rows() - setup the rows of the shown channels
+ * @self:       scope
+ *
+ * The height of the scope is divided in rows of at least MIN_ROW_HEIGHT
+ * pixels, and in no more than @self->max_rows rows if set. If they cannot
+ * hold all the channels, only the channels from
+ * @self->first_row are shown. Since the envelopes are computed only for
+ * the shown rows, a full render must follow a change of the rows.
+ */
+static
+void scope_calculate_rows(Scope* self)
+{
+	guint height = GTK_WIDGET(self)->allocation.height;
+	unsigned int i, num_rows;
+	gint* offsets;
+
+	num_rows = MAX(height / MIN_ROW_HEIGHT, 1);
+	if (self->max_rows)
+		num_rows = MIN(num_rows, self->max_rows);
+	num_rows = MIN(num_rows, self->num_channels);
+	if (num_rows != self->num_rows) {
+		self->num_rows = num_rows;
+		plot_area_set_ticks(PLOT_AREA(self), self->num_ticks, num_rows);
+	}
+
+	self->first_row = MIN(self->first_row, self->num_channels - num_rows);
+	PLOT_AREA(self)->first_ytick = self->first_row;
 
 	// calculate scaling_factor;
-	self->scale = num_ch ? ((data_t)height)/(self->phys_scale * (data_t)num_ch) : 1;
+	self->scale = num_rows ? ((data_t)height)/(self->phys_scale * (data_t)num_rows) : 1;
 
 	/* Calculate y offsets */
-	for (i=0; i<num_ch; i++)
-		offsets[i] = (gint)((float)(height*(2*i+1)) / (float)(2*num_ch));
+	offsets = PLOT_AREA(self)->yticks;
+	for (i=0; i<num_rows; i++)
+		offsets[i] = (gint)((float)(height*(2*i+1)) / (float)(2*num_rows));
+}
+
+
+static
+void scope_calculate_drawparameters(Scope* self)
+{
+	guint width;
+	unsigned int i, num_points;
+	gint* xticks;
+
+	num_points = self->num_points;
+	width = GTK_WIDGET(self)->allocation.width;
+
+	scope_calculate_rows(self);
+	xticks = PLOT_AREA(self)->xticks;
 
 	/* Calculate x coordinates*/
 	for (i=0; i<num_points; i++)
 		self->points[i].x = (gint)( ((float)(i*width))/(float)(num_points-1) );
+	scope_calculate_envelopes_layout(self, width);
 
 	// Set the ticks position
 	for (i=0; i<self->num_ticks; i++)
 		xticks[i] = (num_points > (unsigned int) self->ticks[i]) ? self->points[self->ticks[i]].x : -1;
 
 	scope_calculate_evt_label_width(self);
+
+	// One event bin per pixel column
+	if (self->num_evtbins != width+1) {
+		g_free(self->evtbins);
+		self->num_evtbins = width+1;
+		self->evtbins = g_malloc0(self->num_evtbins*sizeof(*self->evtbins));
+	}
+	self->evtbins_valid = FALSE;
+}
+
+
+static
+int scope_event_x(const Scope* self, const struct scope_event* evt)
+{
+	int n = self->num_points;
+
+	return self->points[((evt->pos - self->ns_offset) % n + n) % n].x;
 }
 
 
@@ -409,16 +807,14 @@ static
 void scope_queue_event_draw(Scope* self, const struct scope_event* evt)
 {
 	GdkRectangle rect;
-	int x;
 
 	if (!gtk_widget_is_drawable(GTK_WIDGET(self)))
 		return;
 
-	x = self->points[(evt->pos - self->ns_offset) % self->num_points].x;
-
-	rect.x = x - self->evt_label_width/2;
+	// The marker may be aggregated with others in a wider one
+	rect.x = scope_event_x(self, evt) - 1;
 	rect.y = 0;
-	rect.width = self->evt_label_width;
+	rect.width = 3;
 	rect.height = GTK_WIDGET(self)->allocation.height;
 
 	gdk_window_invalidate_rect(gtk_widget_get_window(GTK_WIDGET(self)),
@@ -426,85 +822,293 @@ void scope_queue_event_draw(Scope* self, const struct scope_event* evt)
 }
 
 
+/**
+ * scope_queue_labels_draw() - queue a redraw of the event labels
+ * @self:       scope
+ *
+ * Since the label placement depends on the neighbour markers, a change
+ * of the displayed events may affect all labels.
+ */
+static
+void scope_queue_labels_draw(Scope* self)
+{
+	GdkRectangle rect;
+	int height = GTK_WIDGET(self)->allocation.height;
+
+	if (!gtk_widget_is_drawable(GTK_WIDGET(self)))
+		return;
+
+	rect.x = 0;
+	rect.width = GTK_WIDGET(self)->allocation.width;
+	rect.height = MIN(EVT_LABEL_ROWS*self->evt_label_height + 2, height);
+	rect.y = height - rect.height;
+
+	gdk_window_invalidate_rect(gtk_widget_get_window(GTK_WIDGET(self)),
+	                           &rect, FALSE);
+}
+
+
+/**
+ * scope_bin_event() - add or remove a displayed event in its column bin
+ * @self:       scope
+ * @evt:        displayed event
+ * @inc:        1 to add, -1 to remove
+ */
+static
+void scope_bin_event(Scope* self, const struct scope_event* evt, int inc)
+{
+	struct scope_evtbin* bin;
+	int x, t;
+
+	if (!self->evtbins)
+		return;
+
+	x = scope_event_x(self, evt);
+	if (x < 0 || x >= (int)self->num_evtbins)
+		return;
+
+	bin = self->evtbins + x;
+	bin->count += inc;
+	if (bin->count <= 0) {
+		memset(bin, 0, sizeof(*bin));
+		return;
+	}
+
+	for (t = 0; t < bin->ntype; t++)
+		if (bin->types[t] == evt->type)
+			break;
+
+	if (t == bin->ntype && t < EVTBIN_NTYPE && inc > 0) {
+		bin->types[t] = evt->type;
+		bin->typecount[t] = 0;
+		bin->ntype++;
+	}
+
+	if (t < bin->ntype) {
+		bin->typecount[t] += inc;
+		if (bin->typecount[t] <= 0) {
+			bin->ntype--;
+			bin->types[t] = bin->types[bin->ntype];
+			bin->typecount[t] = bin->typecount[bin->ntype];
+		}
+	} else {
+		bin->other += inc;
+	}
+}
+
+
+static
+void scope_rebuild_evtbins(Scope* self)
+{
+	int i;
+
+	if (!self->evtbins)
+		return;
+
+	memset(self->evtbins, 0, self->num_evtbins*sizeof(*self->evtbins));
+	for (i = 0; i < self->num_displayed_event; i++)
+		scope_bin_event(self, &EVENT_AT(self, i), 1);
+
+	self->evtbins_offset = self->ns_offset;
+	self->evtbins_valid = TRUE;
+}
+
+
+/**
+ * DOC: Event store
+ *
+ * The events of a scope are kept in a ring sorted by position, so that
+ * the outdated events are removed from its head in constant time. Events
+ * are inserted at the position found by binary search, which is the tail
+ * of the ring if they are added in chronological order.
+ *
+ * The store is only accessed from the main loop. scope_add_events() may be
+ * called from any thread: it only pushes the events in a lock-free stack
+ * of batches, which the main loop merges in the store at the next update.
+ * Hence adding events never waits for the rendering.
+ */
+
+static
+struct scope_evtbatch* scope_take_staged_events(Scope* self)
+{
+	struct scope_evtbatch* list;
+
+	do {
+		list = g_atomic_pointer_get(&self->staged_events);
+	} while (list && !g_atomic_pointer_compare_and_exchange(
+	                               &self->staged_events, list, NULL));
+
+	return list;
+}
+
+
+static
+void scope_free_batches(struct scope_evtbatch* list)
+{
+	struct scope_evtbatch* next;
+
+	for (; list; list = next) {
+		next = list->next;
+		g_free(list);
+	}
+}
+
+
+/**
+ * scope_count_events_until() - count the events up to a position
+ * @self:       scope
+ * @pos:        position
+ *
+ * Return: the number of events in the store whose position is not greater
+ * than @pos
+ */
+static
+int scope_count_events_until(const Scope* self, int pos)
+{
+	int lo = 0, hi = self->nevent, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (EVENT_AT(self, mid).pos <= pos)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+
+/**
+ * scope_insert_event() - insert an event in the store
+ * @self:       scope
+ * @evt:        event to insert
+ *
+ * An event is inserted after the events at the same position, hence their
+ * order of addition is kept.
+ *
+ * Return: the index of the inserted event
+ */
+static
+int scope_insert_event(Scope* self, const struct scope_event* evt)
+{
+	struct scope_event* events;
+	int i, at, cap;
+
+	// Grow the ring by a factor 2, keeping its size a power of 2
+	if (self->nevent == self->nevent_max) {
+		cap = self->nevent_max ? 2*self->nevent_max : 64;
+		events = g_malloc(cap*sizeof(*events));
+		for (i = 0; i < self->nevent; i++)
+			events[i] = EVENT_AT(self, i);
+
+		g_free(self->events);
+		self->events = events;
+		self->nevent_max = cap;
+		self->evt_head = 0;
+	}
+
+	at = scope_count_events_until(self, evt->pos);
+	for (i = self->nevent; i > at; i--)
+		EVENT_AT(self, i) = EVENT_AT(self, i-1);
+
+	EVENT_AT(self, at) = *evt;
+	self->nevent++;
+	return at;
+}
+
+
 static
 void scope_update_events(Scope* self, int ns_total)
 {
-	int i, first, discard_lim;
-	struct scope_event* events = self->events;
+	struct scope_evtbatch *list, *batch, *prev;
+	int i, first, last, discard_lim, changed = 0;
+	const struct scope_event* evt;
+
+	if (g_atomic_int_compare_and_exchange(&self->reset_pending, 1, 0)) {
+		self->nevent = 0;
+		self->evt_head = 0;
+		self->ns_total = 0;
+		self->num_displayed_event = 0;
+		self->evtbins_valid = FALSE;
+		changed = 1;
+	}
 
-	g_mutex_lock(&self->mtx);
+	// Events become displayed as ns_total passes their position
+	first = self->num_displayed_event;
 	self->ns_total = ns_total;
 	self->ns_offset = (ns_total - self->current_pointer) % self->num_points;
 
-	// Find the index of first event not outdated
+	// The column of the events changes only if the data is reset
+	if (self->ns_offset != self->evtbins_offset)
+		self->evtbins_valid = FALSE;
+
+	// Remove outdated events from the head
 	discard_lim = ns_total - self->num_points;
-	for (first = 0; first < self->nevent; first++) {
-		if (events[first].pos > discard_lim) {
-			break;
+	while (self->nevent && EVENT_AT(self, 0).pos <= discard_lim) {
+		if (first > 0) {
+			scope_bin_event(self, &EVENT_AT(self, 0), -1);
+			first--;
 		}
+		self->evt_head = (self->evt_head + 1) & (self->nevent_max - 1);
+		self->nevent--;
+		changed = 1;
 	}
 
-	// Remove events before first
-	if (first > 0) {
-		self->nevent -= first;
-		memmove(events, events + first, self->nevent * sizeof(*events));
+	// queue a draw of the newly displayed events
+	last = scope_count_events_until(self, ns_total);
+	for (i = first; i < last; i++) {
+		scope_bin_event(self, &EVENT_AT(self, i), 1);
+		scope_queue_event_draw(self, &EVENT_AT(self, i));
+		changed = 1;
 	}
 
-	// Find the number of event that can be displayed
-	for (i = 0; i < self->nevent; i++) {
-		if (events[i].pos > ns_total)
-			break;
-
-		// queue a draw if it is new
-		if (!events[i].drawn_once) {
-			scope_queue_event_draw(self, &events[i]);
-			events[i].drawn_once = 1;
+	// Merge the staged batches in the order they have been added (the
+	// stack holds the most recent first)
+	list = scope_take_staged_events(self);
+	for (prev = NULL; list; list = batch) {
+		batch = list->next;
+		list->next = prev;
+		prev = list;
+	}
+	for (batch = prev; batch; batch = batch->next) {
+		for (i = 0; i < batch->nevent; i++) {
+			evt = &batch->events[i];
+			if (evt->pos <= discard_lim)
+				continue;
+
+			scope_insert_event(self, evt);
+			if (evt->pos <= ns_total) {
+				scope_bin_event(self, evt, 1);
+				scope_queue_event_draw(self, evt);
+				changed = 1;
+			}
 		}
 	}
-	self->num_displayed_event = i;
+	scope_free_batches(prev);
+
+	self->num_displayed_event = scope_count_events_until(self, ns_total);
+	if (!self->evtbins_valid)
+		scope_rebuild_evtbins(self);
 
-	g_mutex_unlock(&self->mtx);
+	if (changed)
+		scope_queue_labels_draw(self);
 }
 
 
 LOCAL_FN
 void scope_update_data(Scope* self, guint pointer, int ns_total)
 {
-	int first, last;
-	GdkRectangle rect[2];
-	int combine = 0;
-	//GdkWindow* window;
-	GdkPoint* points;
-	GdkRegion* region;
-
 	if (!self || !self->num_points)
 		return;
 
-	if (gtk_widget_is_drawable(GTK_WIDGET(self))) {
-		points  = self->points;
-
-		// Set the region that should be redrawn 
-		first = self->current_pointer ? self->current_pointer -1 : 0;
-		last = pointer;
-		if (pointer < self->current_pointer) {
-			rect[1].x = points[first].x-1;
-			rect[1].width = points[self->num_points-1].x - rect[1].x+1;
-			first = 0;
-			combine++;
-		}
-		rect[0].y = rect[1].y = 0;
-		rect[0].height = rect[1].height = GTK_WIDGET(self)->allocation.height;
-		rect[0].x = points[first].x-1;
-		rect[0].width = points[last].x - rect[0].x+1;
-
-		// Repaint
-		region = gdk_region_rectangle(&rect[0]);
-		if (combine)
-			gdk_region_union_with_rect(region, &rect[1]);
-		gdk_window_invalidate_region(gtk_widget_get_window(GTK_WIDGET(self)),
-					     region, FALSE);
-		gdk_region_destroy(region);
-	}
+	// If the scope has not been updated for more than a turn of the
+	// ring, eg while its tab was hidden, all samples have been updated
+	if (ns_total - self->ns_total >= (int)self->num_points)
+		plot_area_invalidate_backing(PLOT_AREA(self));
+
+	// Samples from the previous pointer have been updated
+	plot_area_update_pointer(PLOT_AREA(self), pointer, self->num_points);
 
 	self->current_pointer = pointer;
 	scope_update_events(self, ns_total);
@@ -518,8 +1122,10 @@ void scope_set_data(Scope* self, data_t* data, guint num_points, guint num_ch)
 	if (self==NULL)
 		return;
 
+	plot_area_lock_raster(PLOT_AREA(self));
 	self->data = data;
 	self->current_pointer = 0;
+	PLOT_AREA(self)->pointer = 0;
 
 	if (num_points != self->num_points) {
 		g_free(self->points);
@@ -530,89 +1136,151 @@ void scope_set_data(Scope* self, data_t* data, guint num_points, guint num_ch)
 
 	if (self->num_channels != num_ch) {
 		self->num_channels = num_ch;
-		plot_area_set_ticks(PLOT_AREA(self), self->num_ticks, self->num_channels);
 		has_changed = 1;
 	}
 
-	if (has_changed) {
+	if (has_changed)
 		scope_calculate_drawparameters(self);
-	}
+	plot_area_unlock_raster(PLOT_AREA(self));
+
+	plot_area_invalidate_backing(PLOT_AREA(self));
+	if (has_changed)
+		scope_update_vadjustment(self);
 	if (gtk_widget_is_drawable(GTK_WIDGET(self)))
 		gtk_widget_queue_draw(GTK_WIDGET(self));
 }
 
 
+/**
+ * scope_set_pyramid() - set the min/max pyramid of the data of the scope
+ * @self:       scope
+ * @pyramid:    pyramid kept up to date with the data passed to
+ *              scope_set_data() (NULL if none)
+ *
+ * The pyramid is used only while its geometry matches the one of the
+ * data. It must be updated before scope_set_data() or scope_update_data()
+ * are called.
+ */
 LOCAL_FN
-void scope_add_events(Scope* self, int nevent, const struct mcp_event* added_events)
+void scope_set_pyramid(Scope* self, const struct minmax_pyramid* pyramid)
 {
-	int i, insert_at;
-	struct scope_event evt;
-	struct scope_event* events;
-
 	if (self == NULL)
 		return;
 
-	g_mutex_lock(&self->mtx);
-
-	// Realloc if necessary
-	if (nevent + self->nevent > self->nevent_max) {
-		self->nevent_max = nevent + self->nevent;
-		self->events = g_realloc(self->events, self->nevent_max*sizeof(*events));
-	}
+	plot_area_lock_raster(PLOT_AREA(self));
+	self->pyramid = pyramid;
+	plot_area_unlock_raster(PLOT_AREA(self));
+}
 
-	// Add event while respecting chronological order
-	events = self->events;
-	for (i = 0; i < nevent; i++) {
-		evt.pos = added_events[i].pos;
-		evt.type = added_events[i].type;
-		evt.drawn_once = 0;
 
-		// Discard event that are already outdated
-		if (evt.pos < self->ns_total - (int)self->num_points)
-			continue;
+/**
+ * scope_add_events() - add events to display
+ * @self:       scope
+ * @nevent:     number of events
+ * @added_events: events to add, positioned in the displayed samples
+ *
+ * This can be called from any thread and never waits for the main loop:
+ * the events are merged at the next update of the scope.
+ */
+LOCAL_FN
+void scope_add_events(Scope* self, int nevent, const struct mcp_event* added_events)
+{
+	struct scope_evtbatch* batch;
+	int i;
 
-		for (insert_at = 0; insert_at < self->nevent; insert_at++) {
-			if (events[insert_at].pos > evt.pos)
-				break;
-		}
+	if (self == NULL || nevent <= 0)
+		return;
 
-		// Insert evt at the position found
-		memmove(events+insert_at+1, events+insert_at,
-		        (self->nevent - insert_at)*sizeof(*events));
-		events[insert_at] = evt;
-		self->nevent++;
-		if (evt.pos < self->ns_total)
-			self->num_displayed_event++;
+	batch = g_malloc(sizeof(*batch) + nevent*sizeof(batch->events[0]));
+	batch->nevent = nevent;
+	for (i = 0; i < nevent; i++) {
+		batch->events[i].pos = added_events[i].pos;
+		batch->events[i].type = added_events[i].type;
 	}
 
-	g_mutex_unlock(&self->mtx);
+	do {
+		batch->next = g_atomic_pointer_get(&self->staged_events);
+	} while (!g_atomic_pointer_compare_and_exchange(&self->staged_events,
+	                                                batch->next, batch));
 }
 
 
+/**
+ * scope_reset_events() - remove all events
+ * @self:       scope
+ *
+ * This can be called from any thread. The events added before are
+ * discarded, the store is cleared at the next update of the scope.
+ */
 LOCAL_FN
 void scope_reset_events(Scope* self)
 {
 	if (self == NULL)
 		return;
 
-	g_mutex_lock(&self->mtx);
-	self->nevent = 0;
-	self->ns_total = 0;
-	g_mutex_unlock(&self->mtx);
+	g_atomic_int_set(&self->reset_pending, 1);
+	scope_free_batches(scope_take_staged_events(self));
 }
 
 
-
 LOCAL_FN
 void scope_set_ticks(Scope* self, guint num_ticks, guint* ticks)
 {
+	plot_area_lock_raster(PLOT_AREA(self));
 	if (num_ticks != self->num_ticks) {
 		g_free(self->ticks);
 		self->ticks = g_malloc(num_ticks*sizeof(*(self->ticks)));
 		self->num_ticks = num_ticks;
-		plot_area_set_ticks(PLOT_AREA(self), self->num_ticks, self->num_channels);
+		plot_area_set_ticks(PLOT_AREA(self), self->num_ticks, self->num_rows);
 	}
 
 	memcpy(self->ticks, ticks, num_ticks*sizeof(*(self->ticks)));	
 	scope_calculate_drawparameters(self);
+	plot_area_unlock_raster(PLOT_AREA(self));
+
+	plot_area_invalidate_backing(PLOT_AREA(self));
+}
+
+
+/**
+ * scope_get_vadjustment() - get the adjustment of the shown channel rows
+ * @self:       scope
+ *
+ * The value of the adjustment is the first shown channel and its page
+ * size is the number of shown channels. It can be attached to a scrollbar.
+ *
+ * Return: the adjustment, owned by @self
+ */
+LOCAL_FN
+GtkAdjustment* scope_get_vadjustment(Scope* self)
+{
+	return self->vadj;
+}
+
+
+/**
+ * scope_set_max_rows() - limit the number of channels shown at once
+ * @self:       scope
+ * @max_rows:   maximal number of rows, 0 for no limit other than the
+ *              minimal height of the rows
+ */
+LOCAL_FN
+void scope_set_max_rows(Scope* self, guint max_rows)
+{
+	GtkWidget* parent;
+
+	if (max_rows == self->max_rows)
+		return;
+
+	plot_area_lock_raster(PLOT_AREA(self));
+	self->max_rows = max_rows;
+	scope_calculate_drawparameters(self);
+	plot_area_unlock_raster(PLOT_AREA(self));
+	plot_area_invalidate_backing(PLOT_AREA(self));
+	scope_update_vadjustment(self);
+
+	// The channel labels drawn by the parent follow the rows
+	parent = gtk_widget_get_parent(GTK_WIDGET(self));
+	if (parent)
+		gtk_widget_queue_draw(parent);
 }
@@ -20,9 +20,12 @@
 
 #include <glib-object.h>
 #include <glib.h>
+#include <gtk/gtk.h>
 #include "plot-area.h"
+#include "labelcache.h"
 #include "plottk-types.h"
 #include "mcpanel.h"
+#include "pyramid.h"
 
 
 G_BEGIN_DECLS
@@ -48,6 +51,10 @@ typedef struct {
 	PlotArea parent;
 
 	guint num_channels;
+	guint first_row;
+	guint num_rows;
+	guint max_rows;
+	GtkAdjustment* vadj;
 	guint num_ticks;
 	gint* ticks;
 	data_t scale;
@@ -57,14 +64,27 @@ typedef struct {
 	GdkPoint* points;
 	const data_t* data;
 	int evt_label_width;
+	int evt_label_height;
+	struct label_cache labels;
+
+	guint num_cols;
+	guint* col_first;
+	const struct minmax_pyramid* pyramid;
+	data_t* envelopes;
 
-	GMutex mtx;
 	int ns_total;
 	int ns_offset;
 	int nevent;
 	int num_displayed_event;
 	int nevent_max;
+	int evt_head;
 	struct scope_event* events;
+	gpointer staged_events;
+	gint reset_pending;
+	struct scope_evtbin* evtbins;
+	guint num_evtbins;
+	int evtbins_offset;
+	gboolean evtbins_valid;
 } Scope;
 
 typedef struct {
@@ -76,9 +96,12 @@ GType scope_get_type (void);
 Scope* scope_new (void);
 void scope_update_data(Scope* self, guint pointer, int ns_total);
 void scope_set_data(Scope* self, data_t* data, guint num_points, guint num_ch);
+void scope_set_pyramid(Scope* self, const struct minmax_pyramid* pyramid);
 void scope_add_events(Scope* self, int nevent, const struct mcp_event* added_events);
 void scope_reset_events(Scope* self);
 void scope_set_ticks(Scope* self, guint num_ticks, guint* ticks);
+GtkAdjustment* scope_get_vadjustment(Scope* self);
+void scope_set_max_rows(Scope* self, guint max_rows);
 
 G_END_DECLS
 
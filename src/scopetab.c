@@ -2,16 +2,23 @@
 # include <config.h>
 #endif
 #include <string.h>
-#include <rtfilter.h>
 #include <gtk/gtk.h>
 #include <stdlib.h>
 #include <stdio.h>
 
 #include "scope.h"
 #include "signaltab.h"
+#include "decimator.h"
 #include "misc.h"
+#include "trace.h"
 
 #define CHUNKLEN	0.1 // in seconds
+// Number of displayed samples per pixel column when decimating
+#define SAMPLES_PER_PIXEL	4
+// Width assumed for the scope when it is not allocated yet
+#define DEFAULT_PLOT_WIDTH	1000
+// Maximal number of channels shown at once when the quality is lowered
+#define DEGRADED_MAX_ROWS	16
 
 #define NELEM(arr)      ((int)(sizeof(arr)/sizeof(arr[0])))
 
@@ -30,8 +37,6 @@ struct filter {
 	int enabled;
 	int order;
 	double cutoff;
-	hfilter filt;
-	int need_reset;
 };
 
 
@@ -51,6 +56,7 @@ enum scope_tab_widgets {
 	REFTYPE_COMBO,
 	ELECREF_COMBO,
 	ELEC_TREEVIEW,
+	VSCROLL,
 	NUM_SCOPETAB_WIDGETS
 };
 
@@ -83,7 +89,8 @@ const struct widget_name_entry scopetab_widgets_table[] = {
 	[NOTCH_COMBO] = {"scopetab_notch_combo", "GtkComboBox"},
 	[REFTYPE_COMBO] = {"scopetab_reftype_combo", "GtkComboBox"},
 	[ELECREF_COMBO] = {"scopetab_elecref_combo", "GtkComboBox"},
-	[ELEC_TREEVIEW] = {"scopetab_treeview", "GtkTreeView"}
+	[ELEC_TREEVIEW] = {"scopetab_treeview", "GtkTreeView"},
+	[VSCROLL] = {"scopetab_vscroll", "GtkVScrollbar"}
 };
 
 static
@@ -107,11 +114,21 @@ struct scopetab {
 	gboolean offset_on;
 	enum reftype ref;
 	unsigned int refelec;
-	float *tmpbuff, *tmpbuff2, *data, *offsetval;
+	float *data, *offsetval;
 	float wndlen;
 	unsigned int nselch, nslen, chunkns, curr;
 	unsigned int* selch;
+	float* carsum;
+	int nshard_max;
+	struct minmax_pyramid pyramid;
+
+	double disp_rate;
+	unsigned int decim;
+	struct decimator dec;
+	float* decbuf;
 	char** labels;
+	char** biplabels;
+	gboolean selch_frozen;
 
 	int ns_total;
 
@@ -128,74 +145,130 @@ struct scopetab {
  *                          Signal processing                             *
  *                                                                        *
  **************************************************************************/
+/**
+ * get_decimation_factor() - determine the rate of the displayed data
+ * @sctab:      scope tab
+ *
+ * The display rate is the one set in the configuration if any. Otherwise,
+ * it is chosen so that the window still has a few samples per pixel
+ * column: more would not be visible.
+ *
+ * Return: the ratio between the input rate and the display rate
+ */
+static
+unsigned int get_decimation_factor(struct scopetab* sctab)
+{
+	unsigned int factor, width;
+	unsigned int ns = sctab->wndlen * sctab->tab.fs;
+
+	if (sctab->disp_rate > 0.0)
+		factor = sctab->tab.fs / sctab->disp_rate;
+	else {
+		width = GTK_WIDGET(sctab->scope)->allocation.width;
+		if (width <= 1)
+			width = DEFAULT_PLOT_WIDTH;
+		factor = ns / (SAMPLES_PER_PIXEL*width);
+	}
+
+	return factor ? factor : 1;
+}
+
+
+/**
+ * init_display_data() - reset the processing of the selected channels
+ * @sctab:      scope tab
+ *
+ * Must be called when the number of selected channels or the length of
+ * the data buffer changes.
+ */
+static
+void init_display_data(struct scopetab* sctab)
+{
+	unsigned int ns = sctab->nslen;
+
+	// The scope may be rendering with the pyramid being resized
+	scope_set_pyramid(sctab->scope, NULL);
+
+	decimator_setup(&sctab->dec, sctab->decim, sctab->nselch,
+	                sctab->chunkns);
+	pyramid_resize(&sctab->pyramid, sctab->nselch, ns);
+	if (ns)
+		pyramid_update(&sctab->pyramid, sctab->data, 0, ns-1);
+	scope_set_pyramid(sctab->scope, &sctab->pyramid);
+	scope_set_data(sctab->scope, sctab->data, ns, sctab->nselch);
+}
+
+
 static
 void init_buffers(struct scopetab* sctab)
 {
 	unsigned int ns, nch = sctab->tab.nch;
-	unsigned int chunkns = sctab->chunkns;
-	g_free(sctab->tmpbuff);
-	g_free(sctab->tmpbuff2);
+	unsigned int prev_decim = sctab->decim;
+
+	// The scope may be rendering the data being freed
+	scope_set_data(sctab->scope, NULL, 0, 0);
 	g_free(sctab->data);
 	g_free(sctab->offsetval);
-
-	sctab->nslen = ns = sctab->wndlen * sctab->tab.fs;
+	g_free(sctab->carsum);
+	g_free(sctab->decbuf);
+
+	sctab->decim = get_decimation_factor(sctab);
+	sctab->tab.display_fs = (float)sctab->tab.fs / sctab->decim;
+
+	// The displayed sample count and the pending events are expressed
+	// in displayed samples: keep them in line with the new rate
+	if (prev_decim && prev_decim != sctab->decim) {
+		sctab->ns_total = (gint64)sctab->ns_total * prev_decim
+		                  / sctab->decim;
+		scope_reset_events(sctab->scope);
+	}
+	sctab->nslen = ns = sctab->wndlen * sctab->tab.display_fs;
 
 	sctab->data = g_malloc0(ns*nch*sizeof(*(sctab->data)));
 	sctab->offsetval = g_malloc0(nch*sizeof(*(sctab->offsetval)));
-	sctab->tmpbuff = g_malloc(chunkns*nch*sizeof(*(sctab->tmpbuff)));
-	sctab->tmpbuff2 = g_malloc(chunkns*nch*sizeof(*(sctab->tmpbuff2)));
+	sctab->decbuf = g_malloc((sctab->chunkns/sctab->decim + 1)*nch
+	                         *sizeof(*(sctab->decbuf)));
+
+	// Partial sums of each shard and the common average
+	sctab->nshard_max = worker_pool_num_shards(sctab->tab.source->pool,
+	                                           nch, CHANNEL_SHARD_MINLEN);
+	sctab->carsum = g_malloc0((sctab->nshard_max+1)*sctab->chunkns
+	                          *sizeof(*(sctab->carsum)));
 
 	sctab->curr = 0;
-	scope_set_data(sctab->scope, sctab->data, ns, sctab->nselch);
+	init_display_data(sctab);
 }
 
 
 static
-void filter_init(struct filter* filter, int id, double fs, int nch)
+struct filter_spec filter_get_spec(const struct filter* filter, int id)
 {
-	hfilter filt = NULL;
-	double fc = filter->cutoff / fs;
-	int order = filter->order;
-
-	// Destroy any possibly created filter
-	rtf_destroy_filter(filter->filt);
-	filter->filt = NULL;
-
-	if (!filter->enabled)
-		return;
+	struct filter_spec spec = {.order = filter->order,
+	                           .freq = filter->cutoff};
 
 	switch (id) {
 	case LOWPASS:
-		filt = rtf_create_butterworth(nch, RTF_FLOAT, fc, order, 0);
+		spec.type = FILTER_LOWPASS;
 		break;
 
 	case HIGHPASS:
-		filt = rtf_create_butterworth(nch, RTF_FLOAT, fc, order, 1);
+		spec.type = FILTER_HIGHPASS;
 		break;
 
 	case NOTCH50:
-		filt = rtf_create_notch(nch, RTF_FLOAT, 50/fs, 12/fs);
+		spec.type = FILTER_NOTCH;
+		spec.order = 0;
+		spec.freq = 50;
 		break;
 
 	case NOTCH60:
-		filt = rtf_create_notch(nch, RTF_FLOAT, 60/fs, 12/fs);
+		spec.type = FILTER_NOTCH;
+		spec.order = 0;
+		spec.freq = 60;
 		break;
-
-	default:
-		fprintf(stderr, "invalid filter id: %i", id);
-		return;
 	}
 
-	filter->filt = filt;
-	filter->need_reset = 1;
-}
-
-
-static
-void filter_deinit(struct filter* filter)
-{
-	rtf_destroy_filter(filter->filt);
-	filter->filt = NULL;
+	return spec;
 }
 
 
@@ -232,61 +305,87 @@ void filter_set_enabled(struct filter* filter, int enabled)
 }
 
 
+/**
+ * init_filters() - update the filter chain of the tab in its source
+ * @sctab:      scope tab
+ * @force_init: if non zero, update even if no filter has been modified
+ *
+ * The filters are run by the source to which the tab is attached, so that
+ * they can be shared with the other tabs of the same stream. Hence this
+ * must not be called with the tab data lock held.
+ */
 static
 void init_filters(struct scopetab* sctab, int force_init)
 {
-	int nch = sctab->tab.nch;
-	double fs = sctab->tab.fs;
+	struct filter_spec specs[NBFILTER];
 	struct filter* filter;
 	enum filter_id id;
+	int nspec = 0, modified = force_init;
 
 	for (id = 0; id < NBFILTER; id++) {
 		filter = &sctab->filters[id];
-		if (!filter->modified && !force_init)
-			continue;
-
-		g_mutex_lock(&sctab->tab.datlock);
-		filter_init(filter, id, fs, nch);
-		g_mutex_unlock(&sctab->tab.datlock);
+		if (filter->modified)
+			modified = 1;
 
 		// Acknowledge that filter modification
 		filter->modified = 0;
+
+		if (filter->enabled)
+			specs[nspec++] = filter_get_spec(filter, id);
 	}
+
+	if (modified)
+		signaltab_set_filter_chain(&sctab->tab, nspec, specs);
 }
 
 
+/*
+ * The referencing functions below process the channels [@j0, @j1) of
+ * @data, @nch being the number of channels in a sample of @data.
+ */
 static
-void reference_car(float* data, unsigned int nch,
-                   const float* fullset,
-                   unsigned int nch_full, unsigned int ns)
+void sum_channels(float* restrict sum, const float* restrict data,
+                  unsigned int nch, unsigned int j0, unsigned int j1,
+                  unsigned int ns)
 {
 	unsigned int i, j;
-	float sum;
+	float s;
 
 	for (i=0; i<ns; i++) {
-		// calculate the sum
-		sum = 0.0f;
-		for (j=0; j<nch_full; j++)
-			sum += fullset[i*nch_full+j];
-		sum /= (float)nch_full;
+		s = 0.0f;
+		for (j=j0; j<j1; j++)
+			s += data[i*nch+j];
+		sum[i] = s;
+	}
+}
 
+
+static
+void reference_car(float* restrict data, unsigned int nch,
+                   unsigned int j0, unsigned int j1,
+                   const float* restrict mean, unsigned int ns)
+{
+	unsigned int i, j;
+
+	for (i=0; i<ns; i++) {
 		// reference the data
-		for (j=0; j<nch; j++)
-			data[i*nch+j] -= sum;
+		for (j=j0; j<j1; j++)
+			data[i*nch+j] -= mean[i];
 	}
 }
 
 
 static
 void reference_elec(float* restrict data, unsigned int nch,
-                     const float* restrict fullset, unsigned int nch_full,
-		     unsigned int ns, unsigned int elec_ref)
+                    unsigned int j0, unsigned int j1,
+                    const float* restrict fullset, unsigned int nch_full,
+		    unsigned int ns, unsigned int elec_ref)
 {
 	unsigned int i, j;
 
 	for (i=0; i<ns; i++) {
 		// reference the data
-		for (j=0; j<nch; j++)
+		for (j=j0; j<j1; j++)
 			data[i*nch+j] -= fullset[i*nch_full+elec_ref];
 	}
 }
@@ -294,6 +393,7 @@ void reference_elec(float* restrict data, unsigned int nch,
 
 static
 void reference_bip(float* restrict data, unsigned int nch,
+                   unsigned int j0, unsigned int j1,
                    const float* restrict fullset, unsigned int nch_f,
 		   unsigned int ns, unsigned int *sel)
 {
@@ -301,77 +401,193 @@ void reference_bip(float* restrict data, unsigned int nch,
 
 	for (i=0; i<ns; i++) {
 		// reference the data by the next electrode in the full set
-		for (j=0; j<nch; j++)
+		for (j=j0; j<j1; j++)
 			data[i*nch+j] -= fullset[i*nch_f+((sel[j]+1)%nch_f)];
 	}
 }
 
-#define SWAP_POINTERS(pointer1, pointer2)	do {	\
-	void* temp = pointer2;				\
-	pointer2 = pointer1;				\
-	pointer1 = temp;				\
-} while(0)
+
+struct chunk_jobs {
+	struct scopetab* sctab;
+	const float* in;
+	float* data;
+	float* mean;
+	unsigned int ns;
+	int nshard;
+};
 
 
+/**
+ * process_chunk_shard() - gather and reference a range of channels
+ * @arg:        pointer to the struct chunk_jobs of the chunk
+ * @k:          index of the shard
+ *
+ * Each shard writes a disjoint range of selected channels in the data
+ * buffer. For common average referencing, only the partial sums of the
+ * shard are computed: the mean is subtracted in a second pass, once all
+ * the shards are done.
+ */
 static
-void process_chunk(struct scopetab* sctab, unsigned int ns, const float* in)
+void process_chunk_shard(void* arg, int k)
 {
+	struct chunk_jobs* cj = arg;
+	struct scopetab* sctab = cj->sctab;
 	unsigned int i, j;
-	float* restrict data;
-	struct filter* filter;
-	 //No worry later processing do not overwrite in
-	float* restrict infilt = (float*) in;
-	float* restrict tmpbuf = sctab->tmpbuff;
-	float* restrict tmpbuf2 = sctab->tmpbuff2;
+	float* restrict data = cj->data;
+	// Input has already been filtered by the source of the tab
+	const float* restrict infilt = cj->in;
 	unsigned int* restrict sel = sctab->selch;
 	unsigned int nch = sctab->nselch;
 	unsigned int nmax_ch = sctab->tab.nch;
-
-	data = sctab->data + nch * sctab->curr;
-
-	// Apply filters
-	for (i=0; i<NBFILTER; i++) {
-		filter = &sctab->filters[i];
-		if (filter->filt != NULL) {
-			if (filter->need_reset) {
-				rtf_init_filter(filter->filt, infilt);
-				filter->need_reset = 0;
-			}
-				
-			rtf_filter(filter->filt, infilt, tmpbuf, ns);
-			if (in == infilt)
-				infilt = tmpbuf2;
-			SWAP_POINTERS(infilt, tmpbuf);
-		}
-	}
+	unsigned int ns = cj->ns;
+	unsigned int j0 = (k*nch) / cj->nshard;
+	unsigned int j1 = ((k+1)*nch) / cj->nshard;
+	float* sum = sctab->carsum + k*sctab->chunkns;
 
 	// Offset data
 	if(!sctab->curr) //New frame
 	{
 		if(sctab->offset_on)
-			for (j=0; j<nch; j++)
+			for (j=j0; j<j1; j++)
 				sctab->offsetval[sel[j]] = infilt[sel[j]]; //sctab->offsetval[nch+j] = infilt[sel[j]];
 		else
-			for (j=0; j<nch; j++)
+			for (j=j0; j<j1; j++)
 				sctab->offsetval[sel[j]] = 0;
 	}
 
 
 	// Copy data of the selected channels
 	for (i=0; i<ns; i++) 
-		for (j=0; j<nch; j++) 
+		for (j=j0; j<j1; j++) 
 			data[i*nch+j] = infilt[i*nmax_ch + sel[j]]- sctab->offsetval[ sel[j]];
 
 	// Do referencing
 	if (sctab->ref == REF_CAR)
-		reference_car(data, nch, data, nch, ns);
+		sum_channels(sum, data, nch, j0, j1, ns);
 	else if (sctab->ref == REF_CARALL)
-		reference_car(data, nch, infilt, nmax_ch, ns);
+		sum_channels(sum, infilt, nmax_ch, (k*nmax_ch) / cj->nshard,
+		             ((k+1)*nmax_ch) / cj->nshard, ns);
 	else if (sctab->ref == REF_ELEC)
-		reference_elec(data, nch, infilt, nmax_ch, ns, sctab->refelec);
+		reference_elec(data, nch, j0, j1, infilt, nmax_ch, ns,
+		               sctab->refelec);
 	else if (sctab->ref == REF_BIPOLE)
-		reference_bip(data, nch, infilt, nmax_ch, ns, sel);
-		
+		reference_bip(data, nch, j0, j1, infilt, nmax_ch, ns, sel);
+}
+
+
+static
+void reference_car_shard(void* arg, int k)
+{
+	struct chunk_jobs* cj = arg;
+	unsigned int nch = cj->sctab->nselch;
+
+	reference_car(cj->data, nch, (k*nch) / cj->nshard,
+	              ((k+1)*nch) / cj->nshard, cj->mean, cj->ns);
+}
+
+
+static
+void decimate_shard(void* arg, int k)
+{
+	struct chunk_jobs* cj = arg;
+	unsigned int nch = cj->sctab->nselch;
+
+	decimator_run(&cj->sctab->dec, cj->ns, cj->sctab->decbuf,
+	              (k*nch) / cj->nshard, ((k+1)*nch) / cj->nshard);
+}
+
+
+/**
+ * store_decimated() - copy the decimated samples in the data buffer
+ * @sctab:      scope tab
+ * @ns:         number of decimated samples in @sctab->decbuf
+ *
+ * Contrary to the undecimated samples, the decimated samples of a chunk
+ * may wrap at the end of the data buffer.
+ */
+static
+void store_decimated(struct scopetab* sctab, unsigned int ns)
+{
+	unsigned int n, nch = sctab->nselch;
+	const float* src = sctab->decbuf;
+
+	while (ns) {
+		n = MIN(ns, sctab->nslen - sctab->curr);
+		memcpy(sctab->data + nch*sctab->curr, src,
+		       n*nch*sizeof(*src));
+		pyramid_update(&sctab->pyramid, sctab->data, sctab->curr,
+		               sctab->curr + n - 1);
+
+		sctab->curr = (sctab->curr + n) % sctab->nslen;
+		sctab->ns_total += n;
+		src += n*nch;
+		ns -= n;
+	}
+}
+
+
+/**
+ * process_chunk() - copy a chunk of samples in the data buffer
+ * @sctab:      scope tab
+ * @ns:         number of samples in the chunk
+ * @in:         filtered samples of all channels
+ *
+ * For large selections of channels, the work is split in channel ranges
+ * run concurrently on the worker pool. All of them are done before the
+ * current position in the buffer advances. The min/max pyramid used to
+ * draw the buffer is updated along.
+ *
+ * If the display rate is lower than the input rate, the chunk is
+ * referenced in the input of the decimator, and only its output is stored
+ * in the data buffer.
+ */
+static
+void process_chunk(struct scopetab* sctab, unsigned int ns, const float* in)
+{
+	unsigned int i, ncar, nch = sctab->nselch;
+	int k, nshard;
+	struct worker_pool* pool = sctab->tab.source->pool;
+	float* mean = sctab->carsum + sctab->nshard_max*sctab->chunkns;
+
+	nshard = worker_pool_num_shards(pool, sctab->nselch,
+	                                CHANNEL_SHARD_MINLEN);
+	nshard = MIN(nshard, sctab->nshard_max);
+
+	struct chunk_jobs cj = {
+		.sctab = sctab,
+		.in = in,
+		.data = (sctab->decim > 1) ? decimator_get_input(&sctab->dec)
+		                           : sctab->data + nch * sctab->curr,
+		.mean = mean,
+		.ns = ns,
+		.nshard = nshard,
+	};
+
+	worker_pool_run(pool, nshard, process_chunk_shard, &cj);
+
+	// Common average: reduce the partial sums and reference the data
+	if (sctab->ref == REF_CAR || sctab->ref == REF_CARALL) {
+		ncar = (sctab->ref == REF_CAR) ? sctab->nselch : sctab->tab.nch;
+		for (i=0; i<ns; i++) {
+			mean[i] = 0.0f;
+			for (k=0; k<nshard; k++)
+				mean[i] += sctab->carsum[k*sctab->chunkns + i];
+			mean[i] /= (float)ncar;
+		}
+
+		worker_pool_run(pool, nshard, reference_car_shard, &cj);
+	}
+
+	if (sctab->decim > 1) {
+		worker_pool_run(pool, nshard, decimate_shard, &cj);
+		ns = decimator_num_output(&sctab->dec, cj.ns);
+		decimator_advance(&sctab->dec, cj.ns);
+		store_decimated(sctab, ns);
+		return;
+	}
+
+	pyramid_update(&sctab->pyramid, sctab->data, sctab->curr,
+	               sctab->curr + ns - 1);
 
 	// copy data to the destination buffer
 	sctab->curr = (sctab->curr + ns) % sctab->nslen;
@@ -384,31 +600,43 @@ void process_chunk(struct scopetab* sctab, unsigned int ns, const float* in)
  *                                                                        *
  **************************************************************************/
 
+/**
+ * update_bipolar_labels() - prepare the labels of the bipolar derivations
+ * @sctab:      scope tab whose channel labels have been set
+ *
+ * The labels are built once per input definition, so that a change of the
+ * selection only has to pick them.
+ */
+static
+void update_bipolar_labels(struct scopetab* sctab)
+{
+	unsigned int ch, nch = g_strv_length(sctab->labels);
+
+	g_strfreev(sctab->biplabels);
+	sctab->biplabels = g_malloc((nch+1)*sizeof(*sctab->biplabels));
+	for (ch=0; ch<nch; ch++)
+		sctab->biplabels[ch] = g_strdup_printf("%s-%s",
+		                                       sctab->labels[ch],
+		                                       sctab->labels[(ch+1)%nch]);
+	sctab->biplabels[nch] = NULL;
+}
+
+
 static
 void update_selected_label(struct scopetab* sctab)
 {
-	char *str1, *str2, *labels[sctab->nselch+1];
-	unsigned int i, ch;
+	char *labels[sctab->nselch+1];
+	char** chlabels;
+	unsigned int i;
+
+	chlabels = (sctab->ref == REF_BIPOLE) ? sctab->biplabels : sctab->labels;
 
 	// Prepare the NULL-terminated list of selected channel labels
-	for (i=0; i<sctab->nselch; i++) {
-		if (sctab->ref == REF_BIPOLE) {
-			ch = sctab->selch[i];
-			str1 = sctab->labels[ch];
-			str2 = sctab->labels[(ch+1) % sctab->tab.nch];
-			labels[i] = g_strdup_printf("%s-%s", str1, str2);
-		} else
-			labels[i] = sctab->labels[sctab->selch[i]];
-	}
+	for (i=0; i<sctab->nselch; i++)
+		labels[i] = chlabels[sctab->selch[i]];
 	labels[sctab->nselch] = NULL;
 
-	
 	g_object_set(sctab->widgets[AXES], "ytick-labelv", labels, NULL);
-
-	if (sctab->ref == REF_BIPOLE) {
-		for (i=0; i<sctab->nselch; i++) 
-			g_free(labels[i]);
-	}
 }
 
 
@@ -451,35 +679,89 @@ void scopetab_refelec_changed_cb(GtkComboBox* combo, struct scopetab* sctab)
 }
 
 
+struct selection {
+	unsigned int num;
+	unsigned int* indices;
+};
+
+
 static
-void scopetab_selch_cb(GtkTreeSelection* selec, struct scopetab* sctab)
+void append_selected_index(GtkTreeModel* model, GtkTreePath* path,
+                           GtkTreeIter* iter, gpointer data)
 {
-	GList *list, *elem;
-	unsigned int i, j;
+	struct selection* sel = data;
+	(void)model;
+	(void)iter;
+
+	sel->indices[sel->num++] = *gtk_tree_path_get_indices(path);
+}
+
+
+/**
+ * apply_channel_selection() - set the selected channels from the treeview
+ * @sctab:      scope tab whose datlock is held
+ * @selec:      selection of the channel treeview
+ *
+ * The selection is walked without allocating the path of each selected
+ * row. The processing is reset only if the number of selected channels
+ * changes.
+ *
+ * Return: 1 if the selection has changed, 0 otherwise
+ */
+static
+int apply_channel_selection(struct scopetab* sctab, GtkTreeSelection* selec)
+{
+	struct selection sel = {.num = 0};
 	unsigned int num = gtk_tree_selection_count_selected_rows(selec);
 
-	g_mutex_lock(&sctab->tab.datlock);
+	sel.indices = g_malloc(num*sizeof(*sel.indices));
+	gtk_tree_selection_selected_foreach(selec, append_selected_index, &sel);
 
-	// Prepare the channel selection structure to be passed
+	if (num == sctab->nselch
+	   && !memcmp(sel.indices, sctab->selch, num*sizeof(*sel.indices))) {
+		g_free(sel.indices);
+		return 0;
+	}
+
+	g_free(sctab->selch);
+	sctab->selch = sel.indices;
 	if (num != sctab->nselch) {
-		g_free(sctab->selch);
-		sctab->selch = g_malloc(num*sizeof(*sctab->selch));
 		sctab->nselch = num;
-		scope_set_data(sctab->scope, sctab->data, sctab->nslen,num);
+		init_display_data(sctab);
 	}
 
-	// Copy the selection
-	elem = list = gtk_tree_selection_get_selected_rows(selec, NULL);
-	for(i=0; i<num; i++) {
-		j = *gtk_tree_path_get_indices((GtkTreePath*)(elem->data));
-		sctab->selch[i] = j;
-		elem = g_list_next(elem);
-	}
-	free_selected_rows_list(list);
+	return 1;
+}
 
+
+static
+void scopetab_selch_cb(GtkTreeSelection* selec, struct scopetab* sctab)
+{
+	int changed;
+
+	// Bulk changes of the selection are applied once they are complete
+	if (sctab->selch_frozen)
+		return;
+
+	g_mutex_lock(&sctab->tab.datlock);
+	changed = apply_channel_selection(sctab, selec);
 	g_mutex_unlock(&sctab->tab.datlock);
 
-	update_selected_label(sctab);
+	if (changed)
+		update_selected_label(sctab);
+}
+
+
+static
+void scopetab_vadj_changed_cb(GtkAdjustment* adj, struct scopetab* sctab)
+{
+	GtkWidget* vscroll = GTK_WIDGET(sctab->widgets[VSCROLL]);
+
+	// Show the scrollbar only if some channels are not shown
+	if (gtk_adjustment_get_page_size(adj) < gtk_adjustment_get_upper(adj))
+		gtk_widget_show(vscroll);
+	else
+		gtk_widget_hide(vscroll);
 }
 
 
@@ -602,6 +884,7 @@ void setup_initial_values(struct scopetab* sctab, const struct tabconf* cf)
 	mcpi_key_get_bval(cf->keyfile, cf->group, "hp-filter-on", &sctab->filters[HIGHPASS].enabled);
 	mcpi_key_get_dval(cf->keyfile, cf->group, "hp-filter-cutoff", &sctab->filters[HIGHPASS].cutoff);
 	mcpi_key_get_ival(cf->keyfile, cf->group, "hp-filter-order", &sctab->filters[HIGHPASS].order);
+	mcpi_key_get_dval(cf->keyfile, cf->group, "display-rate", &sctab->disp_rate);
 	mcpi_key_set_combo(cf->keyfile, cf->group, "scale",
 	                   GTK_COMBO_BOX(widg[SCALE_COMBO]));
 	mcpi_key_set_combo(cf->keyfile, cf->group, "notch",
@@ -659,6 +942,7 @@ void connect_widgets_signals(struct scopetab* sctab)
 {
 	GtkTreeView* treeview;
 	GtkTreeSelection* treeselec;
+	GtkAdjustment* vadj;
 	GObject** widgets = (GObject**) sctab->widgets;
 	struct filter* lp_filter = &sctab->filters[LOWPASS];
 	struct filter* hp_filter = &sctab->filters[HIGHPASS];
@@ -670,6 +954,12 @@ void connect_widgets_signals(struct scopetab* sctab)
 	g_signal_connect_after(treeselec, "changed",
 	                       G_CALLBACK(scopetab_selch_cb), sctab);
 
+	// Scrolling of the channels shown in the scope
+	vadj = scope_get_vadjustment(sctab->scope);
+	gtk_range_set_adjustment(GTK_RANGE(widgets[VSCROLL]), vadj);
+	g_signal_connect(vadj, "changed",
+	                 G_CALLBACK(scopetab_vadj_changed_cb), sctab);
+
 	// lowpass and high pass filter toggling
 	g_signal_connect_after(widgets[LP_CHECK], "toggled",
 	                      G_CALLBACK(scopetab_filter_checkbutton_cb), lp_filter);
@@ -746,6 +1036,7 @@ int find_widgets(struct scopetab* sctab, GtkBuilder* builder)
 	}
 
 	sctab->scope = SCOPE(sctab->widgets[TAB_SCOPE]);
+	sctab->tab.plot = GTK_WIDGET(sctab->scope);
 	sctab->tab.widget = GTK_WIDGET(sctab->widgets[TAB_ROOT]);
 	sctab->tab.scale_combo = GTK_COMBO_BOX(sctab->widgets[SCALE_COMBO]);
 	sctab->tab.notch_combo = GTK_COMBO_BOX(sctab->widgets[NOTCH_COMBO]);
@@ -758,7 +1049,7 @@ void scopetab_set_xticks(struct scopetab* sctab, float len)
 {
 	unsigned int i, value;
 	unsigned int inc, nticks;
-	unsigned int fs = sctab->tab.fs;
+	float fs = sctab->tab.display_fs;
 	GObject* axes = sctab->widgets[AXES];
 
 	inc = 1;
@@ -795,17 +1086,19 @@ static
 void scopetab_destroy(struct signaltab* tab)
 {
 	struct scopetab* sctab = get_scopetab(tab);
-	int id;
 
+	g_signal_handlers_disconnect_by_func(scope_get_vadjustment(sctab->scope),
+	                                     scopetab_vadj_changed_cb, sctab);
 	g_strfreev(sctab->labels);
-
-	for (id = 0; id < NBFILTER; id++)
-		filter_deinit(&sctab->filters[id]);
+	g_strfreev(sctab->biplabels);
+	g_free(sctab->selch);
 
 	g_free(sctab->data);
-	g_free(sctab->tmpbuff);
-	g_free(sctab->tmpbuff2);
 	g_free(sctab->offsetval);
+	g_free(sctab->carsum);
+	g_free(sctab->decbuf);
+	pyramid_deinit(&sctab->pyramid);
+	decimator_deinit(&sctab->dec);
 	g_free(sctab);
 }
 
@@ -814,12 +1107,17 @@ static
 void scopetab_define_input(struct signaltab* tab, const char** labels)
 {
 	struct scopetab* sctab = get_scopetab(tab);
+	GtkTreeView* treeview = GTK_TREE_VIEW(sctab->widgets[ELEC_TREEVIEW]);
 	
 	g_strfreev(sctab->labels);
 	sctab->labels = g_strdupv((char**)labels);
+	update_bipolar_labels(sctab);
 
+	// The selection is applied once the buffers fit the new input
 	g_mutex_unlock(&sctab->tab.datlock);
-	fill_treeview(GTK_TREE_VIEW(sctab->widgets[ELEC_TREEVIEW]), labels);
+	sctab->selch_frozen = TRUE;
+	fill_treeview(treeview, labels);
+	sctab->selch_frozen = FALSE;
 	fill_combo(GTK_COMBO_BOX(sctab->widgets[ELECREF_COMBO]), labels);
 	init_filters(sctab, 1);
 	g_mutex_lock(&sctab->tab.datlock);
@@ -828,6 +1126,8 @@ void scopetab_define_input(struct signaltab* tab, const char** labels)
 	sctab->ns_total = 0;
 	scope_reset_events(sctab->scope);
 	init_buffers(sctab);
+	apply_channel_selection(sctab, gtk_tree_view_get_selection(treeview));
+	update_selected_label(sctab);
 	scopetab_set_xticks(sctab, sctab->wndlen);
 }
 
@@ -838,7 +1138,12 @@ void scopetab_select_channels(struct signaltab* tab, int nch,
 {
 	struct scopetab* sctab = get_scopetab(tab);
 	GtkTreeView* treeview = GTK_TREE_VIEW(sctab->widgets[ELEC_TREEVIEW]);
+
+	// Apply the selection once rather than for each selected row
+	sctab->selch_frozen = TRUE;
 	select_channels(treeview, nch, indices);
+	sctab->selch_frozen = FALSE;
+	scopetab_selch_cb(gtk_tree_view_get_selection(treeview), sctab);
 }
 
 static
@@ -850,16 +1155,19 @@ void scopetab_process_data(struct signaltab* tab, unsigned int ns,
 	unsigned int chunkns = sctab->chunkns;
 	unsigned int nslen = sctab->nslen;
 	unsigned int nsproc;
+	gint64 span;
 
 	if (nslen == 0)
 		return;
 
 	while (ns) {
 		nsproc = (ns > chunkns) ? chunkns : ns;
-		if (sctab->curr + nsproc > nslen)
+		if (sctab->decim == 1 && sctab->curr + nsproc > nslen)
 			nsproc = nslen - sctab->curr;
 
+		span = trace_begin();
 		process_chunk(sctab, nsproc, in);
+		trace_end("process_chunk", span);
 
 		in += nsproc*nmaxch;
 		ns -= nsproc;
@@ -872,8 +1180,22 @@ void scopetab_process_events(struct signaltab* tab, int nevent,
                              const struct mcp_event* events)
 {
 	struct scopetab* sctab = get_scopetab(tab);
+	struct mcp_event decimated[nevent > 0 ? nevent : 1];
+	int i, delay;
 
-	scope_add_events(sctab->scope, nevent, events);
+	// The decimation changes with the buffers, under the data lock
+	g_mutex_lock(&sctab->tab.datlock);
+
+	// Events are positioned in the displayed samples, which are delayed
+	// by the decimation filter
+	delay = decimator_delay(&sctab->dec);
+	for (i = 0; i < nevent; i++) {
+		decimated[i] = events[i];
+		decimated[i].pos = (events[i].pos + delay) / (int)sctab->decim;
+	}
+
+	scope_add_events(sctab->scope, nevent, decimated);
+	g_mutex_unlock(&sctab->tab.datlock);
 }
 
 
@@ -886,6 +1208,19 @@ void scopetab_update_plot(struct signaltab* tab)
 }
 
 
+static
+void scopetab_set_quality(struct signaltab* tab, int level)
+{
+	struct scopetab* sctab = get_scopetab(tab);
+	guint max_rows = 0;
+
+	if (level >= MCP_QUALITY_FEWER_CHANNELS)
+		max_rows = DEGRADED_MAX_ROWS;
+
+	scope_set_max_rows(sctab->scope, max_rows);
+}
+
+
 static
 void scopetab_set_wndlen(struct signaltab* tab, float len)
 {
@@ -907,6 +1242,9 @@ struct signaltab* create_tab_scope(const struct tabconf* conf)
 
 	// Create the tab widget according to the ui definition files
 	sctab = g_malloc0(sizeof(*sctab));
+	pyramid_init(&sctab->pyramid);
+	decimator_init(&sctab->dec);
+	sctab->decim = 1;
 	builder = gtk_builder_new();
 	res = gtk_builder_add_objects_from_string(builder, conf->uidef, -1,
 	                                          object_list, &error);
@@ -933,6 +1271,7 @@ struct signaltab* create_tab_scope(const struct tabconf* conf)
 	sctab->tab.process_events = scopetab_process_events;
 	sctab->tab.update_plot = scopetab_update_plot;
 	sctab->tab.set_wndlen = scopetab_set_wndlen;
+	sctab->tab.set_quality = scopetab_set_quality;
 	return &(sctab->tab);
 
 error:
@@ -6,6 +6,7 @@
 #include <gtk/gtk.h>
 #include "mcpanel.h"
 #include "signaltab.h"
+#include "misc.h"
 
 static
 void signaltab_fill_scale_combo(struct signaltab* tab, int nscales,
@@ -38,8 +39,22 @@ void signaltab_fill_scale_combo(struct signaltab* tab, int nscales,
 LOCAL_FN 
 int initialize_signaltab(struct signaltab* tab, const struct tabconf* conf)
 {
+	struct source* src = conf->source;
+	gdouble rate = conf->refresh_rate;
+
         signaltab_fill_scale_combo(tab, conf->nscales, conf->sclabels, conf->scales);
 	g_mutex_init(&tab->datlock);
+
+	// Rate of the display updates
+	mcpi_key_get_dval(conf->keyfile, conf->group, "refresh-rate", &rate);
+	tab->refresh_interval = (rate > 0.0) ? (gint64)(G_USEC_PER_SEC/rate) : 0;
+	tab->next_update = 0;
+	tab->rate_divider = 1;
+
+	// Tabs not sharing their stream get a private source
+	if (!src)
+		src = source_create(conf);
+	source_attach_tab(src, tab);
 	return 0;
 }
 
@@ -47,6 +62,7 @@ int initialize_signaltab(struct signaltab* tab, const struct tabconf* conf)
 LOCAL_FN 
 void signaltab_destroy(struct signaltab* tab)
 {
+	source_detach_tab(tab->source, tab);
 	g_mutex_clear(&tab->datlock);
 	tab->destroy(tab);
 }
@@ -60,14 +76,17 @@ GtkWidget* signaltab_widget(struct signaltab* tab)
 
 LOCAL_FN 
 void signaltab_define_input(struct signaltab* tab, unsigned int fs,
-                            unsigned int nch, const char** labels)
+                            unsigned int nch, const char** labels,
+                            enum mcp_sample_format format)
 {
-	g_mutex_lock(&tab->datlock);
-	tab->fs = fs;
-	tab->nch = nch;
+	source_define_input(tab->source, fs, nch, labels, format);
+}
 
-	tab->define_input(tab, labels);		
-	g_mutex_unlock(&tab->datlock);
+
+LOCAL_FN
+enum mcp_sample_format signaltab_get_format(struct signaltab* tab)
+{
+	return tab->source->format;
 }
 
 
@@ -85,28 +104,213 @@ void signatab_set_wndlength(struct signaltab* tab, float len)
 LOCAL_FN 
 void signaltab_update_plot(struct signaltab* tab)
 {
-	g_mutex_lock(&tab->datlock);
+	gint64 start;
+	int n;
+
+	perf_mutex_lock(&tab->datlock, &tab->lock_wait);
+	start = g_get_monotonic_time();
 	tab->update_plot(tab);
+	perf_timer_add(&tab->update_time, g_get_monotonic_time() - start);
+
+	// The processed samples are now waiting to be drawn
+	n = MIN(g_atomic_int_get(&tab->nproc_stamp),
+	        LATENCY_NSTAMP - tab->ndraw_stamp);
+	memcpy(tab->draw_stamps + tab->ndraw_stamp, tab->proc_stamps,
+	       n*sizeof(*tab->proc_stamps));
+	tab->ndraw_stamp += n;
+	g_atomic_int_set(&tab->nproc_stamp, 0);
 	g_mutex_unlock(&tab->datlock);
 }
 
 
-LOCAL_FN 
-void signaltab_add_samples(struct signaltab* tab, unsigned int ns,
-                           const float* data)
+/**
+ * signaltab_queue_stamps() - record the submission of processed samples
+ * @tab:        tab
+ * @nstamp:     number of elements in @times
+ * @times:      submission times of the samples of the processed block
+ *
+ * Must be called with the data lock of @tab held. The stamps exceeding the
+ * capacity of @tab are discarded.
+ */
+LOCAL_FN
+void signaltab_queue_stamps(struct signaltab* tab, int nstamp,
+                            const gint64* times)
 {
+	int n = g_atomic_int_get(&tab->nproc_stamp);
+
+	nstamp = MIN(nstamp, LATENCY_NSTAMP - n);
+	memcpy(tab->proc_stamps + n, times, nstamp*sizeof(*times));
+	g_atomic_int_set(&tab->nproc_stamp, n + nstamp);
+}
+
+
+/**
+ * signaltab_drop_stamps() - discard the pending latency stamps of a tab
+ * @tab:        tab
+ *
+ * Called from the main thread when @tab is not visible: the time spent
+ * hidden must not be accounted in the latency of the display.
+ */
+LOCAL_FN
+void signaltab_drop_stamps(struct signaltab* tab)
+{
+	tab->ndraw_stamp = 0;
+	if (!g_atomic_int_get(&tab->nproc_stamp))
+		return;
+
 	g_mutex_lock(&tab->datlock);
-	tab->process_data(tab, ns, data);
+	g_atomic_int_set(&tab->nproc_stamp, 0);
 	g_mutex_unlock(&tab->datlock);
 }
 
 
+/**
+ * signaltab_account_latency() - account the latency of the drawn samples
+ * @tab:        tab
+ * @now:        time at which the plot of @tab has been drawn
+ */
+LOCAL_FN
+void signaltab_account_latency(struct signaltab* tab, gint64 now)
+{
+	int i;
+
+	for (i = 0; i < tab->ndraw_stamp; i++) {
+		perf_timer_add(&tab->latency, now - tab->draw_stamps[i]);
+		perf_timer_add(&tab->recent_latency,
+		               now - tab->draw_stamps[i]);
+	}
+	tab->ndraw_stamp = 0;
+}
+
+
+LOCAL_FN
+void signaltab_get_stats(struct signaltab* tab, struct mcp_tab_stats* stats)
+{
+	stats->samples_ingested = (gssize)g_atomic_pointer_get(
+	                                              &tab->samples_ingested);
+	stats->samples_dropped = signaltab_get_dropped(tab);
+	perf_timer_get(&tab->process_time, &stats->process);
+	perf_timer_get(&tab->update_time, &stats->update);
+	perf_timer_get(&tab->draw_time, &stats->draw);
+	perf_timer_get(&tab->lock_wait, &stats->lock_wait);
+	perf_timer_get(&tab->latency, &stats->latency);
+}
+
+
+LOCAL_FN
+void signaltab_reset_stats(struct signaltab* tab)
+{
+	g_atomic_pointer_set(&tab->samples_ingested, 0);
+	perf_timer_reset(&tab->process_time);
+	perf_timer_reset(&tab->update_time);
+	perf_timer_reset(&tab->draw_time);
+	perf_timer_reset(&tab->lock_wait);
+	perf_timer_reset(&tab->latency);
+}
+
+
+/**
+ * signaltab_set_quality() - adapt the display of a tab to a quality level
+ * @tab:        tab
+ * @level:      quality level (see enum mcp_quality_level)
+ *
+ * From MCP_QUALITY_REDUCED_RATE, the tab is updated at most at half the
+ * rate of the panel. The tab implementation may lower further the cost of
+ * its display.
+ */
+LOCAL_FN
+void signaltab_set_quality(struct signaltab* tab, int level)
+{
+	tab->rate_divider = (level >= MCP_QUALITY_REDUCED_RATE) ? 2 : 1;
+	if (tab->set_quality)
+		tab->set_quality(tab, level);
+}
+
+
+LOCAL_FN 
+void signaltab_add_samples(struct signaltab* tab, unsigned int ns,
+                           const void* data)
+{
+	struct source* src = tab->source;
+	gint64 now = g_get_monotonic_time();
+
+	ingest_ring_write(&src->ring, ns, data);
+	ingest_ring_stamp(&src->ring, now);
+}
+
+
+LOCAL_FN
+void signaltab_add_samples_planar(struct signaltab* tab, unsigned int ns,
+                                  const void* data)
+{
+	struct source* src = tab->source;
+	gint64 now = g_get_monotonic_time();
+
+	ingest_ring_write_planar(&src->ring, ns, data, src->sample_size);
+	ingest_ring_stamp(&src->ring, now);
+}
+
+
+LOCAL_FN
+unsigned int signaltab_acquire_samples(struct signaltab* tab, unsigned int ns,
+                                       struct mcp_write_window* win)
+{
+	return ingest_ring_acquire(&tab->source->ring, ns, win->data, win->ns);
+}
+
+
+LOCAL_FN
+void signaltab_commit_samples(struct signaltab* tab, unsigned int ns)
+{
+	struct source* src = tab->source;
+
+	ingest_ring_commit(&src->ring, ns);
+	if (ns)
+		ingest_ring_stamp(&src->ring, g_get_monotonic_time());
+}
+
+
+LOCAL_FN
+void signaltab_set_filter_chain(struct signaltab* tab, int nspec,
+                                const struct filter_spec* specs)
+{
+	source_set_filter_chain(tab->source, tab, nspec, specs);
+}
+
+
+LOCAL_FN
+void signaltab_set_calibration(struct signaltab* tab,
+                               const float* gain, const float* offset)
+{
+	source_set_calibration(tab->source, gain, offset);
+}
+
+
+LOCAL_FN
+void signaltab_set_overflow_policy(struct signaltab* tab,
+                                   enum overflow_policy policy)
+{
+	ingest_ring_set_policy(&tab->source->ring, policy);
+}
+
+
+LOCAL_FN
+unsigned int signaltab_get_dropped(struct signaltab* tab)
+{
+	return ingest_ring_get_dropped(&tab->source->ring);
+}
+
+
 LOCAL_FN
 void signaltab_add_events(struct signaltab* tab, int nevent,
                           const struct mcp_event* events)
 {
-	if (tab->process_events)
-		tab->process_events(tab, nevent, events);
+	if (!tab->process_events)
+		return;
+
+	tab->process_events(tab, nevent, events);
+	g_atomic_int_set(&tab->dirty, 1);
+	redraw_scheduler_request(tab->source->redraw);
 }
 
 
@@ -5,6 +5,11 @@
 #include <stdint.h>
 
 #include "mcpanel.h"
+#include "perfstat.h"
+#include "source.h"
+
+// Maximal number of latency stamps pending in a tab
+#define LATENCY_NSTAMP	32
 
 // For the implementation of signaltab children
 struct signaltab {
@@ -22,14 +27,49 @@ struct signaltab {
 	void (*destroy)(struct signaltab* tab);
 	void (*set_wndlen)(struct signaltab* tab, float len);
 	void (*select_channels)(struct signaltab* tab, int nch, int const * indexes);
+	void (*set_quality)(struct signaltab* tab, int level);
 	
 	float scale;
 	float notch;
 	float trig;
 	int fs;
+	float display_fs;
 	unsigned int nch;
 	GMutex datlock;
-	
+
+	// Set when the tab has new data to display
+	volatile gint dirty;
+
+	// Minimal time between updates of the display and time of the next
+	// allowed update (monotonic, in microseconds)
+	gint64 refresh_interval;
+	gint64 next_update;
+
+	// Factor by which the updates are slowed down by the quality level
+	unsigned int rate_divider;
+
+	// Performance counters
+	volatile gssize samples_ingested;
+	struct perf_timer process_time;
+	struct perf_timer update_time;
+	struct perf_timer draw_time;
+	struct perf_timer lock_wait;
+
+	// Submission times of the samples processed but not displayed yet
+	// (protected by datlock), and of the samples displayed but not
+	// drawn yet (main thread only). The sample-to-screen latency is
+	// accounted when the plot widget is drawn.
+	gint64 proc_stamps[LATENCY_NSTAMP];
+	volatile gint nproc_stamp;
+	gint64 draw_stamps[LATENCY_NSTAMP];
+	int ndraw_stamp;
+	GtkWidget* plot;
+	struct perf_timer latency;
+	struct perf_timer recent_latency;
+
+	// Stream to which the tab is attached and output of its filters
+	struct source* source;
+	struct filter_stage* stage;
 };
 
 struct tabconf {
@@ -38,7 +78,11 @@ struct tabconf {
 	const char** sclabels;
 	const float* scales;
 	const char* group;
+	float refresh_rate;
 	GKeyFile* keyfile;
+	struct source* source;
+	struct worker_pool* pool;
+	struct redraw_scheduler* redraw;
 };
 
 LOCAL_FN int initialize_signaltab(struct signaltab* tab, const struct tabconf* conf);
@@ -51,11 +95,36 @@ LOCAL_FN struct signaltab* create_tab_spectrum(const struct tabconf* conf);
 LOCAL_FN void signaltab_destroy(struct signaltab* tab);
 LOCAL_FN GtkWidget* signaltab_widget(struct signaltab* tab);
 LOCAL_FN void signaltab_update_plot(struct signaltab* tab);
+LOCAL_FN void signaltab_set_quality(struct signaltab* tab, int level);
+LOCAL_FN void signaltab_get_stats(struct signaltab* tab,
+                                  struct mcp_tab_stats* stats);
+LOCAL_FN void signaltab_reset_stats(struct signaltab* tab);
+LOCAL_FN void signaltab_queue_stamps(struct signaltab* tab, int nstamp,
+                                     const gint64* times);
+LOCAL_FN void signaltab_drop_stamps(struct signaltab* tab);
+LOCAL_FN void signaltab_account_latency(struct signaltab* tab, gint64 now);
 LOCAL_FN void signaltab_define_input(struct signaltab* tab, unsigned int fs,
-                                     unsigned int nch, const char** labels);
+                                     unsigned int nch, const char** labels,
+                                     enum mcp_sample_format format);
+LOCAL_FN enum mcp_sample_format signaltab_get_format(struct signaltab* tab);
 LOCAL_FN void signatab_set_wndlength(struct signaltab* tab, float len);
 LOCAL_FN void signaltab_add_samples(struct signaltab* tab, unsigned int ns,
-                                                    const float* data);
+                                                    const void* data);
+LOCAL_FN void signaltab_add_samples_planar(struct signaltab* tab,
+                                          unsigned int ns, const void* data);
+LOCAL_FN unsigned int signaltab_acquire_samples(struct signaltab* tab,
+                                               unsigned int ns,
+                                               struct mcp_write_window* win);
+LOCAL_FN void signaltab_commit_samples(struct signaltab* tab,
+                                       unsigned int ns);
+LOCAL_FN void signaltab_set_filter_chain(struct signaltab* tab, int nspec,
+                                         const struct filter_spec* specs);
+LOCAL_FN void signaltab_set_calibration(struct signaltab* tab,
+                                       const float* gain,
+                                       const float* offset);
+LOCAL_FN void signaltab_set_overflow_policy(struct signaltab* tab,
+                                           enum overflow_policy policy);
+LOCAL_FN unsigned int signaltab_get_dropped(struct signaltab* tab);
 LOCAL_FN void signaltab_add_events(struct signaltab* tab, int nevent,
                                    const struct mcp_event* events);
 
@@ -0,0 +1,901 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <glib.h>
+#include <rtfilter.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "signaltab.h"
+#include "source.h"
+#include "misc.h"
+#include "trace.h"
+
+/**
+ * DOC: Stream sources
+ *
+ * A source is the point where the samples of a stream enter the panel. It
+ * owns the ingestion ring and the processing thread that drains it. Several
+ * tabs can be attached to the same source: the samples are then submitted
+ * once and each block is dispatched to all of them.
+ *
+ * The filters required by the tabs are run by the source as well, organised
+ * as a tree of stages rooted on the raw input. Each tab selects a chain of
+ * filters, which is sorted in a canonical order (all the filters being
+ * linear and time-invariant, the order does not matter) and then mapped to
+ * a path in the tree. Tabs asking the same filters hence share the same
+ * stages, and tabs whose chains only share a prefix share the stages of this
+ * prefix. Each stage is computed once per block whatever the number of tabs
+ * using its output.
+ *
+ * For large montages, the channels are split in shards processed
+ * concurrently: the filters being independent between channels, each shard
+ * runs the whole tree of stages on its own channels.
+ */
+
+// Maximal duration of data processed at once by the processing thread (in s)
+#define PROC_CHUNKLEN	0.05f
+// Default duration of data that can be queued before overflowing (in s)
+#define DEFAULT_INGESTLEN	1.0
+// Bandwidth of notch filters (in Hz)
+#define NOTCH_BANDWIDTH	12.0
+
+static const char* const overflow_policy_names[] = {
+	[OVERFLOW_BLOCK] = "block",
+	[OVERFLOW_DROP_OLDEST] = "drop-oldest",
+	[OVERFLOW_COALESCE] = "coalesce",
+};
+#define NUM_OVERFLOW_POLICY \
+	(sizeof(overflow_policy_names)/sizeof(overflow_policy_names[0]))
+
+// Names of the spans of the filter stages in the traces
+static const char* const filter_trace_names[] = {
+	[FILTER_HIGHPASS] = "filter highpass",
+	[FILTER_NOTCH] = "filter notch",
+	[FILTER_LOWPASS] = "filter lowpass",
+};
+
+
+/**************************************************************************
+ *                                                                        *
+ *                           Filter stages                                *
+ *                                                                        *
+ **************************************************************************/
+static
+int cmp_filter_spec(const void* pa, const void* pb)
+{
+	const struct filter_spec* a = pa;
+	const struct filter_spec* b = pb;
+
+	if (a->type != b->type)
+		return (a->type < b->type) ? -1 : 1;
+
+	if (a->freq != b->freq)
+		return (a->freq < b->freq) ? -1 : 1;
+
+	return a->order - b->order;
+}
+
+
+static
+hfilter create_filter(const struct filter_spec* spec, unsigned int nch,
+                      double fs)
+{
+	switch (spec->type) {
+	case FILTER_LOWPASS:
+		return rtf_create_butterworth(nch, RTF_FLOAT, spec->freq/fs,
+		                              spec->order, 0);
+
+	case FILTER_HIGHPASS:
+		return rtf_create_butterworth(nch, RTF_FLOAT, spec->freq/fs,
+		                              spec->order, 1);
+
+	case FILTER_NOTCH:
+		return rtf_create_notch(nch, RTF_FLOAT, spec->freq/fs,
+		                        NOTCH_BANDWIDTH/fs);
+
+	default:
+		fprintf(stderr, "invalid filter type: %i", spec->type);
+		return NULL;
+	}
+}
+
+
+static
+void stage_clear(struct filter_stage* stage)
+{
+	int k;
+
+	for (k = 0; k < stage->nshard; k++) {
+		rtf_destroy_filter(stage->shards[k].filt);
+		if (stage->nshard > 1)
+			g_free(stage->shards[k].out);
+	}
+
+	// The output of the root stage is the input of the source
+	if (stage->parent)
+		g_free(stage->out);
+
+	g_free(stage->shards);
+	stage->shards = NULL;
+	stage->nshard = 0;
+	stage->out = NULL;
+}
+
+
+/**
+ * stage_init() - (re)initialise a stage for the current input of a source
+ * @src:        source owning the stage tree
+ * @stage:      stage to initialise
+ *
+ * One filter is created for each channel shard of @src. If the channels
+ * are not split, the output of the single shard is the output of the
+ * stage, otherwise each shard has its own buffer holding only its
+ * channels.
+ */
+static
+void stage_init(struct source* src, struct filter_stage* stage)
+{
+	struct filter_shard* shard;
+	unsigned int nc, bufsize = src->procbuf_ns*sizeof(float);
+	int k;
+
+	stage_clear(stage);
+
+	if (src->nch == 0 || src->fs <= 0)
+		return;
+
+	stage->nshard = src->nshard;
+	stage->shards = g_malloc0(src->nshard*sizeof(*stage->shards));
+	if (stage->parent)
+		stage->out = g_malloc(bufsize*src->nch);
+
+	for (k = 0; k < src->nshard; k++) {
+		shard = &stage->shards[k];
+		nc = src->shard_ch[k+1] - src->shard_ch[k];
+
+		if (stage->parent) {
+			shard->filt = create_filter(&stage->spec, nc, src->fs);
+			shard->need_reset = 1;
+		}
+
+		shard->out = (src->nshard > 1) ? g_malloc(bufsize*nc)
+		                               : stage->out;
+	}
+}
+
+
+static
+void stage_destroy(struct filter_stage* stage)
+{
+	stage_clear(stage);
+	g_free(stage);
+}
+
+
+/**
+ * stage_get_child() - get the stage applying a filter after a given one
+ * @src:        source owning the stage tree
+ * @parent:     stage whose output is the input of the wanted stage
+ * @spec:       specification of the filter
+ *
+ * Return: the existing child of @parent matching @spec if any, a newly
+ * created one (with a null reference count) otherwise.
+ */
+static
+struct filter_stage* stage_get_child(struct source* src,
+                                     struct filter_stage* parent,
+                                     const struct filter_spec* spec)
+{
+	struct filter_stage* stage;
+
+	for (stage = parent->children; stage; stage = stage->next) {
+		if (!cmp_filter_spec(&stage->spec, spec))
+			return stage;
+	}
+
+	stage = g_malloc0(sizeof(*stage));
+	stage->spec = *spec;
+	stage->parent = parent;
+	stage->next = parent->children;
+	parent->children = stage;
+	stage_init(src, stage);
+
+	return stage;
+}
+
+
+static
+void stage_ref_path(struct filter_stage* stage)
+{
+	for (; stage; stage = stage->parent)
+		stage->refcount++;
+}
+
+
+static
+void stage_unref_path(struct filter_stage* stage)
+{
+	struct filter_stage *parent, **link;
+
+	for (; stage; stage = parent) {
+		parent = stage->parent;
+		if (--stage->refcount > 0 || !parent)
+			continue;
+
+		// Unlink the stage from its parent and destroy it
+		for (link = &parent->children; *link; link = &(*link)->next) {
+			if (*link == stage) {
+				*link = stage->next;
+				break;
+			}
+		}
+		stage_destroy(stage);
+	}
+}
+
+
+static
+void stage_reinit_tree(struct source* src, struct filter_stage* stage)
+{
+	struct filter_stage* child;
+
+	for (child = stage->children; child; child = child->next) {
+		stage_init(src, child);
+		stage_reinit_tree(src, child);
+	}
+}
+
+
+/**
+ * copy_channels() - copy a range of channels between interleaved buffers
+ * @dst:        destination
+ * @dst_nch:    number of channels in @dst
+ * @src:        source
+ * @src_nch:    number of channels in @src
+ * @nc:         number of channels to copy
+ * @ns:         number of samples
+ *
+ * @dst and @src must point to the first channel to copy in their buffer.
+ */
+static
+void copy_channels(float* restrict dst, unsigned int dst_nch,
+                   const float* restrict src, unsigned int src_nch,
+                   unsigned int nc, unsigned int ns)
+{
+	unsigned int i;
+
+	for (i = 0; i < ns; i++)
+		memcpy(dst + i*dst_nch, src + i*src_nch, nc*sizeof(*dst));
+}
+
+
+/**
+ * stage_process_shard() - run the filters depending on a stage on a shard
+ * @src:        source owning the stage tree
+ * @stage:      stage whose output has just been computed
+ * @k:          index of the shard
+ * @ns:         number of samples in the block
+ *
+ * The shards are independent from each other: they can be processed
+ * concurrently. If the channels are split, the output of the stages
+ * used directly by a tab is assembled from the shards as they complete.
+ */
+static
+void stage_process_shard(const struct source* src,
+                         const struct filter_stage* stage,
+                         int k, unsigned int ns)
+{
+	struct filter_stage* child;
+	struct filter_shard* shard;
+	const float* in = stage->shards[k].out;
+	unsigned int ch0 = src->shard_ch[k];
+	unsigned int nc = src->shard_ch[k+1] - ch0;
+	gint64 span;
+
+	for (child = stage->children; child; child = child->next) {
+		shard = &child->shards[k];
+		span = trace_begin();
+
+		// Filter that could not be created acts as a passthrough
+		if (!shard->filt) {
+			memcpy(shard->out, in, ns*nc*sizeof(*in));
+		} else {
+			if (shard->need_reset) {
+				rtf_init_filter(shard->filt, in);
+				shard->need_reset = 0;
+			}
+			rtf_filter(shard->filt, in, shard->out, ns);
+		}
+		trace_end(filter_trace_names[child->spec.type], span);
+
+		if (child->nshard > 1 && child->nuser)
+			copy_channels(child->out + ch0, src->nch,
+			              shard->out, nc, nc, ns);
+
+		stage_process_shard(src, child, k, ns);
+	}
+}
+
+
+/*
+ * Convert the channels [ch0, ch0+nc) of the samples in data whose values
+ * are of the specified type and apply the calibration of the channels.
+ */
+#define CONVERT_CHANNELS(type, conv)					\
+do {									\
+	const type* in = (const type*)data + ch0;			\
+	for (i = 0; i < ns; i++)					\
+		for (j = 0; j < nc; j++)				\
+			dst[i*dst_nch+j] = gain[j]*(float)conv(in[i*nch+j]) \
+			                   + offset[j];			\
+} while (0)
+
+#define CONV_IDENTITY(x)	(x)
+#define CONV_INT24(x)		(((int32_t)((uint32_t)(x) << 8)) >> 8)
+
+/**
+ * convert_channels() - convert submitted samples of a range of channels
+ * @dst:        destination of the converted samples
+ * @dst_nch:    number of channels in a sample of @dst
+ * @src:        source to which the samples have been submitted
+ * @data:       samples as submitted
+ * @ch0:        first channel to convert
+ * @nc:         number of channels to convert
+ * @ns:         number of samples
+ *
+ * The conversion to float and the calibration are done in the same pass
+ * as the copy to the buffer that the filters or the tabs read.
+ */
+static
+void convert_channels(float* restrict dst, unsigned int dst_nch,
+                      const struct source* src, const void* restrict data,
+                      unsigned int ch0, unsigned int nc, unsigned int ns)
+{
+	const float* restrict gain = src->gain + ch0;
+	const float* restrict offset = src->offset + ch0;
+	unsigned int i, j, nch = src->nch;
+
+	switch (src->format) {
+	case MCP_FORMAT_FLOAT:
+		CONVERT_CHANNELS(float, CONV_IDENTITY);
+		break;
+
+	case MCP_FORMAT_DOUBLE:
+		CONVERT_CHANNELS(double, CONV_IDENTITY);
+		break;
+
+	case MCP_FORMAT_INT16:
+		CONVERT_CHANNELS(int16_t, CONV_IDENTITY);
+		break;
+
+	case MCP_FORMAT_INT24:
+		CONVERT_CHANNELS(int32_t, CONV_INT24);
+		break;
+
+	case MCP_FORMAT_INT32:
+		CONVERT_CHANNELS(int32_t, CONV_IDENTITY);
+		break;
+	}
+}
+
+
+static
+unsigned int get_sample_size(enum mcp_sample_format format)
+{
+	switch (format) {
+	case MCP_FORMAT_DOUBLE: return sizeof(double);
+	case MCP_FORMAT_INT16:  return sizeof(int16_t);
+	case MCP_FORMAT_INT24:  return sizeof(int32_t);
+	case MCP_FORMAT_INT32:  return sizeof(int32_t);
+	default:                return sizeof(float);
+	}
+}
+
+
+/**
+ * source_init_shards() - split the channels of a source in shards
+ * @src:        source whose input has just been defined
+ *
+ * Large montages are split in contiguous channel ranges whose filters
+ * are run concurrently on the worker pool, each shard owning the state of
+ * its own filters.
+ */
+static
+void source_init_shards(struct source* src)
+{
+	int k, nshard;
+
+	nshard = worker_pool_num_shards(src->pool, src->nch,
+	                                CHANNEL_SHARD_MINLEN);
+
+	g_free(src->shard_ch);
+	src->nshard = nshard;
+	src->shard_ch = g_malloc((nshard+1)*sizeof(*src->shard_ch));
+	for (k = 0; k <= nshard; k++)
+		src->shard_ch[k] = (k * src->nch) / nshard;
+}
+
+
+/**************************************************************************
+ *                                                                        *
+ *                          Processing thread                             *
+ *                                                                        *
+ **************************************************************************/
+struct block_jobs {
+	struct source* src;
+	struct signaltab** tabs;
+	struct filter_stage** stages;
+	const float** outs;
+	const void* data;
+	unsigned int ns;
+	int nstamp;
+	gint64 stamps[LATENCY_NSTAMP];
+};
+
+
+static
+void process_shard_job(void* arg, int k)
+{
+	struct block_jobs* blk = arg;
+	struct source* src = blk->src;
+	struct filter_stage* root = &src->root;
+	unsigned int ch0 = src->shard_ch[k];
+	unsigned int nc = src->shard_ch[k+1] - ch0;
+
+	if (src->convert) {
+		convert_channels(root->shards[k].out, nc, src, blk->data,
+		                 ch0, nc, blk->ns);
+		if (root->nshard > 1 && root->nuser)
+			copy_channels(root->out + ch0, src->nch,
+			              root->shards[k].out, nc, nc, blk->ns);
+	} else if (root->nshard > 1) {
+		copy_channels(root->shards[k].out, nc,
+		              (const float*)blk->data + ch0, src->nch,
+		              nc, blk->ns);
+	}
+
+	stage_process_shard(src, root, k, blk->ns);
+}
+
+
+static
+void process_tab_job(void* arg, int job)
+{
+	struct block_jobs* blk = arg;
+	struct signaltab* tab = blk->tabs[job];
+	gint64 start;
+
+	perf_mutex_lock(&tab->datlock, &tab->lock_wait);
+	start = g_get_monotonic_time();
+	tab->process_data(tab, blk->ns, blk->outs[job]);
+	perf_timer_add(&tab->process_time, g_get_monotonic_time() - start);
+	signaltab_queue_stamps(tab, blk->nstamp, blk->stamps);
+	g_mutex_unlock(&tab->datlock);
+
+	g_atomic_pointer_add(&tab->samples_ingested, blk->ns);
+	g_atomic_int_set(&tab->dirty, 1);
+}
+
+
+/**
+ * source_dispatch_block() - process a block of samples by all tabs
+ * @src:        source
+ * @ns:         number of samples in the block
+ * @data:       samples of the block, as submitted
+ *
+ * The samples are converted to float if needed while the filter stages
+ * are run. The filter stages are run first, concurrently on the channel
+ * shards, with the source lock held since they walk the stage tree. The
+ * output of the stage of each tab is then referenced and the lock is
+ * released: the tabs process the block concurrently on the worker pool
+ * while the filter chains may be changed from the GUI. The referenced
+ * stages are released once the tabs are done.
+ *
+ * Each tab holds its data lock only while it processes the block, so that
+ * the display of a tab can be updated as soon as the tab is done. The tabs
+ * sharing a source are not updated at the same block boundary: they have
+ * their own refresh rate, and waiting for the others in the main loop
+ * would block it for the processing time of the block. A frame is
+ * requested once the block is done.
+ *
+ * The time taken by the block is accounted for the load of the source.
+ * The submission times of its samples are passed to the tabs to measure
+ * the latency of their display.
+ */
+static
+void source_dispatch_block(struct source* src, unsigned int ns,
+                           const void* data)
+{
+	GSList* elem;
+	int i, ntab;
+	gint64 start = g_get_monotonic_time();
+
+	g_mutex_lock(&src->lock);
+
+	ntab = g_slist_length(src->tabs);
+	struct signaltab* tabs[ntab > 0 ? ntab : 1];
+	struct filter_stage* stages[ntab > 0 ? ntab : 1];
+	const float* outs[ntab > 0 ? ntab : 1];
+	struct block_jobs blk = {.src = src, .tabs = tabs, .stages = stages,
+	                         .outs = outs, .data = data, .ns = ns};
+	blk.nstamp = ingest_ring_pop_stamps(&src->ring, ns, blk.stamps,
+	                                    LATENCY_NSTAMP);
+
+	src->root.out = src->convert ? src->convbuf : (float*)data;
+	if (src->root.nshard == 1)
+		src->root.shards[0].out = src->root.out;
+	worker_pool_run(src->pool, src->root.nshard, process_shard_job, &blk);
+
+	// Keep the stages read by the tabs until they are done with them
+	for (i = 0, elem = src->tabs; elem; elem = g_slist_next(elem), i++) {
+		tabs[i] = elem->data;
+		stages[i] = tabs[i]->stage;
+		outs[i] = stages[i]->out;
+		stage_ref_path(stages[i]);
+	}
+	src->root.out = NULL;
+	src->dispatching = 1;
+	g_mutex_unlock(&src->lock);
+
+	worker_pool_run(src->pool, ntab, process_tab_job, &blk);
+
+	g_mutex_lock(&src->lock);
+	for (i = 0; i < ntab; i++)
+		stage_unref_path(stages[i]);
+	src->dispatching = 0;
+	g_cond_broadcast(&src->dispatch_done);
+	if (src->fs > 0)
+		g_atomic_int_add((volatile gint*)&src->data_time,
+		                 (guint64)ns * G_USEC_PER_SEC / src->fs);
+	g_mutex_unlock(&src->lock);
+
+	g_atomic_int_add((volatile gint*)&src->busy_time,
+	                 g_get_monotonic_time() - start);
+	redraw_scheduler_request(src->redraw);
+}
+
+
+/**
+ * source_processing_thread() - consume the samples queued in the source
+ * @data:       pointer to the source
+ *
+ * Runs until the ingestion ring is stopped. This is the only context in
+ * which the process_data() method of the attached tabs is called, hence
+ * the acquisition thread is never delayed by the processing.
+ */
+static
+gpointer source_processing_thread(gpointer data)
+{
+	struct source* src = data;
+	const void* frames;
+	unsigned int ns;
+
+	while (1) {
+		ns = ingest_ring_peek(&src->ring, src->procbuf_ns,
+		                      src->procbuf, &frames);
+		if (ns == 0)
+			break;
+
+		source_dispatch_block(src, ns, frames);
+		ingest_ring_release(&src->ring, ns);
+	}
+
+	return NULL;
+}
+
+
+static
+void source_stop_processing(struct source* src)
+{
+	if (!src->thread)
+		return;
+
+	ingest_ring_stop(&src->ring);
+	g_thread_join(src->thread);
+	src->thread = NULL;
+}
+
+
+static
+void source_start_processing(struct source* src)
+{
+	unsigned int capacity;
+
+	capacity = src->ingest_len * src->fs;
+	if (capacity < src->procbuf_ns)
+		capacity = src->procbuf_ns;
+
+	ingest_ring_resize(&src->ring, src->nch*src->sample_size,
+	                   src->nch ? capacity : 0);
+
+	if (src->nch)
+		src->thread = g_thread_new("mcp-source",
+		                           source_processing_thread, src);
+}
+
+
+/**************************************************************************
+ *                                                                        *
+ *                             Source API                                 *
+ *                                                                        *
+ **************************************************************************/
+static
+enum overflow_policy get_conf_overflow_policy(const struct tabconf* conf)
+{
+	unsigned int i;
+	gchar* val;
+	enum overflow_policy policy = OVERFLOW_BLOCK;
+
+	if (!conf->keyfile)
+		return policy;
+
+	val = g_key_file_get_string(conf->keyfile, conf->group,
+	                            "overflow-policy", NULL);
+	if (!val)
+		return policy;
+
+	for (i = 0; i < NUM_OVERFLOW_POLICY; i++) {
+		if (!strcmp(val, overflow_policy_names[i]))
+			policy = i;
+	}
+
+	g_free(val);
+	return policy;
+}
+
+
+/**
+ * source_create() - create a source with no tab attached
+ * @conf:       configuration of the first tab to be attached. The
+ *              ingestion settings of the source are read from its group
+ *              in the configuration file, and the tabs are run on the
+ *              worker pool it specifies.
+ *
+ * Return: the created source. It is destroyed when the last attached tab
+ * is detached.
+ */
+LOCAL_FN
+struct source* source_create(const struct tabconf* conf)
+{
+	struct source* src;
+	double ingest_len = DEFAULT_INGESTLEN;
+
+	mcpi_key_get_dval(conf->keyfile, conf->group, "ingest-length",
+	                  &ingest_len);
+
+	src = g_malloc0(sizeof(*src));
+	src->ingest_len = ingest_len > 0.0 ? ingest_len : DEFAULT_INGESTLEN;
+	src->pool = conf->pool;
+	src->redraw = conf->redraw;
+	g_mutex_init(&src->lock);
+	g_cond_init(&src->dispatch_done);
+	ingest_ring_init(&src->ring, 0, 0, get_conf_overflow_policy(conf));
+
+	return src;
+}
+
+
+static
+void source_destroy(struct source* src)
+{
+	source_stop_processing(src);
+	stage_clear(&src->root);
+	ingest_ring_deinit(&src->ring);
+	g_mutex_clear(&src->lock);
+	g_cond_clear(&src->dispatch_done);
+	g_free(src->procbuf);
+	g_free(src->convbuf);
+	g_free(src->gain);
+	g_free(src->offset);
+	g_free(src->shard_ch);
+	g_free(src);
+}
+
+
+LOCAL_FN
+void source_attach_tab(struct source* src, struct signaltab* tab)
+{
+	g_mutex_lock(&src->lock);
+	src->refcount++;
+	src->tabs = g_slist_append(src->tabs, tab);
+	tab->source = src;
+	tab->stage = &src->root;
+	tab->stage->nuser++;
+	stage_ref_path(tab->stage);
+	g_mutex_unlock(&src->lock);
+}
+
+
+LOCAL_FN
+void source_detach_tab(struct source* src, struct signaltab* tab)
+{
+	int refcount;
+
+	g_mutex_lock(&src->lock);
+
+	// The tab may be processing the block being dispatched
+	while (src->dispatching)
+		g_cond_wait(&src->dispatch_done, &src->lock);
+
+	src->tabs = g_slist_remove(src->tabs, tab);
+	tab->stage->nuser--;
+	stage_unref_path(tab->stage);
+	tab->stage = NULL;
+	tab->source = NULL;
+	refcount = --src->refcount;
+	g_mutex_unlock(&src->lock);
+
+	if (refcount == 0)
+		source_destroy(src);
+}
+
+
+/**
+ * source_define_input() - set the stream geometry of a source
+ * @src:        source
+ * @fs:         sampling frequency
+ * @nch:        number of channels
+ * @labels:     NULL terminated list of channel labels
+ * @format:     type of the values of the samples that will be submitted
+ *
+ * The input definition is propagated to all the attached tabs. The
+ * calibration of the channels is reset.
+ */
+LOCAL_FN
+void source_define_input(struct source* src, unsigned int fs,
+                         unsigned int nch, const char** labels,
+                         enum mcp_sample_format format)
+{
+	GSList* elem;
+	struct signaltab* tab;
+	unsigned int i;
+
+	source_stop_processing(src);
+
+	g_mutex_lock(&src->lock);
+	src->fs = fs;
+	src->nch = nch;
+	src->format = format;
+	src->sample_size = get_sample_size(format);
+	src->convert = (format != MCP_FORMAT_FLOAT);
+	src->procbuf_ns = PROC_CHUNKLEN * fs + 1;
+	g_free(src->procbuf);
+	src->procbuf = g_malloc(src->procbuf_ns*nch*src->sample_size);
+	g_free(src->convbuf);
+	src->convbuf = g_malloc(src->procbuf_ns*nch*sizeof(float));
+
+	g_free(src->gain);
+	g_free(src->offset);
+	src->gain = g_malloc(nch*sizeof(*src->gain));
+	src->offset = g_malloc(nch*sizeof(*src->offset));
+	for (i = 0; i < nch; i++) {
+		src->gain[i] = 1.0f;
+		src->offset[i] = 0.0f;
+	}
+	source_init_shards(src);
+	stage_init(src, &src->root);
+	stage_reinit_tree(src, &src->root);
+	g_mutex_unlock(&src->lock);
+
+	// Tab may update their filter chain: src->lock must not be held
+	for (elem = src->tabs; elem; elem = g_slist_next(elem)) {
+		tab = elem->data;
+
+		g_mutex_lock(&tab->datlock);
+		tab->fs = fs;
+		tab->nch = nch;
+		tab->define_input(tab, labels);
+		g_mutex_unlock(&tab->datlock);
+	}
+
+	source_start_processing(src);
+}
+
+
+/**
+ * source_set_calibration() - set the calibration of the channels
+ * @src:        source
+ * @gain:       array of gains of each channel (NULL if all gains are 1)
+ * @offset:     array of offsets of each channel (NULL if all offsets are 0)
+ */
+LOCAL_FN
+void source_set_calibration(struct source* src,
+                            const float* gain, const float* offset)
+{
+	unsigned int i;
+
+	g_mutex_lock(&src->lock);
+
+	for (i = 0; i < src->nch; i++) {
+		src->gain[i] = gain ? gain[i] : 1.0f;
+		src->offset[i] = offset ? offset[i] : 0.0f;
+	}
+
+	// Float samples need a conversion pass only if calibrated
+	src->convert = (src->format != MCP_FORMAT_FLOAT) || gain || offset;
+
+	g_mutex_unlock(&src->lock);
+}
+
+
+/**
+ * source_take_load() - get the processing load of a source
+ * @src:        source
+ *
+ * The load is the time spent to process the blocks over the real time
+ * duration of the samples they contain: the source falls behind real time
+ * when it exceeds 1. It is measured since the previous call, and is 0 if
+ * no block has been processed meanwhile.
+ *
+ * Return: the load of the source
+ */
+LOCAL_FN
+double source_take_load(struct source* src)
+{
+	guint busy, duration;
+
+	busy = g_atomic_int_and(&src->busy_time, 0);
+	duration = g_atomic_int_and(&src->data_time, 0);
+
+	return duration ? (double)busy / (double)duration : 0.0;
+}
+
+
+/**
+ * source_set_filter_chain() - set the filters to apply to a tab input
+ * @src:        source to which @tab is attached
+ * @tab:        tab whose filters are modified
+ * @nspec:      number of filters
+ * @specs:      array of @nspec filter specifications
+ *
+ * The filter stages common with other tabs are reused, only the missing
+ * ones are created. This must not be called with the data lock of a tab
+ * held.
+ */
+LOCAL_FN
+void source_set_filter_chain(struct source* src, struct signaltab* tab,
+                             int nspec, const struct filter_spec* specs)
+{
+	struct filter_spec sorted[nspec > 0 ? nspec : 1];
+	struct filter_stage* stage;
+	int i;
+
+	memcpy(sorted, specs, nspec*sizeof(*specs));
+	qsort(sorted, nspec, sizeof(*sorted), cmp_filter_spec);
+
+	g_mutex_lock(&src->lock);
+
+	stage = &src->root;
+	for (i = 0; i < nspec; i++)
+		stage = stage_get_child(src, stage, &sorted[i]);
+
+	// Reference the new path before releasing the old one so that the
+	// shared stages are kept
+	stage->nuser++;
+	stage_ref_path(stage);
+	tab->stage->nuser--;
+	stage_unref_path(tab->stage);
+	tab->stage = stage;
+
+	g_mutex_unlock(&src->lock);
+}
@@ -0,0 +1,113 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <glib.h>
+#include <rtfilter.h>
+#include "mcpanel.h"
+#include "ingest.h"
+#include "redraw.h"
+#include "workerpool.h"
+
+struct signaltab;
+struct tabconf;
+
+/* Minimal number of channels processed by a thread when the channels of a
+ * block are split across the worker pool */
+#define CHANNEL_SHARD_MINLEN	64
+
+/* The order of the types defines the canonical order of filter chains: the
+ * stages most likely to be shared between tabs must come first */
+enum filter_type {
+	FILTER_HIGHPASS,
+	FILTER_NOTCH,
+	FILTER_LOWPASS,
+};
+
+struct filter_spec {
+	enum filter_type type;
+	int order;
+	double freq;
+};
+
+/* State of a filter stage for a range of channels */
+struct filter_shard {
+	hfilter filt;
+	int need_reset;
+	float* out;
+};
+
+struct filter_stage {
+	struct filter_spec spec;
+	int refcount;
+	int nuser;
+	int nshard;
+	struct filter_shard* shards;
+	float* out;
+	struct filter_stage* parent;
+	struct filter_stage* children;
+	struct filter_stage* next;
+};
+
+struct source {
+	int refcount;
+	int fs;
+	unsigned int nch;
+	GSList* tabs;
+	GMutex lock;
+	GCond dispatch_done;
+	int dispatching;
+	struct filter_stage root;
+	struct worker_pool* pool;
+	struct redraw_scheduler* redraw;
+	int nshard;
+	unsigned int* shard_ch;
+
+	enum mcp_sample_format format;
+	unsigned int sample_size;
+	int convert;
+	float *gain, *offset;
+	float* convbuf;
+
+	struct ingest_ring ring;
+	GThread* thread;
+	void* procbuf;
+	unsigned int procbuf_ns;
+	float ingest_len;
+
+	// Time spent to process the blocks and real time duration of these
+	// blocks since the load was last taken (in microseconds)
+	volatile guint busy_time;
+	volatile guint data_time;
+};
+
+LOCAL_FN struct source* source_create(const struct tabconf* conf);
+LOCAL_FN void source_attach_tab(struct source* src, struct signaltab* tab);
+LOCAL_FN void source_detach_tab(struct source* src, struct signaltab* tab);
+LOCAL_FN void source_define_input(struct source* src, unsigned int fs,
+                                  unsigned int nch, const char** labels,
+                                  enum mcp_sample_format format);
+LOCAL_FN void source_set_calibration(struct source* src,
+                                     const float* gain, const float* offset);
+LOCAL_FN double source_take_load(struct source* src);
+LOCAL_FN void source_set_filter_chain(struct source* src,
+                                      struct signaltab* tab, int nspec,
+                                      const struct filter_spec* specs);
+
+#endif /* SOURCE_H */
@@ -24,10 +24,13 @@
 #include "plotgraph.h"
 #include "signaltab.h"
 #include "spectrum.h"
+#include "trace.h"
 
 #define INITIAL_DFT_NUMPOINT    2048
 #define MAX_DYNTICKS  10
 #define LABEL_MAXLEN  31
+// Slow down of the spectrum updates when the quality is lowered
+#define DEGRADED_RATE_DIVIDER   4
 
 enum dftscale_type {
 	DFTSCALE_NODISPLAY = -1,
@@ -590,6 +593,7 @@ int find_widgets(struct spectrumtab* sptab, GtkBuilder* builder)
 	}
 
 	sptab->graph = PLOTGRAPH(sptab->widgets[TAB_GRAPH]);
+	sptab->tab.plot = GTK_WIDGET(sptab->graph);
 	sptab->tab.widget = GTK_WIDGET(sptab->widgets[TAB_ROOT]);
 	sptab->tab.scale_combo = GTK_COMBO_BOX(sptab->widgets[SCALE_COMBO]);
 	return 0;
@@ -653,6 +657,7 @@ void spectrumtab_process_data(struct signaltab* tab, unsigned int ns,
 	int i, num_delayed;
 	struct spectrumtab* sptab = get_spectrumtab(tab);
 	int selch = sptab->selch;
+	gint64 span;
 	int nch = sptab->tab.nch;
 	float selected_in[ns];
 
@@ -669,7 +674,9 @@ void spectrumtab_process_data(struct signaltab* tab, unsigned int ns,
 		sptab->delayed_display_numpoint = num_delayed;
 	}
 
+	span = trace_begin();
 	spectrum_update(&sptab->spectrum, ns, selected_in);
+	trace_end("spectrum_update", span);
 }
 
 
@@ -708,6 +715,14 @@ void spectrumtab_update_plot(struct signaltab* tab)
 }
 
 
+static
+void spectrumtab_set_quality(struct signaltab* tab, int level)
+{
+	if (level >= MCP_QUALITY_SLOW_SPECTRUM)
+		tab->rate_divider *= DEGRADED_RATE_DIVIDER;
+}
+
+
 LOCAL_FN
 struct signaltab* create_tab_spectrum(const struct tabconf* conf)
 {
@@ -744,6 +759,7 @@ struct signaltab* create_tab_spectrum(const struct tabconf* conf)
 	sptab->tab.process_events = NULL;
 	sptab->tab.update_plot = spectrumtab_update_plot;
 	sptab->tab.set_wndlen = NULL;
+	sptab->tab.set_quality = spectrumtab_set_quality;
 	return &(sptab->tab);
 
 error:
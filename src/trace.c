@@ -0,0 +1,281 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <glib.h>
+#include <stdio.h>
+
+#include "trace.h"
+
+/**
+ * DOC: Timeline tracing
+ *
+ * When enabled, the spans of the operations of interest are recorded so
+ * that they can be dumped as a Chrome trace (JSON) file, viewable in
+ * chrome://tracing or Perfetto. A span is marked by trace_begin() and
+ * trace_end(), which only cost the read of a flag when tracing is
+ * disabled.
+ *
+ * Each thread records its spans in its own ring buffer, hence recording
+ * takes no lock: once the ring is full, the oldest spans are overwritten.
+ * The buffer of a thread is allocated at its first span, and is reused by
+ * a thread started after it has exited (both appear on the same line of
+ * the timeline). The dump can be done while spans are recorded, in which
+ * case the spans being overwritten may be inconsistent.
+ *
+ * The panels hold the tracing with trace_ref(). When the last one releases
+ * it, tracing stops and the buffers are freed. The threads still alive
+ * may keep a pointer to their former buffer: it is tagged with the
+ * generation of the buffers, which changes each time they are freed, so
+ * that it is never used again.
+ */
+
+/* Number of spans kept per thread (power of 2) */
+#define TRACE_RING_LEN	32768
+
+struct trace_event {
+	const char* name;
+	gint64 start;
+	gint64 end;
+};
+
+struct trace_buffer {
+	struct trace_event events[TRACE_RING_LEN];
+	volatile gint head;
+	volatile gint in_use;
+	int tid;
+	struct trace_buffer* next;
+};
+
+/* Buffer used by a thread, valid only if @gen is the current generation */
+struct trace_slot {
+	struct trace_buffer* buf;
+	gint gen;
+};
+
+static void trace_release_slot(gpointer data);
+
+static volatile gint trace_on;
+static GMutex trace_lock;
+static struct trace_buffer* trace_buffers;
+static int trace_nbuffer;
+static int trace_users;
+static volatile gint trace_gen;
+static GPrivate trace_key = G_PRIVATE_INIT(trace_release_slot);
+
+
+static
+void trace_release_slot(gpointer data)
+{
+	struct trace_slot* slot = data;
+
+	g_mutex_lock(&trace_lock);
+	if (slot->buf && slot->gen == trace_gen)
+		g_atomic_int_set(&slot->buf->in_use, 0);
+	g_mutex_unlock(&trace_lock);
+
+	g_free(slot);
+}
+
+
+static
+struct trace_buffer* trace_get_buffer(void)
+{
+	struct trace_slot* slot = g_private_get(&trace_key);
+	struct trace_buffer* buf;
+
+	if (slot && slot->buf && slot->gen == g_atomic_int_get(&trace_gen))
+		return slot->buf;
+
+	if (!slot) {
+		slot = g_malloc0(sizeof(*slot));
+		g_private_set(&trace_key, slot);
+	}
+
+	g_mutex_lock(&trace_lock);
+	for (buf = trace_buffers; buf; buf = buf->next) {
+		if (!g_atomic_int_get(&buf->in_use))
+			break;
+	}
+
+	if (!buf) {
+		buf = g_malloc0(sizeof(*buf));
+		buf->tid = ++trace_nbuffer;
+		buf->next = trace_buffers;
+		trace_buffers = buf;
+	}
+	g_atomic_int_set(&buf->in_use, 1);
+	slot->buf = buf;
+	slot->gen = trace_gen;
+	g_mutex_unlock(&trace_lock);
+
+	return buf;
+}
+
+
+/**
+ * trace_ref() - hold the tracing facility
+ *
+ * Called at the creation of a panel.
+ */
+LOCAL_FN
+void trace_ref(void)
+{
+	g_mutex_lock(&trace_lock);
+	trace_users++;
+	g_mutex_unlock(&trace_lock);
+}
+
+
+/**
+ * trace_unref() - release the tracing facility
+ *
+ * Called at the destruction of a panel, once its threads are stopped and
+ * its trace is dumped. When the last panel is destroyed, tracing is
+ * disabled and the buffers of the threads are freed.
+ */
+LOCAL_FN
+void trace_unref(void)
+{
+	struct trace_buffer *buf, *next;
+
+	g_mutex_lock(&trace_lock);
+	if (--trace_users == 0) {
+		g_atomic_int_set(&trace_on, 0);
+		g_atomic_int_inc(&trace_gen);
+		for (buf = trace_buffers; buf; buf = next) {
+			next = buf->next;
+			g_free(buf);
+		}
+		trace_buffers = NULL;
+		trace_nbuffer = 0;
+	}
+	g_mutex_unlock(&trace_lock);
+}
+
+
+/**
+ * trace_enable() - start recording the spans
+ *
+ * Tracing is process-wide and remains enabled until the last panel is
+ * destroyed.
+ */
+LOCAL_FN
+void trace_enable(void)
+{
+	g_atomic_int_set(&trace_on, 1);
+}
+
+
+LOCAL_FN
+gboolean trace_is_enabled(void)
+{
+	return g_atomic_int_get(&trace_on);
+}
+
+
+/**
+ * trace_begin() - mark the start of a span
+ *
+ * Return: the start time to pass to trace_end(), 0 if tracing is disabled
+ */
+LOCAL_FN
+gint64 trace_begin(void)
+{
+	if (!g_atomic_int_get(&trace_on))
+		return 0;
+
+	return g_get_monotonic_time();
+}
+
+
+/**
+ * trace_end() - record a span ending now
+ * @name:       name of the span. It must remain valid until the trace is
+ *              dumped, hence is typically a string literal.
+ * @start:      value returned by trace_begin() at the start of the span
+ *
+ * Nothing is recorded if tracing was disabled at the start or at the end of
+ * the span.
+ */
+LOCAL_FN
+void trace_end(const char* name, gint64 start)
+{
+	struct trace_buffer* buf;
+	struct trace_event* evt;
+	guint head;
+
+	if (!start || !g_atomic_int_get(&trace_on))
+		return;
+
+	buf = trace_get_buffer();
+	head = buf->head;
+	evt = &buf->events[head % TRACE_RING_LEN];
+	evt->name = name;
+	evt->start = start;
+	evt->end = g_get_monotonic_time();
+
+	// Publish the span once it is complete
+	g_atomic_int_set(&buf->head, head + 1);
+}
+
+
+/**
+ * trace_dump() - write the recorded spans in a Chrome trace file
+ * @filename:   path of the file to write
+ *
+ * Return: 0 in case of success, -1 otherwise
+ */
+LOCAL_FN
+int trace_dump(const char* filename)
+{
+	FILE* fp;
+	struct trace_buffer* buf;
+	struct trace_event* evt;
+	guint head, i;
+	const char* sep = "";
+
+	fp = fopen(filename, "w");
+	if (!fp)
+		return -1;
+
+	fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+	g_mutex_lock(&trace_lock);
+	for (buf = trace_buffers; buf; buf = buf->next) {
+		head = g_atomic_int_get(&buf->head);
+		i = (head > TRACE_RING_LEN) ? head - TRACE_RING_LEN : 0;
+		for (; i != head; i++) {
+			evt = &buf->events[i % TRACE_RING_LEN];
+			fprintf(fp, "%s\n{\"name\":\"%s\",\"ph\":\"X\","
+			        "\"ts\":%" G_GINT64_FORMAT ","
+			        "\"dur\":%" G_GINT64_FORMAT ","
+			        "\"pid\":1,\"tid\":%i}",
+			        sep, evt->name, evt->start,
+			        evt->end - evt->start, buf->tid);
+			sep = ",";
+		}
+	}
+	g_mutex_unlock(&trace_lock);
+
+	fprintf(fp, "\n]}\n");
+
+	return fclose(fp) ? -1 : 0;
+}
@@ -0,0 +1,31 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <glib.h>
+
+LOCAL_FN void trace_ref(void);
+LOCAL_FN void trace_unref(void);
+LOCAL_FN void trace_enable(void);
+LOCAL_FN gboolean trace_is_enabled(void);
+LOCAL_FN gint64 trace_begin(void);
+LOCAL_FN void trace_end(const char* name, gint64 start);
+LOCAL_FN int trace_dump(const char* filename);
+
+#endif /* TRACE_H */
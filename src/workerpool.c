@@ -0,0 +1,213 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "workerpool.h"
+
+/**
+ * DOC: Worker pool
+ *
+ * The worker pool runs batches of independent jobs concurrently. A batch is
+ * submitted with worker_pool_run() which returns only when all its jobs are
+ * done: it acts as a completion barrier for the caller.
+ *
+ * The jobs of a batch are not assigned to particular threads: each
+ * participating thread picks the next job index with an atomic increment
+ * until all of them are taken. The calling thread participates as well,
+ * hence a batch always makes progress even if all the pool threads are
+ * busy with batches submitted by other callers, and nested use cannot
+ * deadlock.
+ */
+
+struct worker_pool {
+	GThreadPool* threads;
+	int nthread;
+};
+
+struct batch {
+	worker_job_func func;
+	void* arg;
+	int njob;
+	volatile gint next;
+	volatile gint done;
+	volatile gint refcount;
+	GMutex mtx;
+	GCond cond;
+};
+
+
+static
+void batch_unref(struct batch* batch)
+{
+	if (!g_atomic_int_dec_and_test(&batch->refcount))
+		return;
+
+	g_mutex_clear(&batch->mtx);
+	g_cond_clear(&batch->cond);
+	g_free(batch);
+}
+
+
+static
+void batch_work(struct batch* batch)
+{
+	int job;
+
+	while (1) {
+		job = g_atomic_int_add(&batch->next, 1);
+		if (job >= batch->njob)
+			break;
+
+		batch->func(batch->arg, job);
+
+		if (g_atomic_int_add(&batch->done, 1) == batch->njob - 1) {
+			g_mutex_lock(&batch->mtx);
+			g_cond_signal(&batch->cond);
+			g_mutex_unlock(&batch->mtx);
+		}
+	}
+}
+
+
+static
+void worker_thread_func(gpointer data, gpointer user_data)
+{
+	struct batch* batch = data;
+	(void)user_data;
+
+	batch_work(batch);
+	batch_unref(batch);
+}
+
+
+/**
+ * worker_pool_create() - create a pool of worker threads
+ * @nthread:    number of threads in the pool. If 0 or less, the number of
+ *              processors is used.
+ *
+ * Return: the created pool
+ */
+LOCAL_FN
+struct worker_pool* worker_pool_create(int nthread)
+{
+	struct worker_pool* pool;
+
+	if (nthread <= 0)
+		nthread = g_get_num_processors();
+
+	pool = g_malloc0(sizeof(*pool));
+	pool->nthread = nthread;
+	pool->threads = g_thread_pool_new(worker_thread_func, NULL,
+	                                  nthread, TRUE, NULL);
+
+	return pool;
+}
+
+
+LOCAL_FN
+void worker_pool_destroy(struct worker_pool* pool)
+{
+	if (!pool)
+		return;
+
+	g_thread_pool_free(pool->threads, FALSE, TRUE);
+	g_free(pool);
+}
+
+
+/**
+ * worker_pool_run() - run a batch of jobs and wait for their completion
+ * @pool:       worker pool (if NULL, all jobs are run by the caller)
+ * @njob:       number of jobs in the batch
+ * @func:       function to run for each job
+ * @arg:        argument passed to @func along with the job index
+ *
+ * Each job index in [0, @njob) is passed exactly once to @func, possibly
+ * from different threads. This returns when all jobs have completed.
+ */
+LOCAL_FN
+void worker_pool_run(struct worker_pool* pool, int njob,
+                     worker_job_func func, void* arg)
+{
+	struct batch* batch;
+	int i, nhelper;
+
+	nhelper = pool ? MIN(njob-1, pool->nthread) : 0;
+
+	// No need of the pool machinery if the caller does everything
+	if (nhelper <= 0) {
+		for (i = 0; i < njob; i++)
+			func(arg, i);
+		return;
+	}
+
+	// Batch is reference counted since pool threads may start after all
+	// the jobs have been done
+	batch = g_malloc(sizeof(*batch));
+	*batch = (struct batch) {
+		.func = func,
+		.arg = arg,
+		.njob = njob,
+		.refcount = nhelper + 1,
+	};
+	g_mutex_init(&batch->mtx);
+	g_cond_init(&batch->cond);
+
+	for (i = 0; i < nhelper; i++)
+		g_thread_pool_push(pool->threads, batch, NULL);
+
+	batch_work(batch);
+
+	g_mutex_lock(&batch->mtx);
+	while (g_atomic_int_get(&batch->done) < njob)
+		g_cond_wait(&batch->cond, &batch->mtx);
+	g_mutex_unlock(&batch->mtx);
+
+	batch_unref(batch);
+}
+
+
+/**
+ * worker_pool_num_shards() - number of shards to split a workload into
+ * @pool:               worker pool on which the shards will be run
+ * @nitem:              number of items in the workload
+ * @min_shard_size:     minimal number of items in a shard
+ *
+ * The workload is not split if it is too small for the benefit of
+ * concurrency to outweigh the cost of the dispatch. Otherwise there is
+ * no point in having more shards than threads able to run them, ie the
+ * pool threads and the caller.
+ *
+ * Return: the number of shards, at least 1
+ */
+LOCAL_FN
+int worker_pool_num_shards(const struct worker_pool* pool,
+                           unsigned int nitem, unsigned int min_shard_size)
+{
+	int nshard;
+
+	if (!pool || min_shard_size == 0 || nitem < 2*min_shard_size)
+		return 1;
+
+	nshard = nitem / min_shard_size;
+	return MIN(nshard, pool->nthread + 1);
+}
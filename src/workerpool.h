@@ -0,0 +1,35 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <glib.h>
+
+struct worker_pool;
+
+typedef void (*worker_job_func)(void* arg, int job);
+
+LOCAL_FN struct worker_pool* worker_pool_create(int nthread);
+LOCAL_FN void worker_pool_destroy(struct worker_pool* pool);
+LOCAL_FN void worker_pool_run(struct worker_pool* pool, int njob,
+                              worker_job_func func, void* arg);
+LOCAL_FN int worker_pool_num_shards(const struct worker_pool* pool,
+                                    unsigned int nitem,
+                                    unsigned int min_shard_size);
+
+#endif /* WORKERPOOL_H */
@@ -0,0 +1,711 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <glib.h>
+#include <gtk/gtk.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mcpanel.h"
+#include "mcp_shared.h"
+#include "scope.h"
+#include "signaltab.h"
+#include "spectrum.h"
+
+/**
+ * DOC: Kernel benchmarks
+ *
+ * Each benchmark calls a kernel of the panel repeatedly on synthetic data,
+ * for every combination of its parameters, and measures the duration of
+ * each call. The results are written as one JSON document, to be compared
+ * between releases.
+ *
+ * The kernels are reached through the tabs of a panel created with the
+ * default ui definition and the "bench" configuration, which sets a
+ * different reference type for each scope tab. Hence a display is needed:
+ * without one, the benchmarks are skipped.
+ *
+ * Usage: bench-kernels [-o file] [-t min_time_ms] [-f name_filter]
+ */
+
+#define EXIT_SKIPPED	77
+
+// Minimal number of timed calls of a benchmark case
+#define MIN_ITER	20
+// Maximal number of durations kept to compute the percentiles
+#define MAX_ITER	(1 << 20)
+// Number of untimed calls before the measure
+#define WARMUP_ITER	5
+
+static const unsigned int grid_nch[] = {8, 64, 256};
+static const unsigned int grid_fs[] = {512, 2048, 16384};
+static const unsigned int grid_block[] = {32, 512};
+static const unsigned int grid_npoint[] = {128, 512, 2048};
+static const unsigned int grid_trigg_nch[] = {1, 8};
+static const unsigned int grid_nevent[] = {1, 32};
+
+#define NELEM(arr)	(sizeof(arr)/sizeof(arr[0]))
+
+static const char* const ref_names[] = {
+	"none", "car", "car_all", "electrode", "bipole",
+};
+
+#define NREF	NELEM(ref_names)
+#define MAX_NCH	256
+
+static struct panel_tabconf tabconf[NREF] = {
+	{.type = TABTYPE_SCOPE, .name = "None"},
+	{.type = TABTYPE_SCOPE, .name = "CAR selected"},
+	{.type = TABTYPE_SCOPE, .name = "CAR all"},
+	{.type = TABTYPE_SCOPE, .name = "Electrode"},
+	{.type = TABTYPE_SCOPE, .name = "Bipole"},
+};
+
+struct bench_suite {
+	FILE* out;
+	const char* filter;
+	gint64 min_time;
+	int nresult;
+	GArray* durations;
+};
+
+typedef void (*bench_func)(void* arg);
+
+
+static
+gint64 get_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (gint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+static
+int cmp_duration(const void* pa, const void* pb)
+{
+	gint64 a = *(const gint64*)pa, b = *(const gint64*)pb;
+
+	return (a > b) - (a < b);
+}
+
+
+static
+void print_double(FILE* out, const char* key, double val)
+{
+	char buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+	// Not affected by the locale set by gtk
+	fprintf(out, ", \"%s\": %s", key,
+	        g_ascii_formatd(buf, sizeof(buf), "%.1f", val));
+}
+
+
+/**
+ * run_bench() - measure a case of a benchmark and report it
+ * @suite:      benchmark suite
+ * @name:       name of the benchmark
+ * @params:     parameters of the case, as the members of a JSON object
+ * @unit:       kind of items processed by a call
+ * @nitem:      number of items processed by a call
+ * @func:       call to measure
+ * @prepare:    untimed call run before each call of @func (may be NULL)
+ * @arg:        argument of @func and @prepare
+ *
+ * @func is called until at least MIN_ITER calls have been timed and the
+ * minimal time of the suite has elapsed.
+ */
+static
+void run_bench(struct bench_suite* suite, const char* name,
+               const char* params, const char* unit, double nitem,
+               bench_func func, bench_func prepare, void* arg)
+{
+	GArray* dur = suite->durations;
+	gint64 start, t, total = 0, *d;
+	unsigned long i, niter = 0;
+	FILE* out = suite->out;
+
+	for (i = 0; i < WARMUP_ITER; i++) {
+		if (prepare)
+			prepare(arg);
+		func(arg);
+	}
+
+	g_array_set_size(dur, 0);
+	start = get_time_ns();
+	while (niter < MIN_ITER
+	       || get_time_ns() - start < suite->min_time) {
+		if (prepare)
+			prepare(arg);
+
+		t = get_time_ns();
+		func(arg);
+		t = get_time_ns() - t;
+
+		total += t;
+		if (niter++ < MAX_ITER)
+			g_array_append_val(dur, t);
+	}
+
+	d = (gint64*)dur->data;
+	qsort(d, dur->len, sizeof(*d), cmp_duration);
+
+	fprintf(out, "%s\n    {\"name\": \"%s\", \"params\": {%s}, "
+	        "\"unit\": \"%s\", \"iterations\": %lu",
+	        suite->nresult++ ? "," : "", name, params, unit, niter);
+	print_double(out, "mean_ns", (double)total / niter);
+	print_double(out, "median_ns", d[dur->len / 2]);
+	print_double(out, "p99_ns", d[(dur->len * 99) / 100]);
+	print_double(out, "min_ns", d[0]);
+	print_double(out, "items_per_s", nitem * niter * 1e9 / total);
+	fputs("}", out);
+	fflush(out);
+}
+
+
+static
+gboolean bench_selected(struct bench_suite* suite, const char* name)
+{
+	return !suite->filter || strstr(name, suite->filter);
+}
+
+
+static
+void fill_signal(float* data, unsigned int ns, unsigned int nch,
+                 unsigned int fs)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < ns; i++)
+		for (j = 0; j < nch; j++)
+			data[i*nch + j] = 100.0f * sinf(6.28f * (j+1) * i / fs)
+			                + (float)rand() / RAND_MAX;
+}
+
+
+/**
+ * flush_events() - run the main loop until a plot is up to date
+ * @area:       plot to wait for (NULL to only process the pending events)
+ *
+ * The rendering jobs complete in the main loop, hence this waits for them
+ * at most a few seconds.
+ */
+static
+void flush_events(PlotArea* area)
+{
+	gint64 deadline = g_get_monotonic_time() + 5*G_USEC_PER_SEC;
+
+	gdk_threads_enter();
+	while (1) {
+		while (gtk_events_pending())
+			gtk_main_iteration();
+
+		if (!area || plot_area_is_drawn(area)
+		    || g_get_monotonic_time() > deadline)
+			break;
+
+		g_usleep(1000);
+	}
+	gdk_threads_leave();
+}
+
+
+/**
+ * setup_scope_input() - define the input of a scope tab for a case
+ * @pan:        panel
+ * @tabid:      index of the scope tab
+ * @nch:        number of channels, all selected
+ * @fs:         sampling rate
+ * @threaded:   whether the tab may split its work on the DSP pool
+ */
+static
+void setup_scope_input(mcpanel* pan, int tabid, unsigned int nch,
+                       unsigned int fs, gboolean threaded)
+{
+	static char labelbuf[MAX_NCH][8];
+	static const char* labels[MAX_NCH];
+	int indices[MAX_NCH];
+	unsigned int i;
+
+	for (i = 0; i < nch; i++) {
+		sprintf(labelbuf[i], "ch%u", i+1);
+		labels[i] = labelbuf[i];
+		indices[i] = i;
+	}
+
+	pan->tabs[tabid]->source->pool = threaded ? pan->dsp_pool : NULL;
+
+	gdk_threads_enter();
+	mcp_define_tab_input(pan, tabid, nch, fs, labels);
+	mcp_select_tab_channels(pan, tabid, nch, indices);
+	gdk_threads_leave();
+}
+
+
+/**************************************************************************
+ *                                                                        *
+ *                            process_chunk                               *
+ *                                                                        *
+ **************************************************************************/
+struct chunk_case {
+	struct signaltab* tab;
+	unsigned int ns;
+	const float* data;
+};
+
+
+static
+void run_process_data(void* arg)
+{
+	struct chunk_case* c = arg;
+
+	c->tab->process_data(c->tab, c->ns, c->data);
+}
+
+
+static
+void bench_process_chunk(struct bench_suite* suite, mcpanel* pan)
+{
+	unsigned int r, i, j, k, nch, fs, ns;
+	int threaded;
+	char params[256];
+	float* data;
+	struct chunk_case c;
+
+	if (!bench_selected(suite, "process_chunk"))
+		return;
+
+	data = g_malloc(MAX_NCH * grid_block[NELEM(grid_block)-1]
+	                * sizeof(*data));
+
+	for (r = 0; r < NREF; r++)
+	for (threaded = 0; threaded < 2; threaded++)
+	for (i = 0; i < NELEM(grid_nch); i++)
+	for (j = 0; j < NELEM(grid_fs); j++) {
+		nch = grid_nch[i];
+		fs = grid_fs[j];
+		setup_scope_input(pan, r, nch, fs, threaded);
+
+		for (k = 0; k < NELEM(grid_block); k++) {
+			ns = grid_block[k];
+			fill_signal(data, ns, nch, fs);
+			c = (struct chunk_case) {.tab = pan->tabs[r],
+			                         .ns = ns, .data = data};
+
+			sprintf(params, "\"ref\": \"%s\", \"threaded\": %s, "
+			        "\"nch\": %u, \"fs\": %u, \"block\": %u",
+			        ref_names[r], threaded ? "true" : "false",
+			        nch, fs, ns);
+			run_bench(suite, "process_chunk", params, "samples",
+			          ns, run_process_data, NULL, &c);
+		}
+	}
+
+	g_free(data);
+}
+
+
+/**************************************************************************
+ *                                                                        *
+ *                               spectrum                                 *
+ *                                                                        *
+ **************************************************************************/
+struct spectrum_case {
+	struct spectrum sp;
+	unsigned int ns;
+	const float* data;
+	float* amplitude;
+};
+
+
+static
+void run_spectrum_update(void* arg)
+{
+	struct spectrum_case* c = arg;
+
+	spectrum_update(&c->sp, c->ns, c->data);
+}
+
+
+static
+void run_spectrum_get(void* arg)
+{
+	struct spectrum_case* c = arg;
+
+	spectrum_get(&c->sp, c->sp.wlen, c->amplitude);
+}
+
+
+static
+void bench_spectrum(struct bench_suite* suite)
+{
+	unsigned int i, k, npoint, ns;
+	char params[128];
+	struct spectrum_case c = {.sp = {0}};
+	float* data;
+
+	data = g_malloc(grid_block[NELEM(grid_block)-1] * sizeof(*data));
+
+	for (i = 0; i < NELEM(grid_npoint); i++) {
+		npoint = grid_npoint[i];
+		spectrum_init(&c.sp, npoint);
+		c.amplitude = g_malloc(c.sp.wlen * sizeof(*c.amplitude));
+		c.data = data;
+
+		for (k = 0; k < NELEM(grid_block); k++) {
+			ns = grid_block[k];
+			fill_signal(data, ns, 1, npoint);
+			c.ns = ns;
+
+			sprintf(params, "\"npoint\": %u, \"block\": %u",
+			        npoint, ns);
+			if (bench_selected(suite, "spectrum_update"))
+				run_bench(suite, "spectrum_update", params,
+				          "samples", ns,
+				          run_spectrum_update, NULL, &c);
+		}
+
+		sprintf(params, "\"npoint\": %u", npoint);
+		if (bench_selected(suite, "spectrum_get"))
+			run_bench(suite, "spectrum_get", params,
+			          "frequencies", c.sp.wlen,
+			          run_spectrum_get, NULL, &c);
+
+		g_free(c.amplitude);
+		spectrum_deinit(&c.sp);
+	}
+
+	g_free(data);
+}
+
+
+/**************************************************************************
+ *                                                                        *
+ *                              process_tri                               *
+ *                                                                        *
+ **************************************************************************/
+struct tri_case {
+	mcpanel* pan;
+	unsigned int ns;
+	const uint32_t* trigg;
+};
+
+
+static
+void run_add_triggers(void* arg)
+{
+	struct tri_case* c = arg;
+
+	mcp_add_triggers(c->pan, c->ns, c->trigg);
+}
+
+
+static
+void bench_process_tri(struct bench_suite* suite, mcpanel* pan)
+{
+	static const char* labels[] = {"tri1", "tri2", "tri3", "tri4",
+	                               "tri5", "tri6", "tri7", "tri8"};
+	unsigned int i, j, k, n, nch, fs, ns;
+	char params[128];
+	uint32_t* trigg;
+	struct tri_case c = {.pan = pan};
+
+	if (!bench_selected(suite, "process_tri"))
+		return;
+
+	n = grid_trigg_nch[NELEM(grid_trigg_nch)-1]
+	  * grid_block[NELEM(grid_block)-1];
+	trigg = g_malloc(n * sizeof(*trigg));
+	for (i = 0; i < n; i++)
+		trigg[i] = (i / 64) | ((i % 3) ? 0x100000 : 0);
+
+	for (i = 0; i < NELEM(grid_trigg_nch); i++)
+	for (j = 0; j < NELEM(grid_fs); j++) {
+		nch = grid_trigg_nch[i];
+		fs = grid_fs[j];
+		mcp_define_trigg_input(pan, 16, nch, fs, labels);
+
+		// The selection is normally done in the trigger combo
+		pan->trigg_selch = 0;
+
+		for (k = 0; k < NELEM(grid_block); k++) {
+			ns = grid_block[k];
+			c.ns = ns;
+			c.trigg = trigg;
+
+			sprintf(params, "\"nch\": %u, \"fs\": %u, \"block\": %u",
+			        nch, fs, ns);
+			run_bench(suite, "process_tri", params, "samples", ns,
+			          run_add_triggers, NULL, &c);
+		}
+	}
+
+	g_free(trigg);
+}
+
+
+/**************************************************************************
+ *                                                                        *
+ *                              scope events                              *
+ *                                                                        *
+ **************************************************************************/
+struct event_case {
+	Scope* scope;
+	unsigned int ns;
+	int nevent;
+	int ns_total;
+	struct mcp_event* events;
+};
+
+
+/* Position the events of the next block */
+static
+void fill_events(struct event_case* c)
+{
+	int i;
+
+	for (i = 0; i < c->nevent; i++) {
+		c->events[i].pos = c->ns_total + (i * (int)c->ns) / c->nevent;
+		c->events[i].type = i % 8;
+	}
+}
+
+
+static
+void run_add_events(void* arg)
+{
+	struct event_case* c = arg;
+
+	scope_add_events(c->scope, c->nevent, c->events);
+}
+
+
+/* Advance the data of the scope by a block, merging the staged events */
+static
+void run_update_events(void* arg)
+{
+	struct event_case* c = arg;
+
+	c->ns_total += c->ns;
+	scope_update_data(c->scope, c->ns_total % c->scope->num_points,
+	                  c->ns_total);
+}
+
+
+static
+void prepare_add_events(void* arg)
+{
+	run_update_events(arg);
+	fill_events(arg);
+}
+
+
+static
+void prepare_update_events(void* arg)
+{
+	fill_events(arg);
+	run_add_events(arg);
+}
+
+
+static
+void bench_scope_events(struct bench_suite* suite, mcpanel* pan)
+{
+	unsigned int i, j, k, fs;
+	char params[128];
+	struct event_case c = {.scope = SCOPE(pan->tabs[0]->plot)};
+
+	if (!bench_selected(suite, "scope_"))
+		return;
+
+	c.events = g_malloc(grid_nevent[NELEM(grid_nevent)-1]
+	                    * sizeof(*c.events));
+
+	for (j = 0; j < NELEM(grid_fs); j++) {
+		fs = grid_fs[j];
+		setup_scope_input(pan, 0, grid_nch[0], fs, FALSE);
+		flush_events(NULL);
+
+		for (i = 0; i < NELEM(grid_nevent); i++)
+		for (k = 0; k < NELEM(grid_block); k++) {
+			c.nevent = grid_nevent[i];
+			c.ns = grid_block[k];
+			sprintf(params, "\"fs\": %u, \"block\": %u, "
+			        "\"nevent\": %u", fs, c.ns, c.nevent);
+
+			// Events are staged by the processing thread, then
+			// merged in the main loop at the update of the tab
+			if (bench_selected(suite, "scope_add_events"))
+				run_bench(suite, "scope_add_events", params,
+				          "events", c.nevent, run_add_events,
+				          prepare_add_events, &c);
+			if (bench_selected(suite, "scope_update_events"))
+				run_bench(suite, "scope_update_events", params,
+				          "events", c.nevent, run_update_events,
+				          prepare_update_events, &c);
+		}
+
+		// Let the rendering queued by the updates complete
+		flush_events(PLOT_AREA(c.scope));
+	}
+
+	g_free(c.events);
+}
+
+
+/**************************************************************************
+ *                                                                        *
+ *                             scope rendering                            *
+ *                                                                        *
+ **************************************************************************/
+static
+void run_rasterize(void* arg)
+{
+	PlotArea* area = arg;
+
+	plot_area_lock_raster(area);
+	area->job_full = TRUE;
+	PLOT_AREA_GET_CLASS(area)->rasterize(area);
+	plot_area_unlock_raster(area);
+}
+
+
+static
+void bench_scope_raster(struct bench_suite* suite, mcpanel* pan)
+{
+	unsigned int i, j, nch, fs;
+	char params[128];
+	struct signaltab* tab = pan->tabs[0];
+	Scope* scope = SCOPE(tab->plot);
+	PlotArea* area = PLOT_AREA(scope);
+	float* data;
+
+	if (!bench_selected(suite, "scope_rasterize"))
+		return;
+
+	data = g_malloc((gsize)MAX_NCH * grid_fs[NELEM(grid_fs)-1]
+	                * sizeof(*data));
+
+	for (i = 0; i < NELEM(grid_nch); i++)
+	for (j = 0; j < NELEM(grid_fs); j++) {
+		nch = grid_nch[i];
+		fs = grid_fs[j];
+		setup_scope_input(pan, 0, nch, fs, FALSE);
+
+		// Fill the whole time window and let a first rendering set
+		// up the raster to the size of the widget
+		fill_signal(data, fs, nch, fs);
+		tab->process_data(tab, fs, data);
+		gdk_threads_enter();
+		signaltab_update_plot(tab);
+		gdk_threads_leave();
+		flush_events(area);
+
+		// Samples are drawn as points converted to lines in full
+		// resolution, otherwise as the envelopes of the columns
+		sprintf(params, "\"nch\": %u, \"fs\": %u, \"rows\": %u, "
+		        "\"envelopes\": %s", nch, fs, scope->num_rows,
+		        scope->num_cols ? "true" : "false");
+		run_bench(suite, "scope_rasterize", params, "points",
+		          (double)scope->num_points * scope->num_rows,
+		          run_rasterize, NULL, area);
+	}
+
+	g_free(data);
+}
+
+
+int main(int argc, char* argv[])
+{
+	mcpanel* pan;
+	struct PanelCb cb = {.confname = "bench"};
+	gchar* outname = NULL;
+	gchar* filter = NULL;
+	gint min_time = 100;
+	GOptionContext* optctx;
+	GError* error = NULL;
+	GOptionEntry entries[] = {
+		{"output", 'o', 0, G_OPTION_ARG_FILENAME, &outname,
+		 "Write the results in FILE instead of stdout", "FILE"},
+		{"min-time", 't', 0, G_OPTION_ARG_INT, &min_time,
+		 "Minimal time spent on each case (default 100)", "MS"},
+		{"filter", 'f', 0, G_OPTION_ARG_STRING, &filter,
+		 "Run only the benchmarks whose name contains STR", "STR"},
+		{NULL},
+	};
+	struct bench_suite suite = {.out = stdout};
+
+	optctx = g_option_context_new("- benchmark the kernels of mcpanel");
+	g_option_context_add_main_entries(optctx, entries, NULL);
+	if (!g_option_context_parse(optctx, &argc, &argv, &error)) {
+		fprintf(stderr, "%s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	g_option_context_free(optctx);
+
+	if (!g_getenv("DISPLAY")) {
+		fprintf(stderr, "No display, benchmarks skipped\n");
+		return EXIT_SKIPPED;
+	}
+
+	mcp_init_lib(&argc, &argv);
+	pan = mcp_create(NULL, &cb, NREF, tabconf);
+	if (!pan) {
+		fprintf(stderr, "error at the creation of the panel\n");
+		return EXIT_FAILURE;
+	}
+	mcp_show(pan, 1);
+	flush_events(NULL);
+
+	if (outname && !(suite.out = fopen(outname, "w"))) {
+		perror(outname);
+		return EXIT_FAILURE;
+	}
+	suite.filter = filter;
+	suite.min_time = (gint64)min_time * 1000000;
+	suite.durations = g_array_new(FALSE, FALSE, sizeof(gint64));
+
+	fprintf(suite.out, "{\n  \"suite\": \"mcpanel-kernels\",\n"
+	        "  \"version\": \"%s\",\n  \"min_time_ms\": %i,\n"
+	        "  \"dsp_threads\": %u,\n  \"results\": [",
+	        MCPANEL_VERSION, min_time, g_get_num_processors());
+
+	bench_process_chunk(&suite, pan);
+	bench_spectrum(&suite);
+	bench_process_tri(&suite, pan);
+	bench_scope_events(&suite, pan);
+	bench_scope_raster(&suite, pan);
+
+	fprintf(suite.out, "\n  ]\n}\n");
+	if (suite.out != stdout)
+		fclose(suite.out);
+
+	g_array_free(suite.durations, TRUE);
+	mcp_destroy(pan);
+	g_free(outname);
+	g_free(filter);
+
+	return EXIT_SUCCESS;
+}
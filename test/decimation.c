@@ -0,0 +1,237 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <glib.h>
+#include <math.h>
+#include <string.h>
+
+#include "decimator.h"
+#include "unittest.h"
+
+/*
+ * Unit tests of the display decimator: the output must keep the DC level
+ * and the tones below the output Nyquist frequency, and must not show the
+ * tones above it, which would otherwise alias in the display.
+ */
+
+#define NCH		2
+#define MAXNS		100
+#define NSAMPLES	8000
+
+/**
+ * decimate() - run a decimator on a whole signal
+ * @factor:     decimation factor
+ * @in:         input signal of NSAMPLES samples of NCH channels
+ * @out:        array receiving the output (NSAMPLES/@factor samples)
+ * @delay:      pointer receiving the group delay of the decimator
+ *
+ * The input is passed by chunks of varying length, as the scope does.
+ *
+ * Return: the number of output samples
+ */
+static
+unsigned int decimate(unsigned int factor, const float* in, float* out,
+                      unsigned int* delay)
+{
+	struct decimator dec;
+	unsigned int i, ns, nout = 0;
+
+	decimator_init(&dec);
+	decimator_setup(&dec, factor, NCH, MAXNS);
+	*delay = decimator_delay(&dec);
+
+	for (i = 0; i < NSAMPLES; i += ns) {
+		ns = MIN(1 + (i*7) % MAXNS, NSAMPLES - i);
+		memcpy(decimator_get_input(&dec), in + i*NCH,
+		       ns*NCH*sizeof(*in));
+		decimator_run(&dec, ns, out + nout*NCH, 0, NCH);
+		nout += decimator_num_output(&dec, ns);
+		decimator_advance(&dec, ns);
+	}
+
+	decimator_deinit(&dec);
+	return nout;
+}
+
+
+/**
+ * gen_signal() - fill the input with a DC level and a tone
+ * @in:         array of NSAMPLES samples of NCH channels
+ * @dc:         level of the first channel
+ * @freq:       frequency of the tone of the second channel, normalized by
+ *              the input sampling frequency
+ */
+static
+void gen_signal(float* in, float dc, double freq)
+{
+	unsigned int i;
+
+	for (i = 0; i < NSAMPLES; i++) {
+		in[i*NCH] = dc;
+		in[i*NCH+1] = sin(2*M_PI*freq*i);
+	}
+}
+
+
+/**
+ * first_settled() - index of the first output not affected by the start
+ * @factor:     decimation factor
+ * @delay:      group delay of the decimator
+ *
+ * Return: the index of the first output whose filter window lies entirely
+ * in the input signal
+ */
+static
+unsigned int first_settled(unsigned int factor, unsigned int delay)
+{
+	return (2*delay) / factor;
+}
+
+
+static
+int test_num_output(void)
+{
+	static const unsigned int factors[] = {1, 2, 3, 8, 13, 32};
+	struct decimator dec;
+	unsigned int i, factor, ns, total, nout;
+
+	for (i = 0; i < sizeof(factors)/sizeof(factors[0]); i++) {
+		factor = factors[i];
+		decimator_init(&dec);
+		decimator_setup(&dec, factor, NCH, MAXNS);
+
+		// One output every factor inputs, whatever the chunks
+		total = nout = 0;
+		for (ns = 1; total + ns <= 10*MAXNS; ns = 1 + (ns*5) % MAXNS) {
+			nout += decimator_num_output(&dec, ns);
+			if (factor > 1)
+				decimator_advance(&dec, ns);
+			total += ns;
+		}
+		CHECK(nout == total / factor);
+		CHECK(decimator_delay(&dec) == (factor > 1 ? 4*factor : 0));
+
+		decimator_deinit(&dec);
+	}
+
+	return 0;
+}
+
+
+static
+int test_dc_gain(void)
+{
+	static const unsigned int factors[] = {2, 3, 8, 13, 32};
+	float* in = g_malloc(NSAMPLES*NCH*sizeof(*in));
+	float* out = g_malloc(NSAMPLES*NCH*sizeof(*out));
+	unsigned int i, m, factor, delay, nout;
+
+	gen_signal(in, -3.0f, 0.0);
+
+	for (i = 0; i < sizeof(factors)/sizeof(factors[0]); i++) {
+		factor = factors[i];
+		nout = decimate(factor, in, out, &delay);
+		CHECK(nout == NSAMPLES / factor);
+
+		for (m = first_settled(factor, delay); m < nout; m++)
+			CHECK(fabsf(out[m*NCH] + 3.0f) < 1e-4f);
+	}
+
+	g_free(in);
+	g_free(out);
+	return 0;
+}
+
+
+/**
+ * tone_amplitude() - amplitude of the decimated tone
+ * @factor:     decimation factor
+ * @freq:       frequency of the tone normalized by the output Nyquist
+ *              frequency
+ *
+ * The output samples may miss the peaks of the tone, hence the amplitude is
+ * estimated from the power of the output.
+ *
+ * Return: the amplitude of the tone in the settled output
+ */
+static
+float tone_amplitude(unsigned int factor, double freq)
+{
+	float* in = g_malloc(NSAMPLES*NCH*sizeof(*in));
+	float* out = g_malloc(NSAMPLES*NCH*sizeof(*out));
+	unsigned int m, m0, delay, nout;
+	double power = 0.0;
+
+	gen_signal(in, 0.0f, 0.5*freq/factor);
+	nout = decimate(factor, in, out, &delay);
+	m0 = first_settled(factor, delay);
+	for (m = m0; m < nout; m++)
+		power += out[m*NCH+1] * out[m*NCH+1];
+
+	g_free(in);
+	g_free(out);
+	return sqrt(2.0 * power / (nout - m0));
+}
+
+
+static
+int test_passband(void)
+{
+	// The tones to display are kept, the cutoff being at 0.8 times the
+	// output Nyquist frequency
+	CHECK(fabsf(tone_amplitude(8, 0.2) - 1.0f) < 1e-2f);
+	CHECK(tone_amplitude(13, 0.5) > 0.85f);
+
+	return 0;
+}
+
+
+static
+int test_aliasing(void)
+{
+	static const unsigned int factors[] = {2, 8, 13, 32};
+	static const double freqs[] = {1.5, 2.0, 3.7, 6.0};
+	unsigned int i, j;
+
+	// Past the transition band, the tones that would alias in the
+	// display are removed (the input Nyquist frequency being @factor)
+	for (i = 0; i < sizeof(factors)/sizeof(factors[0]); i++)
+		for (j = 0; j < sizeof(freqs)/sizeof(freqs[0]); j++)
+			if (freqs[j] < factors[i])
+				CHECK(tone_amplitude(factors[i], freqs[j])
+				      < 1e-3f);
+
+	return 0;
+}
+
+
+static const struct unittest tests[] = {
+	{"num-output", test_num_output},
+	{"dc-gain", test_dc_gain},
+	{"passband", test_passband},
+	{"aliasing", test_aliasing},
+};
+
+
+int main(void)
+{
+	return run_unittests(tests, sizeof(tests)/sizeof(tests[0]));
+}
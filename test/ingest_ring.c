@@ -0,0 +1,300 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <glib.h>
+#include <stdint.h>
+
+#include "ingest.h"
+#include "unittest.h"
+
+/*
+ * Unit tests of the ingestion ring. The frames are made of NCH counters:
+ * frame i holds i*NCH, i*NCH+1, ... so that any lost, duplicated or
+ * reordered frame is detected when reading.
+ */
+
+#define NCH		3
+#define CAPACITY	8
+#define FRAME_SIZE	(NCH*sizeof(int32_t))
+
+static
+void fill_frames(int32_t* frames, unsigned int first, unsigned int ns)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < ns; i++)
+		for (j = 0; j < NCH; j++)
+			frames[i*NCH+j] = (first+i)*NCH + j;
+}
+
+
+static
+int check_frames(const int32_t* frames, unsigned int first, unsigned int ns)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < ns; i++)
+		for (j = 0; j < NCH; j++)
+			if (frames[i*NCH+j] != (int32_t)((first+i)*NCH + j))
+				return -1;
+
+	return 0;
+}
+
+
+static
+void write_frames(struct ingest_ring* ring, unsigned int first,
+                  unsigned int ns)
+{
+	int32_t frames[ns*NCH];
+
+	fill_frames(frames, first, ns);
+	ingest_ring_write(ring, ns, frames);
+}
+
+
+static
+int test_wraparound(void)
+{
+	struct ingest_ring ring;
+	int32_t frames[CAPACITY*NCH];
+	unsigned int i, ns, pos = 0;
+
+	ingest_ring_init(&ring, FRAME_SIZE, CAPACITY-1, OVERFLOW_BLOCK);
+	CHECK(ring.capacity == CAPACITY);
+
+	// Start close to the wrap of the free running counters
+	ring.head = ring.tail = (gint)(G_MAXUINT - 2*CAPACITY);
+
+	for (i = 0; i < 50; i++) {
+		ns = 1 + (i % CAPACITY);
+		write_frames(&ring, pos, ns);
+		CHECK(ingest_ring_read(&ring, CAPACITY, frames) == ns);
+		CHECK(check_frames(frames, pos, ns) == 0);
+		pos += ns;
+	}
+
+	// Frames wrapping at the end of the buffer, read by smaller pieces
+	write_frames(&ring, pos, CAPACITY);
+	CHECK(ingest_ring_read(&ring, 3, frames) == 3);
+	CHECK(check_frames(frames, pos, 3) == 0);
+	CHECK(ingest_ring_read(&ring, CAPACITY, frames) == CAPACITY-3);
+	CHECK(check_frames(frames, pos+3, CAPACITY-3) == 0);
+
+	CHECK(ingest_ring_get_dropped(&ring) == 0);
+	ingest_ring_deinit(&ring);
+	return 0;
+}
+
+
+static
+gpointer write_thread(gpointer arg)
+{
+	struct ingest_ring* ring = arg;
+
+	write_frames(ring, 0, 5*CAPACITY);
+	return NULL;
+}
+
+
+static
+int test_policy_block(void)
+{
+	struct ingest_ring ring;
+	int32_t frames[CAPACITY*NCH];
+	unsigned int ns, pos = 0;
+	GThread* thread;
+
+	ingest_ring_init(&ring, FRAME_SIZE, CAPACITY, OVERFLOW_BLOCK);
+
+	// The writer waits for the reader instead of losing frames
+	thread = g_thread_new(NULL, write_thread, &ring);
+	while (pos < 5*CAPACITY) {
+		ns = ingest_ring_read(&ring, 3, frames);
+		CHECK(ns > 0);
+		CHECK(check_frames(frames, pos, ns) == 0);
+		pos += ns;
+	}
+	g_thread_join(thread);
+
+	CHECK(ingest_ring_get_dropped(&ring) == 0);
+	ingest_ring_deinit(&ring);
+	return 0;
+}
+
+
+static
+int test_policy_drop_oldest(void)
+{
+	struct ingest_ring ring;
+	int32_t frames[CAPACITY*NCH];
+
+	ingest_ring_init(&ring, FRAME_SIZE, CAPACITY, OVERFLOW_DROP_OLDEST);
+
+	// Only the frames not fitting are dropped
+	write_frames(&ring, 0, 5);
+	write_frames(&ring, 5, 6);
+	CHECK(ingest_ring_get_dropped(&ring) == 3);
+	CHECK(ingest_ring_read(&ring, CAPACITY, frames) == CAPACITY);
+	CHECK(check_frames(frames, 3, CAPACITY) == 0);
+
+	// A write larger than the ring keeps its most recent frames
+	write_frames(&ring, 100, 3*CAPACITY);
+	CHECK(ingest_ring_get_dropped(&ring) == 3 + 2*CAPACITY);
+	CHECK(ingest_ring_read(&ring, CAPACITY, frames) == CAPACITY);
+	CHECK(check_frames(frames, 100+2*CAPACITY, CAPACITY) == 0);
+
+	ingest_ring_deinit(&ring);
+	return 0;
+}
+
+
+static
+int test_policy_coalesce(void)
+{
+	struct ingest_ring ring;
+	int32_t frames[CAPACITY*NCH];
+
+	ingest_ring_init(&ring, FRAME_SIZE, CAPACITY, OVERFLOW_COALESCE);
+
+	// Nothing is dropped as long as the frames fit
+	write_frames(&ring, 0, 5);
+	write_frames(&ring, 5, 3);
+	CHECK(ingest_ring_get_dropped(&ring) == 0);
+
+	// On overflow, all unread frames are discarded
+	write_frames(&ring, 8, 6);
+	CHECK(ingest_ring_get_dropped(&ring) == 8);
+	CHECK(ingest_ring_read(&ring, CAPACITY, frames) == 6);
+	CHECK(check_frames(frames, 8, 6) == 0);
+
+	ingest_ring_deinit(&ring);
+	return 0;
+}
+
+
+struct blocked_write {
+	struct ingest_ring* ring;
+	volatile gint done;
+};
+
+
+static
+gpointer blocked_write_thread(gpointer arg)
+{
+	struct blocked_write* bw = arg;
+
+	write_frames(bw->ring, CAPACITY, 4);
+	g_atomic_int_set(&bw->done, 1);
+	return NULL;
+}
+
+
+static
+int test_inplace_handshake(void)
+{
+	struct ingest_ring ring;
+	struct blocked_write bw = {.ring = &ring, .done = 0};
+	int32_t buf[CAPACITY*NCH];
+	const void* data;
+	unsigned int ns;
+	GThread* thread;
+
+	ingest_ring_init(&ring, FRAME_SIZE, CAPACITY, OVERFLOW_BLOCK);
+	write_frames(&ring, 0, CAPACITY);
+
+	// With OVERFLOW_BLOCK, the frames are processed in the ring memory
+	ns = ingest_ring_peek(&ring, CAPACITY, buf, &data);
+	CHECK(ns == CAPACITY);
+	CHECK(data != buf);
+	CHECK(check_frames(data, 0, ns) == 0);
+
+	// A producer allowed to drop must wait for the in-place frames
+	ingest_ring_set_policy(&ring, OVERFLOW_DROP_OLDEST);
+	thread = g_thread_new(NULL, blocked_write_thread, &bw);
+	g_usleep(50000);
+	CHECK(!g_atomic_int_get(&bw.done));
+	CHECK(ingest_ring_get_dropped(&ring) == 0);
+	CHECK(check_frames(data, 0, ns) == 0);
+
+	ingest_ring_release(&ring, ns);
+	g_thread_join(thread);
+	CHECK(ingest_ring_get_dropped(&ring) == 0);
+
+	// With a dropping policy, the frames are copied out
+	ns = ingest_ring_peek(&ring, CAPACITY, buf, &data);
+	CHECK(ns == 4);
+	CHECK(data == buf);
+	CHECK(check_frames(data, CAPACITY, ns) == 0);
+	ingest_ring_release(&ring, ns);
+
+	// So they are while the producer is dropping frames
+	ingest_ring_set_policy(&ring, OVERFLOW_BLOCK);
+	write_frames(&ring, 0, 2);
+	ring.dropping = 1;
+	ns = ingest_ring_peek(&ring, CAPACITY, buf, &data);
+	ring.dropping = 0;
+	CHECK(ns == 2);
+	CHECK(data == buf);
+	CHECK(check_frames(data, 0, ns) == 0);
+	ingest_ring_release(&ring, ns);
+	CHECK(ring.head == ring.tail);
+
+	ingest_ring_deinit(&ring);
+	return 0;
+}
+
+
+static
+int test_stop(void)
+{
+	struct ingest_ring ring;
+	int32_t frames[CAPACITY*NCH];
+
+	ingest_ring_init(&ring, FRAME_SIZE, CAPACITY, OVERFLOW_BLOCK);
+	write_frames(&ring, 0, CAPACITY);
+	ingest_ring_stop(&ring);
+
+	// A stopped ring neither blocks the writer nor the reader
+	write_frames(&ring, CAPACITY, 1);
+	CHECK(ingest_ring_read(&ring, CAPACITY, frames) == CAPACITY);
+	CHECK(check_frames(frames, 0, CAPACITY) == 0);
+	CHECK(ingest_ring_read(&ring, CAPACITY, frames) == 0);
+
+	ingest_ring_deinit(&ring);
+	return 0;
+}
+
+
+static const struct unittest tests[] = {
+	{"wraparound", test_wraparound},
+	{"policy-block", test_policy_block},
+	{"policy-drop-oldest", test_policy_drop_oldest},
+	{"policy-coalesce", test_policy_coalesce},
+	{"inplace-handshake", test_inplace_handshake},
+	{"stop", test_stop},
+};
+
+
+int main(void)
+{
+	return run_unittests(tests, sizeof(tests)/sizeof(tests[0]));
+}
@@ -0,0 +1,768 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <glib.h>
+#include <math.h>
+#include <mcpanel.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * DOC: Synthetic load generator
+ *
+ * Drives a panel through the public API with the load described by a
+ * scenario file, and reports the throughput sustained by the panel and the
+ * samples it has dropped. The scenario file is a key file whose "scenario"
+ * group may set the following keys:
+ *
+ * duration:          length of the run in seconds (default 10)
+ * channels:          number of channels of each source (default 64)
+ * sampling-rate:     sampling rate in Hz (default 2048)
+ * block-size:        number of samples submitted at once (default 32)
+ * tabs:              number of tabs (default 3)
+ * tab-types:         list of the types of tab (scope, bargraph or spectrum)
+ *                    assigned in turn to the tabs (default scope)
+ * sources:           number of distinct inputs, the tabs being assigned in
+ *                    turn to them (default one per tab)
+ * producer-threads:  number of threads submitting the samples, the sources
+ *                    being assigned in turn to them (default 1)
+ * event-rate:        mean number of events per second added to each tab
+ *                    (default 0)
+ * trigger-channels:  number of trigger channels (default 1, 0 disables the
+ *                    triggers)
+ * trigger-density:   fraction of the samples at which the triggers change
+ *                    (default 0.001)
+ * overflow-policy:   block, drop-oldest or coalesce (default block)
+ * config:            name of the configuration file of the panel (default
+ *                    mcpanel)
+ *
+ * Each producer thread submits a block of each of its sources every
+ * block-size/sampling-rate seconds. When the panel cannot keep up, the
+ * producers fall behind schedule (with the block policy) or the samples
+ * are dropped (with the other policies).
+ *
+ * The exit status is 0 only if the load has been sustained, ie, if the
+ * producers have kept up with real time and no sample has been dropped.
+ *
+ * Usage: mcpanel-loadgen [-i report_interval_s] scenario_file
+ */
+
+#define SCENARIO_GROUP	"scenario"
+
+// Number of distinct blocks of samples generated for each source
+#define NPREGEN_BLOCK	16
+#define NTRIGG_LINE	16
+
+static const char* const tabtype_names[] = {
+	[TABTYPE_SCOPE] = "scope",
+	[TABTYPE_BARGRAPH] = "bargraph",
+	[TABTYPE_SPECTRUM] = "spectrum",
+};
+
+static const char* const policy_names[] = {
+	[OVERFLOW_BLOCK] = "block",
+	[OVERFLOW_DROP_OLDEST] = "drop-oldest",
+	[OVERFLOW_COALESCE] = "coalesce",
+};
+
+static const char* const quality_names[] = {
+	[MCP_QUALITY_FULL] = "full",
+	[MCP_QUALITY_REDUCED_RATE] = "reduced-rate",
+	[MCP_QUALITY_FEWER_CHANNELS] = "fewer-channels",
+	[MCP_QUALITY_SLOW_SPECTRUM] = "slow-spectrum",
+	[MCP_QUALITY_SKIP_FRAMES] = "skip-frames",
+};
+
+#define NELEM(arr)	(sizeof(arr)/sizeof(arr[0]))
+
+#define BAR_NSCALES 2
+static const char* bar_sclabels[BAR_NSCALES] = {"25 mV", "50 mV"};
+static const float bar_scales[BAR_NSCALES] = {25.0e3, 50.0e3};
+
+struct scenario {
+	double duration;
+	unsigned int nch;
+	unsigned int fs;
+	unsigned int blksize;
+	int ntab;
+	int nsource;
+	int nthread;
+	double event_rate;
+	unsigned int trigg_nch;
+	double trigg_density;
+	enum overflow_policy policy;
+	gchar* config;
+	enum tabtype* tabtypes;
+};
+
+struct source_load {
+	int id;
+	float* data;
+	unsigned int iblk;
+	unsigned int isample;
+	double next_event;
+};
+
+struct producer {
+	GThread* thread;
+	struct load_gen* gen;
+	int id;
+	int nsource;
+	GRand* rand;
+	uint32_t* trigg;
+	uint32_t trigg_val;
+
+	// Number of rounds of submission done, of rounds ended later than one
+	// block period after their schedule and maximal lag (in microseconds)
+	volatile gint nround;
+	volatile gint nlate;
+	volatile gint max_lag;
+};
+
+struct load_gen {
+	struct scenario sc;
+	mcpanel* pan;
+	volatile gint run;
+	gint64 start_time;
+	struct source_load* sources;
+	struct producer* producers;
+};
+
+struct load_snapshot {
+	gint64 time;
+	guint64 nsubmitted;
+	unsigned long ndropped;
+	int nlate;
+};
+
+
+/**************************************************************************
+ *                                                                        *
+ *                         Scenario parsing                               *
+ *                                                                        *
+ **************************************************************************/
+static
+int key_is_missing(GError* error)
+{
+	return error->code == G_KEY_FILE_ERROR_KEY_NOT_FOUND
+	       || error->code == G_KEY_FILE_ERROR_GROUP_NOT_FOUND;
+}
+
+
+static
+int get_int_key(GKeyFile* keyfile, const char* key, int defval, int minval)
+{
+	GError* error = NULL;
+	int val;
+
+	val = g_key_file_get_integer(keyfile, SCENARIO_GROUP, key, &error);
+	if (error) {
+		if (!key_is_missing(error)) {
+			fprintf(stderr, "%s: %s\n", key, error->message);
+			g_error_free(error);
+			return -1;
+		}
+		g_error_free(error);
+		val = defval;
+	}
+
+	if (val < minval) {
+		fprintf(stderr, "%s: invalid value %i\n", key, val);
+		return -1;
+	}
+
+	return val;
+}
+
+
+static
+double get_double_key(GKeyFile* keyfile, const char* key, double defval)
+{
+	GError* error = NULL;
+	double val;
+
+	val = g_key_file_get_double(keyfile, SCENARIO_GROUP, key, &error);
+	if (error) {
+		if (!key_is_missing(error)) {
+			fprintf(stderr, "%s: %s\n", key, error->message);
+			g_error_free(error);
+			return -1.0;
+		}
+		g_error_free(error);
+		val = defval;
+	}
+
+	if (val < 0.0)
+		fprintf(stderr, "%s: invalid value %g\n", key, val);
+
+	return val;
+}
+
+
+static
+int find_name(const char* const* names, int nname, const char* name)
+{
+	int i;
+
+	for (i = 0; i < nname; i++) {
+		if (!g_ascii_strcasecmp(names[i], name))
+			return i;
+	}
+
+	return -1;
+}
+
+
+static
+int parse_tabtypes(struct scenario* sc, GKeyFile* keyfile)
+{
+	gchar** names;
+	gsize i, nname;
+	int type;
+
+	sc->tabtypes = g_new0(enum tabtype, sc->ntab);
+
+	names = g_key_file_get_string_list(keyfile, SCENARIO_GROUP,
+	                                   "tab-types", &nname, NULL);
+	if (!names || !nname) {
+		g_strfreev(names);
+		return 0;
+	}
+
+	for (i = 0; i < nname; i++) {
+		type = find_name(tabtype_names, NELEM(tabtype_names),
+		                 g_strstrip(names[i]));
+		if (type < 0) {
+			fprintf(stderr, "tab-types: unknown type %s\n",
+			        names[i]);
+			g_strfreev(names);
+			return -1;
+		}
+	}
+
+	for (i = 0; (int)i < sc->ntab; i++)
+		sc->tabtypes[i] = find_name(tabtype_names,
+		                            NELEM(tabtype_names),
+		                            names[i % nname]);
+
+	g_strfreev(names);
+	return 0;
+}
+
+
+static
+int parse_scenario(struct scenario* sc, const char* filename)
+{
+	GKeyFile* keyfile;
+	GError* error = NULL;
+	gchar* policy;
+	int nch, fs, blksize, trigg_nch, policy_id, retval = -1;
+
+	keyfile = g_key_file_new();
+	if (!g_key_file_load_from_file(keyfile, filename,
+	                               G_KEY_FILE_NONE, &error)) {
+		fprintf(stderr, "%s: %s\n", filename, error->message);
+		g_error_free(error);
+		goto exit;
+	}
+
+	sc->duration = get_double_key(keyfile, "duration", 10.0);
+	nch = get_int_key(keyfile, "channels", 64, 1);
+	fs = get_int_key(keyfile, "sampling-rate", 2048, 1);
+	blksize = get_int_key(keyfile, "block-size", 32, 1);
+	sc->ntab = get_int_key(keyfile, "tabs", 3, 1);
+	sc->nsource = get_int_key(keyfile, "sources", sc->ntab, 1);
+	sc->nthread = get_int_key(keyfile, "producer-threads", 1, 1);
+	sc->event_rate = get_double_key(keyfile, "event-rate", 0.0);
+	trigg_nch = get_int_key(keyfile, "trigger-channels", 1, 0);
+	sc->trigg_density = get_double_key(keyfile, "trigger-density", 0.001);
+	sc->config = g_key_file_get_string(keyfile, SCENARIO_GROUP,
+	                                   "config", NULL);
+
+	if (sc->duration < 0.0 || nch < 0 || fs < 0 || blksize < 0
+	  || sc->ntab < 0 || sc->nsource < 0 || sc->nthread < 0
+	  || sc->event_rate < 0.0 || trigg_nch < 0
+	  || sc->trigg_density < 0.0)
+		goto exit;
+
+	sc->nch = nch;
+	sc->fs = fs;
+	sc->blksize = blksize;
+	sc->trigg_nch = trigg_nch;
+
+	// Tabs are assigned in turn to the sources: there cannot be more
+	// sources than tabs. A source must be fed by a single thread.
+	if (sc->nsource > sc->ntab) {
+		fprintf(stderr, "sources: more sources than tabs\n");
+		goto exit;
+	}
+	if (sc->nthread > sc->nsource) {
+		fprintf(stderr, "producer-threads: limited to the number "
+		                "of sources (%i)\n", sc->nsource);
+		sc->nthread = sc->nsource;
+	}
+
+	sc->policy = OVERFLOW_BLOCK;
+	policy = g_key_file_get_string(keyfile, SCENARIO_GROUP,
+	                               "overflow-policy", NULL);
+	if (policy) {
+		policy_id = find_name(policy_names, NELEM(policy_names),
+		                      g_strstrip(policy));
+		if (policy_id < 0) {
+			fprintf(stderr, "overflow-policy: unknown policy %s\n",
+			        policy);
+			g_free(policy);
+			goto exit;
+		}
+		sc->policy = policy_id;
+		g_free(policy);
+	}
+
+	retval = parse_tabtypes(sc, keyfile);
+
+exit:
+	g_key_file_free(keyfile);
+	return retval;
+}
+
+
+/**************************************************************************
+ *                                                                        *
+ *                         Load generation                                *
+ *                                                                        *
+ **************************************************************************/
+static
+void generate_source_data(struct source_load* src,
+                          const struct scenario* sc, GRand* rand)
+{
+	unsigned int i, j, ns = NPREGEN_BLOCK * sc->blksize;
+	double freq;
+
+	src->data = g_new(float, ns * sc->nch);
+	for (j = 0; j < sc->nch; j++) {
+		freq = 1.0 + j % 40;
+		for (i = 0; i < ns; i++)
+			src->data[i*sc->nch + j] =
+				50.0 * sin(2.0 * G_PI * freq * i / sc->fs)
+				+ g_rand_double_range(rand, -10.0, 10.0);
+	}
+}
+
+
+static
+void add_source_events(struct load_gen* gen, struct source_load* src,
+                       GRand* rand)
+{
+	const struct scenario* sc = &gen->sc;
+	struct mcp_event evt;
+	double mean_interval = sc->fs / sc->event_rate;
+	int tabid;
+
+	while (src->next_event < src->isample) {
+		evt.pos = src->next_event;
+		evt.type = g_rand_int_range(rand, 0, 8);
+
+		// Tabs of the source that do not display events ignore them
+		for (tabid = src->id; tabid < sc->ntab; tabid += sc->nsource)
+			mcp_add_events(gen->pan, tabid, 1, &evt);
+
+		src->next_event += mean_interval
+		                   * g_rand_double_range(rand, 0.5, 1.5);
+	}
+}
+
+
+static
+void submit_source_block(struct load_gen* gen, struct source_load* src,
+                         GRand* rand)
+{
+	const struct scenario* sc = &gen->sc;
+	const float* data;
+
+	data = src->data + src->iblk * sc->blksize * sc->nch;
+	src->iblk = (src->iblk + 1) % NPREGEN_BLOCK;
+
+	// Samples submitted to the first tab of a source apply to all the
+	// tabs of this source
+	mcp_add_samples(gen->pan, src->id, sc->blksize, data);
+	src->isample += sc->blksize;
+
+	if (sc->event_rate > 0.0)
+		add_source_events(gen, src, rand);
+}
+
+
+static
+void submit_triggers(struct load_gen* gen, struct producer* prod)
+{
+	const struct scenario* sc = &gen->sc;
+	unsigned int i, j;
+
+	for (i = 0; i < sc->blksize; i++) {
+		if (g_rand_double(prod->rand) < sc->trigg_density)
+			prod->trigg_val = g_rand_int_range(prod->rand, 0,
+			                                   1 << NTRIGG_LINE);
+		for (j = 0; j < sc->trigg_nch; j++)
+			prod->trigg[i*sc->trigg_nch + j] = prod->trigg_val;
+	}
+
+	mcp_add_triggers(gen->pan, sc->blksize, prod->trigg);
+}
+
+
+static
+gpointer producer_thread(gpointer data)
+{
+	struct producer* prod = data;
+	struct load_gen* gen = prod->gen;
+	const struct scenario* sc = &gen->sc;
+	gint64 period = (gint64)sc->blksize * G_USEC_PER_SEC / sc->fs;
+	gint64 iround, deadline, lag;
+	int i;
+
+	for (iround = 0; g_atomic_int_get(&gen->run); iround++) {
+		// A block is submitted once its last sample is acquired
+		deadline = gen->start_time + (iround + 1) * sc->blksize
+		                             * G_USEC_PER_SEC / sc->fs;
+		lag = deadline - g_get_monotonic_time();
+		if (lag > 0)
+			g_usleep(lag);
+
+		for (i = prod->id; i < sc->nsource; i += sc->nthread)
+			submit_source_block(gen, &gen->sources[i], prod->rand);
+
+		if (prod->trigg)
+			submit_triggers(gen, prod);
+
+		g_atomic_int_inc(&prod->nround);
+		lag = g_get_monotonic_time() - deadline;
+		if (lag > period)
+			g_atomic_int_inc(&prod->nlate);
+		if (lag > g_atomic_int_get(&prod->max_lag))
+			g_atomic_int_set(&prod->max_lag, MIN(lag, G_MAXINT));
+	}
+
+	return NULL;
+}
+
+
+static
+void define_inputs(struct load_gen* gen)
+{
+	const struct scenario* sc = &gen->sc;
+	const char** labels;
+	unsigned int i;
+	int tabid;
+
+	labels = g_new(const char*, MAX(sc->nch, sc->trigg_nch));
+	for (i = 0; i < MAX(sc->nch, sc->trigg_nch); i++)
+		labels[i] = g_strdup_printf("ch%u", i+1);
+
+	if (sc->trigg_nch)
+		mcp_define_trigg_input(gen->pan, NTRIGG_LINE, sc->trigg_nch,
+		                       sc->fs, labels);
+
+	// Tabs sharing a source share their input definition
+	for (tabid = 0; tabid < sc->nsource; tabid++)
+		mcp_define_tab_input(gen->pan, tabid, sc->nch, sc->fs, labels);
+
+	for (tabid = 0; tabid < sc->ntab; tabid++)
+		mcp_set_tab_overflow_policy(gen->pan, tabid, sc->policy);
+
+	for (i = 0; i < MAX(sc->nch, sc->trigg_nch); i++)
+		g_free((gchar*)labels[i]);
+	g_free(labels);
+}
+
+
+static
+void start_load(struct load_gen* gen)
+{
+	const struct scenario* sc = &gen->sc;
+	struct producer* prod;
+	GRand* rand;
+	int i;
+
+	rand = g_rand_new_with_seed(0);
+	gen->sources = g_new0(struct source_load, sc->nsource);
+	for (i = 0; i < sc->nsource; i++) {
+		gen->sources[i].id = i;
+		generate_source_data(&gen->sources[i], sc, rand);
+		if (sc->event_rate > 0.0)
+			gen->sources[i].next_event = sc->fs / sc->event_rate;
+	}
+	g_rand_free(rand);
+
+	define_inputs(gen);
+
+	gen->run = 1;
+	gen->start_time = g_get_monotonic_time();
+	gen->producers = g_new0(struct producer, sc->nthread);
+	for (i = 0; i < sc->nthread; i++) {
+		prod = &gen->producers[i];
+		prod->gen = gen;
+		prod->id = i;
+		prod->nsource = (sc->nsource - i + sc->nthread - 1)
+		                / sc->nthread;
+		prod->rand = g_rand_new_with_seed(i+1);
+
+		// The triggers are submitted with the samples of the first
+		// source
+		if (i == 0 && sc->trigg_nch)
+			prod->trigg = g_new(uint32_t,
+			                    sc->blksize * sc->trigg_nch);
+
+		prod->thread = g_thread_new(NULL, producer_thread, prod);
+	}
+}
+
+
+static
+void stop_load(struct load_gen* gen)
+{
+	int i;
+
+	g_atomic_int_set(&gen->run, 0);
+	for (i = 0; i < gen->sc.nthread; i++) {
+		g_thread_join(gen->producers[i].thread);
+		g_rand_free(gen->producers[i].rand);
+		g_free(gen->producers[i].trigg);
+	}
+
+	for (i = 0; i < gen->sc.nsource; i++)
+		g_free(gen->sources[i].data);
+}
+
+
+/**************************************************************************
+ *                                                                        *
+ *                              Report                                    *
+ *                                                                        *
+ **************************************************************************/
+static
+void take_snapshot(struct load_gen* gen, struct load_snapshot* snap,
+                   struct mcp_tab_stats* tabstats)
+{
+	const struct scenario* sc = &gen->sc;
+	struct producer* prod;
+	int i;
+
+	snap->time = g_get_monotonic_time();
+	snap->nsubmitted = 0;
+	snap->nlate = 0;
+	for (i = 0; i < sc->nthread; i++) {
+		prod = &gen->producers[i];
+		snap->nsubmitted += (guint64)g_atomic_int_get(&prod->nround)
+		                    * prod->nsource * sc->blksize * sc->nch;
+		snap->nlate += g_atomic_int_get(&prod->nlate);
+	}
+
+	mcp_get_stats(gen->pan, NULL, sc->ntab, tabstats);
+	snap->ndropped = 0;
+	for (i = 0; i < sc->ntab; i++)
+		snap->ndropped += tabstats[i].samples_dropped;
+}
+
+
+static
+void report_interval(struct load_gen* gen, struct load_snapshot* prev,
+                     struct mcp_tab_stats* tabstats)
+{
+	const struct scenario* sc = &gen->sc;
+	struct load_snapshot snap;
+	double dt, rate, expected;
+
+	take_snapshot(gen, &snap, tabstats);
+	dt = (snap.time - prev->time) / (double)G_USEC_PER_SEC;
+	rate = (snap.nsubmitted - prev->nsubmitted) / dt;
+	expected = (double)sc->nsource * sc->nch * sc->fs;
+
+	printf("%6.1fs  submitted %8.3f Msample/s (%3.0f%% of real time)  "
+	       "dropped %8lu  late blocks %5i  quality %s\n",
+	       (snap.time - gen->start_time) / (double)G_USEC_PER_SEC,
+	       rate * 1e-6, 100.0 * rate / expected,
+	       snap.ndropped - prev->ndropped, snap.nlate - prev->nlate,
+	       quality_names[mcp_get_quality_level(gen->pan)]);
+	fflush(stdout);
+
+	*prev = snap;
+}
+
+
+static
+int report_summary(struct load_gen* gen, struct mcp_tab_stats* tabstats)
+{
+	const struct scenario* sc = &gen->sc;
+	struct load_snapshot snap;
+	struct mcp_stats stats;
+	double elapsed, rate, expected;
+	gint max_lag = 0;
+	int i, sustained;
+
+	take_snapshot(gen, &snap, tabstats);
+	mcp_get_stats(gen->pan, &stats, 0, NULL);
+	elapsed = (snap.time - gen->start_time) / (double)G_USEC_PER_SEC;
+	rate = snap.nsubmitted / elapsed;
+	expected = (double)sc->nsource * sc->nch * sc->fs;
+	for (i = 0; i < sc->nthread; i++)
+		max_lag = MAX(max_lag, gen->producers[i].max_lag);
+
+	printf("\n%i tabs, %i sources of %u channels at %u Hz, "
+	       "blocks of %u samples, %i producer threads, %s policy\n",
+	       sc->ntab, sc->nsource, sc->nch, sc->fs, sc->blksize,
+	       sc->nthread, policy_names[sc->policy]);
+	printf("elapsed %.1f s, submitted %.3f Msample/s (%.1f%% of real "
+	       "time), late blocks %i, max lag %.1f ms\n",
+	       elapsed, rate * 1e-6, 100.0 * rate / expected,
+	       snap.nlate, max_lag * 1e-3);
+	printf("frame p99 %.1f ms, frame interval mean %.1f ms, "
+	       "quality %s, processing load %.2f\n\n",
+	       stats.frame.p99 * 1e-3, stats.frame_interval.mean * 1e-3,
+	       quality_names[mcp_get_quality_level(gen->pan)],
+	       stats.proc_load);
+
+	printf("tab  type      ingested   dropped  process p99  "
+	       "latency p99\n");
+	for (i = 0; i < sc->ntab; i++)
+		printf("%3i  %-8s %9lu %9lu %9.2f ms %9.1f ms\n", i,
+		       tabtype_names[sc->tabtypes[i]],
+		       tabstats[i].samples_ingested,
+		       tabstats[i].samples_dropped,
+		       tabstats[i].process.p99 * 1e-3,
+		       tabstats[i].latency.p99 * 1e-3);
+
+	// The load is sustained if the producers have kept up with real time
+	// and no sample has been discarded
+	sustained = (snap.nlate == 0 && snap.ndropped == 0);
+	printf("\n%s\n", sustained ? "load sustained" : "load NOT sustained");
+
+	return sustained;
+}
+
+
+/**************************************************************************
+ *                                                                        *
+ *                             Main program                               *
+ *                                                                        *
+ **************************************************************************/
+static
+int on_close(void* user_data)
+{
+	struct load_gen* gen = user_data;
+
+	g_atomic_int_set(&gen->run, 0);
+	return 1;
+}
+
+
+int main(int argc, char* argv[])
+{
+	struct load_gen gen = {.run = 0};
+	struct load_snapshot prev;
+	struct mcp_tab_stats* tabstats;
+	struct panel_tabconf* tabconf;
+	struct PanelCb cb = {.close_panel = on_close, .user_data = &gen};
+	gint64 end_time, next_report;
+	gdouble interval = 1.0;
+	GOptionContext* optctx;
+	GError* error = NULL;
+	GOptionEntry entries[] = {
+		{"interval", 'i', 0, G_OPTION_ARG_DOUBLE, &interval,
+		 "Report every SEC seconds (default 1)", "SEC"},
+		{NULL},
+	};
+	int i, sustained;
+
+	optctx = g_option_context_new("SCENARIO - generate a synthetic load "
+	                              "on a panel");
+	g_option_context_add_main_entries(optctx, entries, NULL);
+	if (!g_option_context_parse(optctx, &argc, &argv, &error)) {
+		fprintf(stderr, "%s\n", error->message);
+		return EXIT_FAILURE;
+	}
+	g_option_context_free(optctx);
+
+	if (argc != 2 || interval <= 0.0) {
+		fprintf(stderr, "usage: %s [-i SEC] SCENARIO\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (parse_scenario(&gen.sc, argv[1]))
+		return EXIT_FAILURE;
+
+	tabconf = g_new0(struct panel_tabconf, gen.sc.ntab);
+	for (i = 0; i < gen.sc.ntab; i++) {
+		tabconf[i].type = gen.sc.tabtypes[i];
+		tabconf[i].name = g_strdup_printf("%s %i",
+		                          tabtype_names[gen.sc.tabtypes[i]], i);
+		tabconf[i].source = g_strdup_printf("source%i",
+		                                    i % gen.sc.nsource);
+		if (tabconf[i].type == TABTYPE_BARGRAPH) {
+			tabconf[i].nscales = BAR_NSCALES;
+			tabconf[i].sclabels = bar_sclabels;
+			tabconf[i].scales = bar_scales;
+		}
+	}
+	cb.confname = gen.sc.config;
+
+	mcp_init_lib(&argc, &argv);
+	gen.pan = mcp_create(NULL, &cb, gen.sc.ntab, tabconf);
+	if (!gen.pan) {
+		fprintf(stderr, "error at the creation of the panel\n");
+		return EXIT_FAILURE;
+	}
+	mcp_show(gen.pan, 1);
+	mcp_run(gen.pan, 1);
+
+	tabstats = g_new0(struct mcp_tab_stats, gen.sc.ntab);
+	start_load(&gen);
+
+	// Report until the end of the scenario or the closing of the panel
+	end_time = gen.start_time + gen.sc.duration * G_USEC_PER_SEC;
+	next_report = gen.start_time;
+	take_snapshot(&gen, &prev, tabstats);
+	while (g_atomic_int_get(&gen.run)
+	       && next_report < end_time) {
+		next_report = MIN(next_report + interval * G_USEC_PER_SEC,
+		                  end_time);
+		g_usleep(MAX(next_report - g_get_monotonic_time(), 0));
+		report_interval(&gen, &prev, tabstats);
+	}
+
+	stop_load(&gen);
+	sustained = report_summary(&gen, tabstats);
+
+	mcp_destroy(gen.pan);
+
+	for (i = 0; i < gen.sc.ntab; i++) {
+		g_free((gchar*)tabconf[i].name);
+		g_free((gchar*)tabconf[i].source);
+	}
+	g_free(tabconf);
+	g_free(tabstats);
+	g_free(gen.producers);
+	g_free(gen.sources);
+	g_free(gen.sc.tabtypes);
+	g_free(gen.sc.config);
+
+	return sustained ? EXIT_SUCCESS : EXIT_FAILURE;
+}
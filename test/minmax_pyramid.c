@@ -0,0 +1,166 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pyramid.h"
+#include "unittest.h"
+
+/*
+ * Unit tests of the min/max pyramid: the range returned by a query must be
+ * exactly the one found by a scan of the samples, for any interval and
+ * any range of channels, including after partial updates of the buffer.
+ */
+
+#define NCH	5
+#define NQUERY	2000
+
+static
+void scan_minmax(const float* data, unsigned int ch0, unsigned int nqch,
+                 unsigned int first, unsigned int last, float* env)
+{
+	unsigned int i, j;
+	float v;
+
+	for (j = 0; j < nqch; j++) {
+		env[2*j] = env[2*j+1] = data[first*NCH + ch0 + j];
+		for (i = first+1; i <= last; i++) {
+			v = data[i*NCH + ch0 + j];
+			env[2*j] = MIN(env[2*j], v);
+			env[2*j+1] = MAX(env[2*j+1], v);
+		}
+	}
+}
+
+
+static
+void fill_random(float* data, unsigned int first, unsigned int last)
+{
+	unsigned int i;
+
+	for (i = first*NCH; i < (last+1)*NCH; i++)
+		data[i] = (float)rand() / RAND_MAX - 0.5f;
+}
+
+
+static
+int check_queries(const struct minmax_pyramid* pyr, const float* data,
+                  unsigned int ns)
+{
+	float env[2*NCH], ref[2*NCH];
+	unsigned int q, first, last, ch0, nqch;
+
+	for (q = 0; q < NQUERY; q++) {
+		first = rand() % ns;
+		last = first + rand() % (ns - first);
+		ch0 = rand() % NCH;
+		nqch = 1 + rand() % (NCH - ch0);
+
+		// Single sample, then whole buffer
+		if (q == 0)
+			last = first;
+		if (q == 1) {
+			first = 0;
+			last = ns-1;
+		}
+
+		scan_minmax(data, ch0, nqch, first, last, ref);
+		pyramid_query(pyr, data, NCH, ch0, nqch, first, last, env);
+		CHECK(memcmp(env, ref, 2*nqch*sizeof(*env)) == 0);
+	}
+
+	return 0;
+}
+
+
+static
+int test_query(void)
+{
+	static const unsigned int lengths[] = {1, 7, 8, 100, 1000, 1024, 3001};
+	struct minmax_pyramid pyr;
+	unsigned int i, ns;
+	float* data;
+
+	srand(42);
+	pyramid_init(&pyr);
+
+	for (i = 0; i < sizeof(lengths)/sizeof(lengths[0]); i++) {
+		ns = lengths[i];
+		data = g_malloc(ns*NCH*sizeof(*data));
+		fill_random(data, 0, ns-1);
+
+		pyramid_resize(&pyr, NCH, ns);
+		pyramid_update(&pyr, data, 0, ns-1);
+		CHECK(check_queries(&pyr, data, ns) == 0);
+
+		// Walk of the samples at full resolution
+		CHECK(check_queries(NULL, data, ns) == 0);
+
+		g_free(data);
+	}
+
+	pyramid_deinit(&pyr);
+	return 0;
+}
+
+
+static
+int test_partial_update(void)
+{
+	struct minmax_pyramid pyr;
+	unsigned int i, ns = 2000, first, len;
+	float* data;
+
+	srand(7);
+	data = g_malloc(ns*NCH*sizeof(*data));
+	fill_random(data, 0, ns-1);
+
+	pyramid_init(&pyr);
+	pyramid_resize(&pyr, NCH, ns);
+	pyramid_update(&pyr, data, 0, ns-1);
+
+	// Samples are rewritten by chunks, as the scope does
+	for (i = 0; i < 50; i++) {
+		first = rand() % ns;
+		len = 1 + rand() % MIN(ns - first, 64);
+		fill_random(data, first, first+len-1);
+		pyramid_update(&pyr, data, first, first+len-1);
+		CHECK(check_queries(&pyr, data, ns) == 0);
+	}
+
+	pyramid_deinit(&pyr);
+	g_free(data);
+	return 0;
+}
+
+
+static const struct unittest tests[] = {
+	{"query", test_query},
+	{"partial-update", test_partial_update},
+};
+
+
+int main(void)
+{
+	return run_unittests(tests, sizeof(tests)/sizeof(tests[0]));
+}
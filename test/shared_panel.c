@@ -0,0 +1,194 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#if HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdio.h>
+#include <mcpanel.h>
+#include <stdlib.h>
+#include <glib.h>
+
+/*
+ * Same acquisition as thread_panel.c, with the EEG tabs sharing a single
+ * source fed once per block, tabs refreshed at their own rate, and the
+ * options of the "shared" configuration: DSP worker pool, refresh rate of
+ * the panel, latency display and overflow policy of the sensors tab.
+ */
+
+#define NEEG	64
+#define NEXG	8
+#define SAMPLING_RATE	2048
+#define NSAMPLES	(SAMPLING_RATE / 33)
+#define NTRI    3
+
+GThread* thread_id;
+volatile int run_eeg = 0;
+
+#define BAR_NSCALES 2
+const char* bar_sclabels[BAR_NSCALES] = {"25 mV", "50 mV"};
+const float bar_scales[BAR_NSCALES] = {25.0e3, 50.0e3};
+
+struct panel_tabconf tabconf[] = {
+	{.type = TABTYPE_SCOPE, .name = "EEG", .source = "eeg"},
+	{.type = TABTYPE_BARGRAPH, .name = "EEG offsets",
+	 .nscales = BAR_NSCALES, .sclabels = bar_sclabels,
+	 .scales = bar_scales, .source = "eeg", .refresh_rate = 10.0f},
+	{.type = TABTYPE_SPECTRUM, .name = "EEG Spectrum", .source = "eeg",
+	 .refresh_rate = 5.0f},
+	{.type = TABTYPE_SCOPE, .name = "Sensors"},
+};
+#define NTAB	(sizeof(tabconf)/sizeof(tabconf[0]))
+
+static
+void set_signals(float* eeg, float* exg, uint32_t* tri, int nsamples)
+{
+	int i, j;
+	static uint32_t triggers;
+
+	for (i=0; i<nsamples; i++) {
+		for (j=0; j<NEEG; j++)
+			eeg[i*NEEG+j] = i + (j%2)*g_random_int_range(-20, 20);
+		for (j=0; j<NEXG; j++)
+			exg[i*NEXG+j] = j*i;
+		for (j=0; j<NTRI; j++)
+			tri[i*NTRI+j] = triggers << j;
+	}
+
+	triggers++;
+}
+
+#define UPDATE_DELAY	((NSAMPLES*1000)/SAMPLING_RATE)
+static
+gpointer reading_thread(gpointer arg)
+{
+	float *eeg, *exg;
+	uint32_t *tri;
+	mcpanel* panel = arg;
+
+	eeg = calloc(NEEG*NSAMPLES, sizeof(*eeg));
+	exg = calloc(NEXG*NSAMPLES, sizeof(*exg));
+	tri = calloc(NTRI*NSAMPLES, sizeof(*tri));
+
+	while(run_eeg) {
+		g_usleep(UPDATE_DELAY*1000);
+		set_signals(eeg, exg, tri, NSAMPLES);
+		// EEG tabs share the same source: samples pushed once
+		mcp_add_samples(panel, 0, NSAMPLES, eeg);
+		mcp_add_samples(panel, 3, NSAMPLES, exg);
+		mcp_add_triggers(panel, NSAMPLES, tri);
+	}
+
+	free(eeg);
+	free(exg);
+	free(tri);
+
+	return 0;
+}
+
+static
+int Connect(mcpanel* panel)
+{
+	int i;
+	const char* tri_lab[] = {"tri1", "tri2", "trigger:3"};
+	const char* eeg_lab[NEEG];
+	const char* exg_lab[NEXG];
+	char labels[NEEG+NEXG][8];
+
+	for (i=0; i<NEEG; i++) {
+		sprintf(labels[i], "EEG%i", i+1);
+		eeg_lab[i] = labels[i];
+	}
+	for (i=0; i<NEXG; i++) {
+		sprintf(labels[NEEG+i], "EXG%i", i+1);
+		exg_lab[i] = labels[NEEG+i];
+	}
+
+	run_eeg = 1;
+
+	// Defining the input of tab 0 defines the one of all EEG tabs
+	mcp_define_trigg_input(panel, 16, NTRI, SAMPLING_RATE, tri_lab);
+	mcp_define_tab_input(panel, 0, NEEG, SAMPLING_RATE, eeg_lab);
+	mcp_define_tab_input(panel, 3, NEXG, SAMPLING_RATE, exg_lab);
+
+	thread_id = g_thread_new(NULL, reading_thread, panel);
+
+	return 0;
+}
+
+static
+int Disconnect(mcpanel* panel)
+{
+	(void)panel;
+	run_eeg = 0;
+	g_thread_join(thread_id);
+
+	return 0;
+}
+
+static
+int SystemConnection(int start, void* user_data)
+{
+	mcpanel* panel = user_data;
+	int retval;
+
+	if (start)
+		retval = Connect(panel);
+	else
+		retval = Disconnect(panel);
+
+	return (retval < 0) ? 0 : 1;
+}
+
+static
+int ClosePanel(void* user_data)
+{
+	mcpanel* panel = user_data;
+
+	if (run_eeg)
+		Disconnect(panel);
+
+	return 1;
+}
+
+
+int main(int argc, char* argv[])
+{
+	mcpanel* panel;
+	struct PanelCb cb = {
+		.user_data = NULL,
+		.close_panel = ClosePanel,
+		.system_connection = SystemConnection,
+		.confname = "shared"
+	};
+
+	mcp_init_lib(&argc, &argv);
+
+	panel = mcp_create(NULL, &cb, NTAB, tabconf);
+	if (!panel) {
+		fprintf(stderr,"error at the creation of the panel\n");
+		return 1;
+	}
+
+	mcp_show(panel, 1);
+	mcp_run(panel, 0);
+
+	mcp_destroy(panel);
+
+	return 0;
+}
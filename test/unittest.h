@@ -0,0 +1,57 @@
+/*
+    Copyright (C) 2026  MindMaze Holdings SA
+
+    This file is part of the mcpanel library
+
+    The mcpanel library is free software: you can redistribute it and/or
+    modify it under the terms of the version 3 of the GNU General Public
+    License as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef UNITTEST_H
+#define UNITTEST_H
+
+#include <stdio.h>
+
+/* Minimal harness of the unit tests of the internal modules: each test
+ * case is a function returning 0 on success, and stops at the first
+ * failed check after reporting it. */
+
+#define CHECK(cond)							\
+do {									\
+	if (!(cond)) {							\
+		fprintf(stderr, "%s:%i: check failed: %s\n",		\
+		        __FILE__, __LINE__, #cond);			\
+		return -1;						\
+	}								\
+} while (0)
+
+struct unittest {
+	const char* name;
+	int (*run)(void);
+};
+
+static inline
+int run_unittests(const struct unittest* tests, int ntest)
+{
+	int i, nfail = 0;
+
+	for (i = 0; i < ntest; i++) {
+		if (tests[i].run()) {
+			fprintf(stderr, "FAIL: %s\n", tests[i].name);
+			nfail++;
+		} else
+			printf("PASS: %s\n", tests[i].name);
+	}
+
+	return nfail ? 1 : 0;
+}
+
+#endif /* UNITTEST_H */